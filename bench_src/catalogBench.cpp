@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DescriptorCatalog.hpp"
+
+static const size_t CATALOG_SIZE = 1000000;
+static const in_addr_t HOLDERS = 16;
+
+static Md5Hash makeHash(size_t i) {
+	char hex[33];
+	snprintf(hex, sizeof hex, "%016zx%016zx", (size_t) (i * 0x9e3779b97f4a7c15ull), i);
+	return Md5Hash(hex);
+}
+
+static FileDescriptor makeDescriptor(size_t i) {
+	FileDescriptor descriptor("file" + std::to_string(i), makeHash(i), 1000 + i % 1000);
+	descriptor.setHolderIp(i % HOLDERS);
+	descriptor.makeValid();
+	return descriptor;
+}
+
+template <typename Function>
+static double measureUs(size_t operations, Function function) {
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < operations; ++i) {
+		function(i);
+	}
+	std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / operations;
+}
+
+// cost of handling one descriptor message at CATALOG_SIZE descriptors:
+// linear scans over a vector (as the handlers used to do) against the indexed catalog
+int main() {
+	std::vector<FileDescriptor> vector;
+	DescriptorCatalog catalog;
+	for (size_t i = 0; i < CATALOG_SIZE; ++i) {
+		vector.push_back(makeDescriptor(i));
+		catalog.insert(vector.back());
+	}
+
+	const size_t vectorOperations = 20;
+	const size_t catalogOperations = 100000;
+
+	std::cout << "operation\tvector [us]\tcatalog [us]" << std::endl;
+
+	double vectorLookup = measureUs(vectorOperations, [&](size_t i) {
+		std::string name = "file" + std::to_string(i * 7919 % CATALOG_SIZE);
+		auto found = std::count_if(vector.begin(), vector.end(), [&name](const FileDescriptor &fd) {
+			return fd.getName() == name;
+		});
+		if (found != 1) {
+			abort();
+		}
+	});
+	double catalogLookup = measureUs(catalogOperations, [&](size_t i) {
+		if (catalog.countByName("file" + std::to_string(i * 7919 % CATALOG_SIZE)) != 1) {
+			abort();
+		}
+	});
+	std::cout << "GET_FILE by name\t" << vectorLookup << "\t" << catalogLookup << std::endl;
+
+	double vectorUpdate = measureUs(vectorOperations, [&](size_t i) {
+		FileDescriptor updated = makeDescriptor(i * 7919 % CATALOG_SIZE);
+		updated.setHolderIp((i + 1) % HOLDERS);
+		for (auto &&descriptor : vector) {
+			if (descriptor.getMd5() == updated.getMd5()) {
+				descriptor = updated;
+			}
+		}
+	});
+	double catalogUpdate = measureUs(catalogOperations, [&](size_t i) {
+		FileDescriptor updated = makeDescriptor(i * 7919 % CATALOG_SIZE);
+		updated.setHolderIp((i + 1) % HOLDERS);
+		catalog.upsert(updated);
+	});
+	std::cout << "UPDATE_DESCRIPTOR\t" << vectorUpdate << "\t" << catalogUpdate << std::endl;
+
+	double vectorRevoke = measureUs(vectorOperations, [&](size_t i) {
+		Md5Hash revoked = makeHash(i);
+		vector.erase(std::remove_if(vector.begin(), vector.end(), [&revoked](const FileDescriptor &fd) {
+			return fd.getMd5() == revoked;
+		}), vector.end());
+		vector.push_back(makeDescriptor(i));
+	});
+	double catalogRevoke = measureUs(catalogOperations, [&](size_t i) {
+		catalog.erase(makeHash(i));
+		catalog.insert(makeDescriptor(i));
+	});
+	std::cout << "REVOKE_FILE + NEW_FILE\t" << vectorRevoke << "\t" << catalogRevoke << std::endl;
+	return 0;
+}
@@ -0,0 +1,122 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/log/core.hpp>
+#include <boost/log/expressions.hpp>
+#include <boost/log/trivial.hpp>
+
+#include "DescriptorCodec.hpp"
+#include "ProtocolManager.hpp"
+#include "Thread.hpp"
+
+static const size_t CATALOG_SIZE = 100000;
+static const unsigned HANDLERS = 4;
+static const in_addr_t HOLDERS = 16;
+static const std::chrono::seconds DURATION(2);
+
+static Md5Hash makeHash(size_t i) {
+	char hex[33];
+	snprintf(hex, sizeof hex, "%016zx%016zx", (size_t) (i * 0x9e3779b97f4a7c15ull), i);
+	return Md5Hash(hex);
+}
+
+static FileDescriptor makeDescriptor(size_t i, in_addr_t holder) {
+	FileDescriptor descriptor("file" + std::to_string(i), makeHash(i), 1000 + i % 1000);
+	descriptor.setHolderIp(holder);
+	descriptor.makeValid();
+	return descriptor;
+}
+
+static std::atomic<bool> running;
+
+struct HandlerArgs {
+	unsigned id;
+	size_t operations;
+	double maxLatencyUs;
+};
+
+// UDP worker: UPDATE_DESCRIPTOR datagrams go through the same processor as the received ones
+static void *runHandler(void *arguments) {
+	HandlerArgs *args = (HandlerArgs *) arguments;
+	auto &process = p2p::util::msgProcessors.at(MessageType::UPDATE_DESCRIPTOR);
+	for (size_t i = args->id; running; i += HANDLERS) {
+		in_addr_t holder = (in_addr_t) (i % HOLDERS);
+		std::vector<uint8_t> datagram = DescriptorCodec::encode(makeDescriptor(i * 7919 % CATALOG_SIZE, holder));
+		auto start = std::chrono::steady_clock::now();
+		process(datagram.data(), (uint32_t) datagram.size(), holder);
+		std::chrono::duration<double, std::micro> latency = std::chrono::steady_clock::now() - start;
+		if (latency.count() > args->maxLatencyUs) {
+			args->maxLatencyUs = latency.count();
+		}
+		++args->operations;
+	}
+	return nullptr;
+}
+
+// handlers working while the user keeps listing the network files (saf), or alone
+static void measure(const char *label, bool listing) {
+	std::vector<HandlerArgs> args(HANDLERS);
+	std::vector<std::unique_ptr<Thread>> threads;
+	void *retval;
+	running = true;
+	for (unsigned i = 0; i < HANDLERS; ++i) {
+		args[i] = HandlerArgs{i, 0, 0};
+		threads.emplace_back(new Thread(runHandler, &args[i], &retval));
+	}
+
+	size_t listings = 0;
+	auto end = std::chrono::steady_clock::now() + DURATION;
+	while (std::chrono::steady_clock::now() < end) {
+		if (!listing) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			continue;
+		}
+		if (p2p::getNetworkFileDescriptors().size() != CATALOG_SIZE) {
+			abort();
+		}
+		++listings;
+	}
+	running = false;
+
+	size_t operations = 0;
+	double maxLatencyUs = 0;
+	for (unsigned i = 0; i < HANDLERS; ++i) {
+		threads[i]->get();
+		operations += args[i].operations;
+		maxLatencyUs = std::max(maxLatencyUs, args[i].maxLatencyUs);
+	}
+	std::cout << label << "\t" << operations / DURATION.count() << "\t" << maxLatencyUs
+	          << "\t" << listings / DURATION.count() << std::endl;
+}
+
+int main() {
+	using namespace p2p::util;
+	// handlers log every descriptor at the debug level
+	boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::warning);
+
+	tcpServer = std::make_shared<TcpServer>(&processTcpMsg, &processTcpError);
+	udpServer = std::make_shared<UdpServer>(&processUdpMsg);
+	placement = std::make_shared<RendezvousPlacement>();
+	initProcessingFunctions();
+
+	auto &newFile = msgProcessors.at(MessageType::NEW_FILE);
+	for (size_t i = 0; i < CATALOG_SIZE; ++i) {
+		in_addr_t holder = (in_addr_t) (i % HOLDERS);
+		std::vector<uint8_t> datagram = DescriptorCodec::encode(makeDescriptor(i, holder));
+		newFile(datagram.data(), (uint32_t) datagram.size(), holder);
+	}
+
+	std::cout << "UPDATE_DESCRIPTOR handlers\thandler ops/s\tmax latency [us]\tlistings/s" << std::endl;
+	measure("alone", false);
+	measure("with listing", true);
+
+	placement.reset();
+	udpServer.reset();
+	tcpServer.reset();
+	return 0;
+}
@@ -0,0 +1,69 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "FileLoader.hpp"
+#include "FileStorer.hpp"
+
+template <typename Function>
+static double measureMs(Function function) {
+	auto start = std::chrono::steady_clock::now();
+	function();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+static double throughput(uint64_t size, double ms) {
+	return size / ms / 1000;
+}
+
+int main() {
+	const std::string filename = "fileIoBench.bin";
+	const std::string copyName = "fileIoBench.copy";
+	const std::vector<uint64_t> sizes = {1024 * 1024, 100 * 1024 * 1024};
+
+	std::vector<uint8_t> chunk(FileLoader::CHUNK_SIZE);
+	for (size_t i = 0; i < chunk.size(); ++i) {
+		chunk[i] = (uint8_t) (i * 2654435761u >> 24);
+	}
+
+	std::cout << "size [B]\tstream write [MB/s]\tchunked read [MB/s]\tmapped copy [MB/s]" << std::endl;
+	for (uint64_t size : sizes) {
+		bool ok = true;
+		double writeMs = measureMs([&] {
+			FileStorer storer(filename);
+			ok = storer.beginStream();
+			storer.reserve(size);
+			for (uint64_t written = 0; ok && written < size; written += chunk.size()) {
+				ok = storer.append(chunk.data(), std::min<uint64_t>(chunk.size(), size - written));
+			}
+			ok = ok && storer.commit();
+		});
+
+		uint64_t readBytes = 0;
+		double readMs = measureMs([&] {
+			ok = ok && FileLoader(filename).readChunks([&readBytes](const uint8_t *, size_t chunkSize) {
+				readBytes += chunkSize;
+				return true;
+			});
+		});
+
+		double copyMs = measureMs([&] {
+			auto view = FileLoader(filename).map();
+			ok = ok && FileStorer(copyName).storeFile(view.data(), view.size());
+		});
+
+		unlink(filename.c_str());
+		unlink(copyName.c_str());
+		if (!ok || readBytes != size) {
+			std::cerr << "I/O failed for " << size << " bytes" << std::endl;
+			return 1;
+		}
+		std::cout << size << "\t" << throughput(size, writeMs) << "\t" << throughput(size, readMs)
+				  << "\t" << throughput(size, copyMs) << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,32 @@
+#include <chrono>
+#include <iostream>
+
+#include "Server.hpp"
+
+template <typename Function>
+static double measureNs(size_t operations, Function function) {
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < operations; ++i) {
+		function();
+	}
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / operations;
+}
+
+// cost of Server::getLocalhostIp() on the handlers' path: resolving the address each time
+// (as every call used to do) against reading the cached one
+int main() {
+	volatile in_addr_t sink = Server::getLocalhostIp();
+
+	double resolved = measureNs(2000, [&sink]() {
+		Server::refreshLocalhostIp();
+		sink = Server::getLocalhostIp();
+	});
+	double cached = measureNs(10000000, [&sink]() {
+		sink = Server::getLocalhostIp();
+	});
+
+	std::cout << "resolved [ns]\tcached [ns]" << std::endl;
+	std::cout << resolved << "\t" << cached << std::endl;
+	return 0;
+}
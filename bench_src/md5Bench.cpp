@@ -0,0 +1,59 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "Md5sum.hpp"
+
+// hashing the way Md5sum did it before the in-process implementation
+static std::string popenMd5(const std::string &filename) {
+	char buffer[64] = {0};
+	std::string cmd = "md5sum -b " + filename;
+	FILE *fp = popen(cmd.c_str(), "r");
+	if (fscanf(fp, "%32s", buffer) != 1) {
+		buffer[0] = 0;
+	}
+	pclose(fp);
+	return buffer;
+}
+
+template <typename Function>
+static double measureMs(int repetitions, Function function) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < repetitions; ++i) {
+		function();
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / repetitions;
+}
+
+int main() {
+	const std::string filename = "md5Bench.bin";
+	const std::vector<size_t> sizes = {1024, 1024 * 1024, 64 * 1024 * 1024};
+
+	std::cout << "size [B]\tin-process [ms]\tpopen [ms]\tMB/s (in-process)" << std::endl;
+	for (size_t size : sizes) {
+		std::vector<char> content(size);
+		for (size_t i = 0; i < size; ++i) {
+			content[i] = (char) (i * 2654435761u >> 24);
+		}
+		std::ofstream(filename, std::ios_base::binary).write(content.data(), content.size());
+
+		int repetitions = size > 1024 * 1024 ? 3 : 50;
+		std::string nativeHash, popenHash;
+		double nativeMs = measureMs(repetitions, [&] { nativeHash = Md5sum(filename).getMd5Hash().getHash(); });
+		double popenMs = measureMs(repetitions, [&] { popenHash = popenMd5(filename); });
+
+		if (nativeHash != popenHash) {
+			std::cerr << "digests differ for " << size << " bytes: " << nativeHash << " vs " << popenHash << std::endl;
+			unlink(filename.c_str());
+			return 1;
+		}
+		std::cout << size << "\t" << nativeMs << "\t" << popenMs << "\t" << size / nativeMs / 1000 << std::endl;
+	}
+	unlink(filename.c_str());
+	return 0;
+}
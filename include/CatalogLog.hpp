@@ -0,0 +1,62 @@
+#ifndef TIN_P2P_CATALOGLOG_HPP
+#define TIN_P2P_CATALOGLOG_HPP
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "FileDescriptor.hpp"
+
+/// Numbered changes of the descriptors held by this node. Other nodes remember the version they have
+/// seen and on join ask only for the later changes. Epoch is drawn when the log is created,
+/// so the versions of a restarted node never match the old ones.
+/// Only the last changes are kept - older versions get the whole catalog.
+/// Not synchronized - guarded by p2p::util::mutex together with the local descriptors.
+class CatalogLog {
+public:
+    static const size_t DEFAULT_CAPACITY = 4096;
+
+    struct Version {
+        uint64_t epoch;
+        uint64_t sequence;
+    };
+
+    explicit CatalogLog(size_t capacity = DEFAULT_CAPACITY);
+    CatalogLog(size_t capacity, uint64_t epoch);
+
+    // descriptor added or changed
+    void put(const FileDescriptor &descriptor);
+    void remove(const FileDescriptor &descriptor);
+
+    Version getVersion() const;
+    // last change of every descriptor changed after the version;
+    // false if the version comes from other epoch or the log does not reach back that far
+    bool getChangesSince(const Version &since, std::vector<FileDescriptor> &put,
+                         std::vector<FileDescriptor> &removed) const;
+
+    // appends the epoch, the sequence and the kept changes, so the log can outlive the process
+    void encode(std::vector<uint8_t> &output) const;
+    // restores the log encoded at the data, which is moved past it; false if malformed, the log is not changed then
+    bool decode(const uint8_t *&data, const uint8_t *end);
+
+    // independent of the order of the descriptors
+    static uint64_t digest(const std::vector<FileDescriptor> &descriptors);
+    // state of a single descriptor; digest of the list is XOR of these
+    static uint64_t digest(const FileDescriptor &descriptor);
+
+private:
+    struct Change {
+        uint64_t sequence;
+        bool removed;
+        FileDescriptor descriptor;
+    };
+
+    void append(const FileDescriptor &descriptor, bool removed);
+
+    size_t capacity;
+    uint64_t epoch;
+    uint64_t sequence = 0;
+    std::deque<Change> changes;
+};
+
+
+#endif //TIN_P2P_CATALOGLOG_HPP
@@ -0,0 +1,27 @@
+#ifndef TIN_P2P_CATALOGSTATE_HPP
+#define TIN_P2P_CATALOGSTATE_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <netinet/in.h>
+#include "CatalogLog.hpp"
+#include "FileDescriptor.hpp"
+
+/// What the node knows about the catalogs when it leaves, kept in a file next to the stored ones:
+/// the log of its own changes, so the peers remembering its version still get only the later changes,
+/// and the versions and descriptors of the peers' catalogs, so after a restart HELLO asks them
+/// only for the changes since. Peer catalogs are trusted only once their holders confirm the digest.
+struct CatalogState {
+    CatalogLog log;
+    std::unordered_map<in_addr_t, CatalogLog::Version> peerVersions;
+    std::unordered_map<in_addr_t, std::vector<FileDescriptor>> peerCatalogs;
+
+    // the file is replaced only if everything has been written
+    bool save(const std::string &filename) const;
+    // false if there is no state or it is malformed; nothing is changed then
+    bool load(const std::string &filename);
+};
+
+
+#endif //TIN_P2P_CATALOGSTATE_HPP
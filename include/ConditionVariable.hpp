@@ -0,0 +1,22 @@
+#include <pthread.h>
+#include "Mutex.hpp"
+
+#ifndef INCLUDE_CONDITIONVARIABLE_HPP_
+#define INCLUDE_CONDITIONVARIABLE_HPP_
+
+
+class ConditionVariable {
+	pthread_cond_t condition;
+
+public:
+	ConditionVariable();
+	// mutex has to be locked by the caller
+	void wait(Mutex&);
+	// returns false on timeout
+	bool waitFor(Mutex&, long milliseconds);
+	void notifyOne();
+	void notifyAll();
+	~ConditionVariable();
+};
+
+#endif /* INCLUDE_CONDITIONVARIABLE_HPP_ */
@@ -0,0 +1,42 @@
+#ifndef TIN_P2P_DESCRIPTORBATCHER_HPP
+#define TIN_P2P_DESCRIPTORBATCHER_HPP
+
+#include <functional>
+#include <vector>
+#include "FileDescriptor.hpp"
+#include "Thread.hpp"
+#include "Mutex.hpp"
+#include "Guard.hpp"
+#include "ConditionVariable.hpp"
+
+/// Collects descriptors published one by one (e.g. UPDATE_DESCRIPTOR after every received
+/// HOLDER_CHANGE) and publishes them in batches: as soon as a batch is full,
+/// or when the linger time after the first queued descriptor passes. Batch never exceeds batchSize.
+class DescriptorBatcher {
+public:
+    typedef std::function<void(std::vector<FileDescriptor> &&)> Publisher;
+
+    DescriptorBatcher(Publisher publisher, size_t batchSize, long lingerMs);
+
+    void add(const FileDescriptor &descriptor);
+
+    // publishes descriptors which are still queued
+    ~DescriptorBatcher();
+
+private:
+    static void *runHelper(void *batcher);
+    void run();
+
+    Publisher publisher;
+    size_t batchSize;
+    long lingerMs;
+
+    Mutex mutex;
+    ConditionVariable changed;
+    std::vector<FileDescriptor> pending;
+    bool stopping;
+    Thread *thread;
+};
+
+
+#endif //TIN_P2P_DESCRIPTORBATCHER_HPP
@@ -0,0 +1,79 @@
+#ifndef TIN_P2P_DESCRIPTORCATALOG_HPP
+#define TIN_P2P_DESCRIPTORCATALOG_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <netinet/in.h>
+#include "FileDescriptor.hpp"
+#include "Md5hash.hpp"
+#include "NodeLoadTable.hpp"
+
+/// Descriptors of the files present in the network, one per digest.
+/// Descriptors are kept in a vector, so iterating is cheap; indexes by digest, name and holder
+/// give O(1) lookups, inserts and erases (erased descriptor is replaced by the last one).
+/// Loads of the holders are kept up to date in the NodeLoadTable, which may be shared with other catalogs.
+/// Not synchronized - see ShardedCatalog; only getSnapshot() may be called concurrently with the writer.
+class DescriptorCatalog {
+public:
+    typedef std::vector<FileDescriptor>::const_iterator const_iterator;
+    // immutable copy of the descriptors, shared by the readers until the next one is published
+    typedef std::shared_ptr<const std::vector<FileDescriptor>> Snapshot;
+
+    explicit DescriptorCatalog(NodeLoadTable *sharedLoads = nullptr);
+    DescriptorCatalog(const DescriptorCatalog &) = delete;
+    DescriptorCatalog &operator=(const DescriptorCatalog &) = delete;
+
+    // false if a descriptor with the same digest is already present
+    bool insert(const FileDescriptor &descriptor);
+    // inserts the descriptor or replaces the one with the same digest
+    void upsert(const FileDescriptor &descriptor);
+    bool erase(const Md5Hash &hash);
+    void clear();
+
+    // nullptr if not present; pointer is valid until the catalog is changed
+    const FileDescriptor *find(const Md5Hash &hash) const;
+    std::vector<FileDescriptor> findByName(const std::string &name) const;
+    size_t countByName(const std::string &name) const;
+    std::vector<FileDescriptor> findByHolder(in_addr_t holder) const;
+
+    // false if the descriptor is not present
+    bool setValid(const Md5Hash &hash, bool valid);
+    // returns number of affected descriptors
+    size_t invalidateHolder(in_addr_t holder);
+    size_t eraseHolder(in_addr_t holder);
+
+    size_t size() const;
+    bool empty() const;
+    const_iterator begin() const;
+    const_iterator end() const;
+    const std::vector<FileDescriptor> &getAll() const;
+    // writer copies the descriptors for the readers, only if they have changed since the previous publish()
+    void publish();
+    // the last published copy; lock-free, does not wait for the writer
+    Snapshot getSnapshot() const;
+
+    // nodes without files are registered directly in the table
+    NodeLoadTable &getLoads();
+    const NodeLoadTable &getLoads() const;
+
+private:
+    void index(size_t position);
+    void unindex(size_t position);
+    void markChanged();
+
+    std::vector<FileDescriptor> descriptors;
+    std::unordered_map<Md5Hash, size_t> byDigest;
+    std::unordered_map<std::string, std::unordered_set<Md5Hash>> byName;
+    std::unordered_map<in_addr_t, std::unordered_set<Md5Hash>> byHolder;
+    NodeLoadTable ownLoads;
+    NodeLoadTable *loads;
+    // accessed only with std::atomic_load and std::atomic_store
+    Snapshot snapshot;
+    bool changed;
+};
+
+
+#endif //TIN_P2P_DESCRIPTORCATALOG_HPP
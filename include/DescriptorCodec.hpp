@@ -0,0 +1,39 @@
+#ifndef INCLUDE_DESCRIPTORCODEC_HPP_
+#define INCLUDE_DESCRIPTORCODEC_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "FileDescriptor.hpp"
+
+/// Wire format of FileDescriptor.
+/// Every descriptor is a record prefixed with its length (varint), so lists of descriptors
+/// and descriptors followed by file content can be split without knowing the record layout:
+///   version (1 byte), MD5 digest (16 bytes), flags (1 byte, bit 0 - valid),
+///   size (varint), upload time (zigzag varint), owner IP (4 bytes), holder IP (4 bytes),
+///   name length (varint), name.
+/// Fields added by the next versions go at the end of the record and are skipped by older nodes.
+class DescriptorCodec {
+public:
+	static const uint8_t VERSION = 1;
+	static const size_t DIGEST_SIZE = MD5_DIGEST_SIZE;
+	// biggest possible record together with its length prefix
+	static const size_t MAX_ENCODED_SIZE = 2 + 1 + DIGEST_SIZE + 1 + 5 + 10 + 8 + 2 + MAX_FILENAME_LEN;
+
+	// appends encoded descriptor to the output
+	static void encode(const FileDescriptor &descriptor, std::vector<uint8_t> &output);
+	static std::vector<uint8_t> encode(const FileDescriptor &descriptor);
+	static std::vector<uint8_t> encode(const std::vector<FileDescriptor> &descriptors);
+
+	// returns number of consumed bytes, or 0 if data does not start with a complete, valid record
+	static size_t decode(const uint8_t *data, size_t size, FileDescriptor &descriptor);
+	// decodes list of records filling the whole data; false if any of them is malformed
+	static bool decode(const uint8_t *data, size_t size, std::vector<FileDescriptor> &descriptors);
+
+private:
+	static void putVarint(uint64_t value, std::vector<uint8_t> &output);
+	static bool getVarint(const uint8_t *&data, const uint8_t *end, uint64_t &value);
+};
+
+
+#endif /* INCLUDE_DESCRIPTORCODEC_HPP_ */
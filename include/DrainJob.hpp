@@ -0,0 +1,75 @@
+#ifndef TIN_P2P_DRAINJOB_HPP
+#define TIN_P2P_DRAINJOB_HPP
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "Mutex.hpp"
+#include "ConditionVariable.hpp"
+#include "RebalancePlanner.hpp"
+
+/// Evacuation of the files of a leaving node. Transfers run in parallel, but at most `concurrency` of them
+/// wait for their confirmations (UPDATE_DESCRIPTOR from the new holder) at once. A transfer which is not
+/// confirmed in time, or whose target leaves, goes to the target given by the retargeter; after
+/// MAX_ATTEMPTS the file is given up. Synchronized; the callbacks are called without the lock.
+class DrainJob {
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef RebalancePlanner::Move Move;
+
+    // starts the transfer of the file
+    typedef std::function<void(const Move &)> Sender;
+    // new target for the failed transfer, INADDR_NONE if there is none
+    typedef std::function<in_addr_t(const Move &)> Retargeter;
+
+    struct Progress {
+        size_t totalFiles;
+        size_t confirmedFiles;
+        size_t failedFiles;
+        uint64_t totalBytes;
+        uint64_t confirmedBytes;
+    };
+    typedef std::function<void(const Progress &)> Reporter;
+
+    static const unsigned MAX_ATTEMPTS = 3;
+
+    // transfer of size bytes has to be confirmed in timeoutMs plus the time it takes at minBytesPerSecond
+    DrainJob(std::vector<Move> moves, size_t concurrency, long timeoutMs, uint64_t minBytesPerSecond);
+
+    // file has been taken over by some node, possibly by a target it has been retargeted from;
+    // false if the file was not expected
+    bool confirm(const Md5Hash &hash);
+    // node is gone - its unconfirmed transfers are retargeted right away
+    void failNode(in_addr_t node);
+
+    // runs the transfers in the calling thread until all of them are confirmed or given up;
+    // progress is reported at most every reportPeriodMs and once at the end
+    Progress run(const Sender &send, const Retargeter &retarget, const Reporter &report, long reportPeriodMs);
+    Progress getProgress() const;
+
+private:
+    struct Transfer {
+        Move move;
+        unsigned attempts;
+        Clock::time_point deadline;
+    };
+
+    Clock::time_point getDeadline(const Move &move, Clock::time_point now) const;
+
+    size_t concurrency;
+    Clock::duration timeout;
+    uint64_t minBytesPerSecond;
+
+    mutable Mutex mutex;
+    ConditionVariable changed;
+    std::deque<Transfer> waiting;
+    std::unordered_map<Md5Hash, Transfer> inFlight;
+    // failed transfers which have to be retargeted
+    std::vector<Transfer> failed;
+    Progress progress;
+};
+
+
+#endif //TIN_P2P_DRAINJOB_HPP
@@ -15,6 +15,9 @@
 #include <netinet/in.h>
 
 const size_t MAX_FILENAME_LEN = 255;
+// sizes of files are kept in 32 bits, like the size of the frame which also carries the descriptor
+// and the range offset before the content; bigger files are refused when loaded or decoded
+const uint64_t MAX_FILE_SIZE = UINT32_MAX - 1024;
 
 
 /// File descriptor class.
@@ -24,6 +27,8 @@ class FileDescriptor {
 public:
 	explicit FileDescriptor() = default;
 	explicit FileDescriptor(const std::string& filename);
+	// describes a file without reading it
+	FileDescriptor(const std::string& filename, const Md5Hash& md5, uint32_t size);
 
 	FileDescriptor(const FileDescriptor &other);
 
@@ -44,6 +49,8 @@ public:
     FileDescriptor &operator=(const FileDescriptor &other);
 
 private:
+	friend class DescriptorCodec;
+
 	static uint32_t obtainFileSize(const char* fn);
 	void setName(std::string filename);
 
@@ -53,7 +60,7 @@ private:
 	time_t uploadTime{};
 	in_addr_t ownerIp{};
 	in_addr_t holderIp{};
-	bool valid;
+	bool valid{};
 };
 
 
@@ -4,18 +4,41 @@
 #include "Md5sum.hpp"
 #include "Md5hash.hpp"
 #include <string>
-#include <sstream>
 #include <vector>
-#include <fstream>
-#include <streambuf>
+#include <functional>
 #include <utility>
 
+/// Read-only access to a file: whole content, memory-mapped view or consecutive chunks.
+/// Content is returned byte for byte, nothing is appended to it.
 class FileLoader {
     std::string filename;
 public:
+    // read-only mapping of the whole file, unmapped in the destructor
+    class View {
+        void *address;
+        size_t length;
+    public:
+        View(void *address, size_t length);
+        View(View &&other) noexcept;
+        View(const View &) = delete;
+        View &operator=(const View &) = delete;
+        ~View();
+
+        const uint8_t *data() const;
+        size_t size() const;
+    };
+
+    // called for the consecutive parts of the file; returning false stops reading
+    typedef std::function<bool(const uint8_t *data, size_t size)> ChunkConsumer;
+    static const size_t CHUNK_SIZE = 1024 * 1024;
+
     explicit FileLoader(std::string file);
 
+    // throws std::runtime_error if the file cannot be read
     std::vector<uint8_t> getContent();
+    View map();
+    // false if reading failed or consumer stopped it
+    bool readChunks(const ChunkConsumer &consumer, size_t chunkSize = CHUNK_SIZE);
 };
 
 
@@ -0,0 +1,64 @@
+#ifndef TIN_P2P_FILERECEIVER_HPP
+#define TIN_P2P_FILERECEIVER_HPP
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include "IncomingStream.hpp"
+#include "FileDescriptor.hpp"
+#include "DescriptorCodec.hpp"
+#include "FileStorer.hpp"
+#include "MessageType.hpp"
+
+/// Stream receiving a message made of the file descriptor followed by the file content
+/// (UPLOAD_FILE, HOLDER_CHANGE, FILE_TRANSFER). Content is written through a temporary file
+/// into the store, so only one chunk of the file is kept in memory. Its MD5 is computed on the way,
+/// and the file is moved into the store only if the digest matches the descriptor.
+/// FILE_TRANSFER carries a range of the file (its offset and length follow the descriptor). Length 0 stands
+/// for the rest of the file: it is written into the partial file, which becomes the requested file once it is
+/// complete. Other ranges are partial reads, saved under getRangeFileName() once they have arrived whole.
+class FileReceiver : public IncomingStream {
+public:
+    // called by the worker thread once the whole message has been received;
+    // stored is false if the content could not be written, its hash differs from the descriptor
+    // or the connection broke; also if a range has not been received whole - its part is kept for the next request
+    typedef std::function<void(FileDescriptor &, bool stored, in_addr_t)> Completion;
+
+    FileReceiver(MessageType type, in_addr_t source, Completion completion);
+
+    // <name>.<offset>-<end> - where a partial read of the file is saved
+    static std::string getRangeFileName(const std::string &name, uint64_t offset, uint64_t length);
+
+    void consume(const uint8_t *data, uint32_t size) override;
+    void finish(bool complete) override;
+
+private:
+    // descriptor record, the range offset and length
+    static const size_t MAX_HEADER_SIZE = DescriptorCodec::MAX_ENCODED_SIZE + 2 * sizeof(uint64_t);
+
+    // returns size of the header, or 0 if it has not been received yet
+    size_t parseHeader();
+    bool isRanged() const;
+    // range which does not reach the end of the whole download
+    bool isPartialRead() const;
+    std::string getStoredFileName() const;
+
+    MessageType messageType;
+    in_addr_t sourceAddress;
+    Completion completion;
+
+    FileDescriptor descriptor;
+    // encoded descriptor has variable length - bytes are collected until it can be decoded
+    std::vector<uint8_t> headerBytes;
+    bool headerRead;
+    uint64_t rangeOffset;
+    uint64_t rangeLength;
+    uint64_t contentReceived;
+    std::unique_ptr<FileStorer> storer;
+    bool failed;
+};
+
+
+#endif //TIN_P2P_FILERECEIVER_HPP
@@ -5,7 +5,14 @@
 #include <utility>
 #include <string>
 #include <vector>
-#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cerrno>
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+#include <linux/falloc.h>
+#include <sys/stat.h>
 #include "Md5hash.hpp"
 #include "Md5sum.hpp"
 
@@ -15,10 +22,139 @@ public:
             : filename(std::move(name))
     { }
 
-    void storeFile(const std::vector<uint8_t> &content) {
-        std::ofstream file(filename, std::ios_base::out);
-        file << (char*)content.data();
-        file.close();
+    FileStorer(const FileStorer &) = delete;
+    FileStorer &operator=(const FileStorer &) = delete;
+
+    ~FileStorer() {
+        abort();
+    }
+
+    // writes the whole content at once; the file is replaced only if everything has been written
+    bool storeFile(const uint8_t *data, size_t size) {
+        if (!beginStream()) {
+            return false;
+        }
+        reserve(size);
+        if (!append(data, size)) {
+            abort();
+            return false;
+        }
+        return commit();
+    }
+
+    bool storeFile(const std::vector<uint8_t> &content) {
+        return storeFile(content.data(), content.size());
+    }
+
+    // streamed content goes to a temporary file next to the target one
+    // and appears under the target name only after commit().
+    // Its MD5 is computed while it is written, see getStreamHash()
+    bool beginStream() {
+        streamDigest = Md5sum();
+        tempFilename = filename + ".XXXXXX";
+        tempFd = mkstemp(&tempFilename[0]);
+        if (tempFd == -1) {
+            return false;
+        }
+        fchmod(tempFd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        return true;
+    }
+
+    // continues the interrupted download kept in the partial file (name.part):
+    // content from offset onwards is replaced by the streamed one.
+    // Fails if the partial file is shorter than offset
+    bool resumeStream(uint64_t offset) {
+        streamDigest = Md5sum();
+        tempFilename = getPartialFilename();
+        tempFd = open(tempFilename.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        struct stat partialStat;
+        if (tempFd == -1 || fstat(tempFd, &partialStat) == -1 || (uint64_t) partialStat.st_size < offset
+            || ftruncate(tempFd, offset) == -1 || !hashKeptContent(offset)) {
+            suspend();
+            return false;
+        }
+        return true;
+    }
+
+    // size of the content already downloaded into the partial file
+    uint64_t getPartialSize() const {
+        struct stat partialStat;
+        if (stat(getPartialFilename().c_str(), &partialStat) == -1) {
+            return 0;
+        }
+        return partialStat.st_size;
+    }
+
+    std::string getPartialFilename() const {
+        return filename + ".part";
+    }
+
+    // allocates disk space for the expected rest of the stream, so big files are not fragmented;
+    // size of the file is not changed
+    void reserve(uint64_t size) {
+        struct stat tempStat;
+        if (size > 0 && fstat(tempFd, &tempStat) == 0) {
+            // not every filesystem supports it - then blocks are allocated while writing
+            fallocate(tempFd, FALLOC_FL_KEEP_SIZE, tempStat.st_size, size);
+        }
+    }
+
+    bool append(const uint8_t *data, size_t size) {
+        while (size > 0) {
+            ssize_t written = write(tempFd, data, size);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+            streamDigest.update(data, written);
+            data += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    // digest of everything written into the stream
+    Md5Hash getStreamHash() {
+        return streamDigest.finish();
+    }
+
+    bool commit() {
+        bool closed = close(tempFd) == 0;
+        tempFd = -1;
+        if (!closed || rename(tempFilename.c_str(), filename.c_str()) != 0) {
+            unlink(tempFilename.c_str());
+            return false;
+        }
+        tempFilename.clear();
+        return true;
+    }
+
+    // drops the streamed content
+    void abort() {
+        if (tempFd != -1) {
+            close(tempFd);
+            tempFd = -1;
+        }
+        if (!tempFilename.empty()) {
+            unlink(tempFilename.c_str());
+            tempFilename.clear();
+        }
+    }
+
+    // stops streaming, but leaves the received content for resumeStream()
+    void suspend() {
+        if (tempFd != -1) {
+            close(tempFd);
+            tempFd = -1;
+        }
+        tempFilename.clear();
+    }
+
+    // file which receives the streamed content until commit()
+    const std::string &getStreamFilename() const {
+        return tempFilename;
     }
 
     Md5Hash getHash() const {
@@ -26,7 +162,27 @@ public:
     }
 
 private:
+    // content received before the stream was suspended is hashed once, leaving the file offset at its end
+    bool hashKeptContent(uint64_t size) {
+        std::vector<uint8_t> block(std::min<uint64_t>(size, 1024 * 1024));
+        while (size > 0) {
+            ssize_t bytesRead = read(tempFd, block.data(), std::min<uint64_t>(size, block.size()));
+            if (bytesRead < 0 && errno == EINTR) {
+                continue;
+            }
+            if (bytesRead <= 0) {
+                return false;
+            }
+            streamDigest.update(block.data(), bytesRead);
+            size -= bytesRead;
+        }
+        return true;
+    }
+
     std::string filename;
+    std::string tempFilename;
+    int tempFd = -1;
+    Md5sum streamDigest;
 };
 
 
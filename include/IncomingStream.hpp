@@ -0,0 +1,33 @@
+#ifndef INCLUDE_INCOMING_STREAM_HPP_
+#define INCLUDE_INCOMING_STREAM_HPP_
+
+#include <cstdint>
+#include <arpa/inet.h>
+
+#include "P2PMessage.hpp"
+
+// biggest piece of the streamed payload held in memory at once
+const uint32_t STREAM_CHUNK_SIZE = 64 * 1024;
+
+/// Receiver of the TCP frame payload which is too big to be buffered as a whole.
+/// Payload is passed to it piece by piece as it arrives from the socket.
+class IncomingStream
+{
+public:
+	// next piece of the payload, not bigger than STREAM_CHUNK_SIZE;
+	// called from the receiving thread
+	virtual void consume(const uint8_t* data, uint32_t size) = 0;
+	// called once, by the worker thread after the whole payload has been consumed (complete)
+	// or by the receiving thread when the connection broke in the middle of it;
+	// the stream is deleted afterwards
+	virtual void finish(bool complete) = 0;
+	virtual ~IncomingStream() {}
+};
+
+// decides, basing on the frame header, if the payload is streamed;
+// returns nullptr for frames which should be delivered whole to the react callback
+typedef IncomingStream* (*StreamFactory)(const P2PMessage& header, in_addr_t senderAddr);
+
+
+
+#endif /* INCLUDE_INCOMING_STREAM_HPP_ */
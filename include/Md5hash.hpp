@@ -2,54 +2,95 @@
 #define INCLUDE_MD5HASH_HPP_
 
 #include <string>
-#include <cassert>
+#include <cstdint>
 #include <cstring>
-#include <cstdio>
-#include <array>
+#include <cstddef>
+#include <functional>
 
 
 static const int MD5_HASH_LENGTH = 32;
+static const int MD5_DIGEST_SIZE = 16;
 
+/// MD5 digest kept as raw bytes. Copying, comparing and hashing do not allocate;
+/// hex form is produced only for file names, logs and the user interface.
 class Md5Hash {
-	char hash[MD5_HASH_LENGTH + 1] = {0};
+	uint8_t digest[MD5_DIGEST_SIZE] = {0};
+
+	static int hexValue(char digit) {
+		if (digit >= '0' && digit <= '9') {
+			return digit - '0';
+		}
+		if (digit >= 'a' && digit <= 'f') {
+			return digit - 'a' + 10;
+		}
+		if (digit >= 'A' && digit <= 'F') {
+			return digit - 'A' + 10;
+		}
+		return 0;
+	}
+
+	uint64_t word(int index) const {
+		uint64_t value;
+		memcpy(&value, digest + index * sizeof value, sizeof value);
+		return value;
+	}
 
 public:
 	Md5Hash() = default;
-    Md5Hash(const Md5Hash &other) {
-		auto otherName = other.getHash();
-		std::copy(otherName.begin(), otherName.end(), hash);
-		hash[MD5_HASH_LENGTH] = 0;
-    }
 
+	// hex representation, as printed by md5sum
 	explicit Md5Hash(const std::string &h) {
-		std::copy(h.begin(), h.end(), hash);
-		hash[MD5_HASH_LENGTH] = 0;
+		for (size_t i = 0; i < MD5_DIGEST_SIZE && 2 * i + 1 < h.size(); ++i) {
+			digest[i] = (uint8_t) (hexValue(h[2 * i]) << 4 | hexValue(h[2 * i + 1]));
+		}
 	}
 
-	template <unsigned long size>
-	explicit Md5Hash(const std::array<char, size> &array) {
-		std::copy(array.begin(), array.end(), hash);
-		hash[MD5_HASH_LENGTH] = 0;
+	static Md5Hash fromDigest(const uint8_t *bytes) {
+		Md5Hash hash;
+		memcpy(hash.digest, bytes, MD5_DIGEST_SIZE);
+		return hash;
 	}
 
-	std::string getHash() const {
-		return std::string(hash);
+	const uint8_t *getDigest() const {
+		return digest;
 	}
 
-	Md5Hash &operator=(const Md5Hash &other) {
-		auto otherName = other.getHash();
-		std::copy(otherName.begin(), otherName.end(), hash);
-		hash[MD5_HASH_LENGTH] = 0;
-		return *this;
+	std::string getHash() const {
+		static const char HEX_DIGITS[] = "0123456789abcdef";
+		std::string hex(MD5_HASH_LENGTH, '0');
+		for (int i = 0; i < MD5_DIGEST_SIZE; ++i) {
+			hex[2 * i] = HEX_DIGITS[digest[i] >> 4];
+			hex[2 * i + 1] = HEX_DIGITS[digest[i] & 0xf];
+		}
+		return hex;
 	}
 
 	bool operator==(const Md5Hash &other) const {
-		return getHash() == other.getHash();
+		return word(0) == other.word(0) && word(1) == other.word(1);
 	}
 
-    bool operator!=(const Md5Hash &other) const {
-        return !operator==(other);
-    }
+	bool operator!=(const Md5Hash &other) const {
+		return !operator==(other);
+	}
+
+	// same order as the one of hex representations
+	bool operator<(const Md5Hash &other) const {
+		return memcmp(digest, other.digest, MD5_DIGEST_SIZE) < 0;
+	}
+
+	// digest is uniformly distributed, so its first bytes are a good hash already
+	size_t hashCode() const {
+		return (size_t) word(0);
+	}
 };
 
+namespace std {
+	template <>
+	struct hash<Md5Hash> {
+		size_t operator()(const Md5Hash &hash) const {
+			return hash.hashCode();
+		}
+	};
+}
+
 #endif /* INCLUDE_MD5HASH_HPP_ */
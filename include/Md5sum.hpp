@@ -2,33 +2,42 @@
 #define INCLUDE_MD5SUM_HPP_
 
 #include <string>
-#include <cassert>
-#include <cstring>
-#include <cstdio>
-#include <iostream>
+#include <cstdint>
+#include <cstddef>
 #include <istream>
-#include <iterator>
-#include <ctype.h>
-#include <iostream>
-#include <exception>
+#include <stdexcept>
 #include <unistd.h>
 #include "Md5hash.hpp"
 
 
+/// MD5 digest computed in the process (RFC 1321).
+/// Content may be passed at once (file, stream) or in parts with update() and finish().
 class Md5sum {
-	const std::string filename;
-    Md5Hash hash;
+	static const size_t BLOCK_SIZE = 64;
+	// files are read in big blocks, so hashing is not dominated by system calls
+	static const size_t READ_BLOCK_SIZE = 1024 * 1024;
+
+	uint32_t state[4];
+	uint64_t length;
+	uint8_t buffer[BLOCK_SIZE];
+	Md5Hash hash;
+	bool finished;
+
+	void transform(const uint8_t *block);
 
 public:
-    explicit Md5sum(const std::string &filename);
+	Md5sum();
+	explicit Md5sum(const std::string &filename);
+	explicit Md5sum(std::istream &stream);
 
-    explicit Md5sum(std::istream &stream);
+	// throws std::logic_error after finish()
+	void update(const void *data, size_t size);
+	// completes the digest; no more data can be added after it
+	Md5Hash finish();
 
 	Md5Hash getMd5Hash() const;
 };
 
 
 
-
-
 #endif /* INCLUDE_MD5SUM_HPP_ */
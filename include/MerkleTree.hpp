@@ -0,0 +1,36 @@
+#ifndef TIN_P2P_MERKLETREE_HPP
+#define TIN_P2P_MERKLETREE_HPP
+
+#include <cstdint>
+#include <vector>
+#include "FileDescriptor.hpp"
+
+/// Hash tree over descriptors ordered by their digests. Leaf covers the range of digests sharing
+/// the first DEPTH bits, so two nodes build the same shape regardless of their contents; comparing
+/// the trees top-down finds the ranges which differ after a few hashes per difference.
+/// Descriptor hashes are already well mixed (CatalogLog::digest), so a node is XOR of its children.
+/// Nodes are numbered as in a heap: root is 1, children of n are 2n and 2n + 1.
+class MerkleTree {
+public:
+    static const unsigned DEPTH = 12;
+    static const size_t LEAVES = (size_t) 1 << DEPTH;
+    static const size_t ROOT = 1;
+
+    MerkleTree();
+    explicit MerkleTree(const std::vector<FileDescriptor> &descriptors);
+
+    void add(const FileDescriptor &descriptor);
+    uint64_t getHash(size_t node) const;
+
+    static bool isNode(size_t node);
+    static bool isLeaf(size_t node);
+    // nodes the given number of levels below, leaves at most
+    static std::vector<size_t> getDescendants(size_t node, unsigned levels);
+    static size_t getLeaf(const Md5Hash &hash);
+
+private:
+    std::vector<uint64_t> nodes;
+};
+
+
+#endif //TIN_P2P_MERKLETREE_HPP
@@ -0,0 +1,96 @@
+#ifndef INCLUDE_MESSAGE_BUILDER_HPP_
+#define INCLUDE_MESSAGE_BUILDER_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/uio.h>
+
+#include "P2PMessage.hpp"
+#include "MessageType.hpp"
+
+/// Frame described as a list of segments: P2PMessage header, small fixed parts
+/// and payloads. Servers pass the segments to writev/sendmsg, so the frame is never
+/// concatenated into one buffer. Additional data size in the header follows the added segments.
+class MessageBuilder
+{
+	struct Segment
+	{
+		// small parts are kept in the arena, which may move when it grows
+		bool inArena;
+		size_t arenaOffset;
+		const void* data;
+		size_t size;
+
+		Segment(size_t offset, size_t s) : inArena(true), arenaOffset(offset), data(nullptr), size(s) {}
+		Segment(const void* d, size_t s) : inArena(false), arenaOffset(0), data(d), size(s) {}
+	};
+
+	std::vector<uint8_t> arena;
+	std::vector<Segment> segments;
+	// keeps moved payloads alive as long as the message
+	std::vector<std::shared_ptr<const void> > payloads;
+	std::string attachedFile;
+	uint64_t attachedOffset;
+	uint64_t attachedLength;
+	bool hasHeader;
+
+	MessageBuilder();
+	void appendToArena(const void* data, size_t size);
+	void growAdditionalData(size_t size);
+public:
+	explicit MessageBuilder(MessageType type);
+	// message made of already serialized bytes, sent as they are
+	static MessageBuilder fromBytes(const uint8_t* data, size_t size);
+
+	// receiver acknowledges the message with the id once it is processed
+	MessageBuilder& setRequestId(uint32_t requestId);
+	// type given in the constructor
+	MessageType getMessageType() const;
+
+	// copies small part of the message (descriptor, address, string) into the message
+	MessageBuilder& add(const void* data, size_t size);
+
+	template <typename T>
+	MessageBuilder& add(const T& value)
+	{
+		return add(&value, sizeof(T));
+	}
+
+	// takes over the payload without copying it
+	template <typename T>
+	MessageBuilder& addPayload(std::vector<T>&& items)
+	{
+		auto payload = std::make_shared<std::vector<T> >(std::move(items));
+		size_t size = payload->size() * sizeof(T);
+		if (size > 0)
+		{
+			segments.emplace_back((const void*) payload->data(), size);
+			payloads.push_back(payload);
+			growAdditionalData(size);
+		}
+		return *this;
+	}
+
+	// content of the file is sent after the segments, straight from the page cache;
+	// its size is added to the header at the moment of sending.
+	// Only the range starting at offset is sent; length 0 means up to the end of the file
+	MessageBuilder& attachFile(const std::string& filename, uint64_t offset = 0, uint64_t length = 0);
+	const std::string& getAttachedFile() const;
+	uint64_t getAttachedFileOffset() const;
+	uint64_t getAttachedFileLength() const;
+	void addAttachedFileSize(size_t fileSize);
+
+	// views of the segments, valid until the message is changed
+	std::vector<iovec> getSegments() const;
+	size_t getSize() const;
+	// true if the header describes exactly the bytes of the message
+	bool isCompleteFrame() const;
+};
+
+
+
+#endif /* INCLUDE_MESSAGE_BUILDER_HPP_ */
@@ -6,11 +6,11 @@
 /// Enum class describing whole protocol abilities.
 enum class MessageType {
 	// raportowanie stanu
-	HELLO,				//< UDP komunikat wysyłany przez nowoutworzony węzeł
-	HELLO_REPLY,		//< TCP odpowiedź od węzłów, które usłyszały HELLO. Dołącza tablicę deskryptorów plików, które znajdowały się w danej chwili w konkretnym
+	HELLO,				//< UDP komunikat wysyłany przez nowoutworzony węzeł; w sekcji danych waga węzła przy rozmieszczaniu plików oraz znane mu wersje katalogów innych węzłów (adres, epoka, numer zmiany)
+	HELLO_REPLY,		//< TCP odpowiedź od węzłów, które usłyszały HELLO. Dołącza tablicę deskryptorów plików, które znajdowały się w danej chwili w konkretnym (albo tylko zmiany od wersji podanej w HELLO)
 	DISCONNECTING,		//< UDP powiadomienie sieci o rozpoczęciu odłączania się
 	CONNECTION_LOST,	//< UDP powiadomienie sieci o utraceniu węzła o określonym IP (podanym w sekcji danych)
-	CMD_REFUSED,		//< TCP powiadomienie węzła, który złożył żądanie (np. o pobranie pliku) o braku możliwości wykonania transkacji (np. dostęp do pliku oznaczonego jako "tymczasowo nieważny" albo próba przesłania pliku do węzła w stanie "disconnecting")
+	CMD_REFUSED,		//< TCP powiadomienie węzła, który złożył żądanie (np. o pobranie pliku) o braku możliwości wykonania transkacji (np. dostęp do pliku oznaczonego jako "tymczasowo nieważny" albo próba przesłania pliku do węzła w stanie "disconnecting"); w sekcji danych typ odrzuconego komunikatu, opis problemu i skrót MD5 pliku
     SHUTDOWN,           //< UDP ostatnia wiadomosc wyslana przez zamykajacy sie wezel - ostatecznie zabija wszystkie deskryptory, ktore nadal nie zostaly zupdatetowane
 
 	// zarządzanie plikami
@@ -25,6 +25,23 @@ enum class MessageType {
 	UPLOAD_FILE,		//< TCP żądanie uploadu pliku, zawiera w sekcji danych: deskryptor oraz plik (jako tablica bajtów)
 	GET_FILE,			//< TCP żądanie przesłania pliku o danym deskryptorze (podanym w sekcji danych) od węzła przetrzymującego plik
 	DELETE_FILE,		//< TCP żądanie unieważnienia pliku o danym deskryptorze (podanym w sekcji danych) do węzła przetrzymującego plik
+
+	// operacje zbiorcze - sekcja danych zawiera tablicę deskryptorów, tyle ile zmieści się w jednym datagramie
+	DISCARD_DESCRIPTORS,	//< UDP zbiorcza wersja DISCARD_DESCRIPTOR
+	UPDATE_DESCRIPTORS,		//< UDP zbiorcza wersja UPDATE_DESCRIPTOR
+	NEW_FILES,				//< UDP zbiorcza wersja NEW_FILE
+	REVOKE_FILES,			//< UDP zbiorcza wersja REVOKE_FILE
+
+	// synchronizacja katalogu
+	CATALOG_REQUEST,		//< TCP żądanie zmian w deskryptorach węzła od podanej wersji (epoka, numer zmiany); odpowiedzią jest HELLO_REPLY
+	SYNC_HASHES,			//< TCP skróty węzłów drzewa Merkle nad deskryptorami plików przetrzymywanych przez podany węzeł; odpowiedzią są skróty poddrzew, które się różnią
+	SYNC_LEAVES,			//< TCP zakresy (liście drzewa), które się różnią, oraz deskryptory z tych zakresów od węzła przetrzymującego pliki
+
+	// rozmieszczanie plików
+	RESERVE_PLACEMENTS,		//< UDP deskryptory plików w trakcie uploadu, z wybranym węzłem; ważny deskryptor rezerwuje miejsce, nieważny zwalnia rezerwację
+
+	// potwierdzenia
+	ACK,					//< TCP potwierdzenie przetworzenia komunikatu z niezerowym identyfikatorem żądania (podanym w sekcji danych)
 };
 
 
@@ -6,6 +6,7 @@
 
 class Mutex {
 	pthread_mutex_t mutex;
+	friend class ConditionVariable;
 
 public:
 	Mutex();
@@ -0,0 +1,63 @@
+#ifndef TIN_P2P_NODELOADTABLE_HPP
+#define TIN_P2P_NODELOADTABLE_HPP
+
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <netinet/in.h>
+#include "Mutex.hpp"
+
+/// Bytes and files held by every node, updated as descriptors come and go.
+/// Nodes are ordered by their load, so the least loaded one is found in O(log n).
+/// Bytes reserved for the uploads in progress count into the order, but not into the totals.
+/// A node is present while it is registered (known member of the network), holds or expects any file.
+/// Synchronized, so it may be shared by the shards of the catalog.
+class NodeLoadTable {
+public:
+    struct NodeLoad {
+        uint64_t bytes;
+        uint32_t files;
+        uint64_t reserved;
+    };
+
+    void addNode(in_addr_t node);
+    void removeNode(in_addr_t node);
+    void addFile(in_addr_t holder, uint64_t size);
+    void removeFile(in_addr_t holder, uint64_t size);
+    void reserve(in_addr_t node, uint64_t size);
+    void release(in_addr_t node, uint64_t size);
+    void clear();
+
+    NodeLoad getLoad(in_addr_t node) const;
+    bool contains(in_addr_t node) const;
+    size_t size() const;
+    bool empty() const;
+    uint64_t getTotalBytes() const;
+    // 0 if there are no nodes
+    uint64_t getAverageLoad() const;
+    // consistent copy of the loads of all the nodes
+    std::unordered_map<in_addr_t, NodeLoad> getLoads() const;
+
+    // throw std::logic_error if there is no such node
+    in_addr_t findLeastLoaded() const;
+    in_addr_t findLeastLoadedExcept(in_addr_t excluded) const;
+
+private:
+    struct Entry {
+        NodeLoad load;
+        bool registered;
+    };
+
+    Entry &getEntry(in_addr_t node);
+    void changeBytes(in_addr_t node, Entry &entry, int64_t delta, int64_t reservedDelta = 0);
+    void removeIfUnused(in_addr_t node);
+
+    mutable Mutex mutex;
+    std::unordered_map<in_addr_t, Entry> entries;
+    std::set<std::pair<uint64_t, in_addr_t>> byLoad;
+    uint64_t totalBytes = 0;
+};
+
+
+#endif //TIN_P2P_NODELOADTABLE_HPP
@@ -25,9 +25,19 @@ public:
 		this->messageType = messageType;
 	}
 
+	// non-zero if the sender waits for an ACK of the message
+	uint32_t getRequestId() const {
+		return requestId;
+	}
+
+	void setRequestId(uint32_t requestId) {
+		this->requestId = requestId;
+	}
+
 private:
 	MessageType messageType;
 	uint32_t additionalDataSize;
+	uint32_t requestId = 0;
 };
 
 
@@ -0,0 +1,92 @@
+#ifndef TIN_P2P_PENDINGOPERATIONS_HPP
+#define TIN_P2P_PENDINGOPERATIONS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+#include "Md5hash.hpp"
+#include "MessageType.hpp"
+#include "Mutex.hpp"
+
+/// Client operations (UPLOAD_FILE, GET_FILE, DELETE_FILE) waiting for their outcome. An operation is identified
+/// by its request and the file: it completes when the answer of the holder arrives (NEW_FILE, FILE_TRANSFER,
+/// REVOKE_FILE) or is refused (CMD_REFUSED), fails when the holder is lost, and times out like a drain transfer.
+/// Each one has its future and an optional callback, so many of them can be in flight at once.
+/// Synchronized; callbacks run outside of the lock, on the thread completing the operation.
+class PendingOperations {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum class Status {
+        COMPLETED,
+        // the holder has refused the request
+        REFUSED,
+        // the network keeps another file with the same digest
+        COLLISION,
+        // e.g. unknown file, received content with a different hash
+        FAILED,
+        NODE_LOST,
+        TIMED_OUT,
+        CANCELLED
+    };
+
+    struct Result {
+        Status status;
+        std::string message;
+        Clock::time_point started;
+        Clock::duration elapsed;
+
+        bool succeeded() const {
+            return status == Status::COMPLETED;
+        }
+    };
+
+    typedef std::shared_future<Result> Future;
+    typedef std::function<void(const Result &)> Callback;
+
+    PendingOperations(long timeoutMs, uint64_t minBytesPerSecond);
+
+    // the operation has to be added before its request is sent, its answer may come at once;
+    // it is given the timeout plus the time the size takes at the minimal rate
+    Future add(MessageType request, const Md5Hash &hash, in_addr_t node, uint64_t size,
+               const Callback &callback = nullptr, Clock::time_point now = Clock::now());
+    // completes all the operations of the request on the file, returns their number
+    size_t complete(MessageType request, const Md5Hash &hash, Status status, const std::string &message = "");
+    // operations answered by the node complete with NODE_LOST
+    size_t failNode(in_addr_t node);
+    // operations past their deadlines complete with TIMED_OUT
+    size_t expire(Clock::time_point now = Clock::now());
+    void cancelAll();
+    size_t size() const;
+
+    // operation which has ended before any request, e.g. for an unknown file
+    static Future finished(Status status, const std::string &message, const Callback &callback = nullptr);
+
+private:
+    struct Operation {
+        in_addr_t node;
+        Clock::time_point started;
+        Clock::time_point deadline;
+        std::promise<Result> done;
+        Callback callback;
+    };
+
+    typedef std::pair<MessageType, Md5Hash> Key;
+
+    // removed operations are resolved once the lock has been released
+    static void resolve(std::vector<Operation> &operations, Status status, const std::string &message);
+
+    Clock::duration timeout;
+    uint64_t minBytesPerSecond;
+
+    mutable Mutex mutex;
+    std::multimap<Key, Operation> operations;
+};
+
+
+#endif //TIN_P2P_PENDINGOPERATIONS_HPP
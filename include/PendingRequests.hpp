@@ -0,0 +1,62 @@
+#ifndef TIN_P2P_PENDINGREQUESTS_HPP
+#define TIN_P2P_PENDINGREQUESTS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <netinet/in.h>
+#include "Mutex.hpp"
+
+/// Requests waiting for ACKs. Every request gets an id, carried in P2PMessage, and a future which
+/// completes with true once each of the nodes has acknowledged it, or with false as soon as one of them
+/// is lost or the request expires. Latency of a protocol step follows the slowest peer instead of a fixed delay.
+/// Synchronized; continuations run outside of the lock, on the thread completing the request.
+class PendingRequests {
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::shared_future<bool> Future;
+    // next step of the protocol, run once the request completes instead of waiting for its future
+    typedef std::function<void(bool acknowledged)> Continuation;
+
+    explicit PendingRequests(long timeoutMs);
+
+    // id of the new request acknowledged by the nodes, never 0; with no nodes the future is complete already
+    // and the continuation has run
+    uint32_t add(const std::vector<in_addr_t> &nodes, Future &future, const Continuation &continuation = nullptr,
+                 Clock::time_point now = Clock::now());
+    // false if the request is not waiting for the node
+    bool acknowledge(uint32_t id, in_addr_t node);
+    // requests waiting for the node complete with false
+    void failNode(in_addr_t node);
+    // requests older than the timeout complete with false
+    void expire(Clock::time_point now = Clock::now());
+    void cancelAll();
+    size_t size() const;
+
+    // true if all the futures complete with true within the time
+    static bool waitAll(const std::vector<Future> &futures, long timeoutMs);
+
+private:
+    struct Request {
+        std::unordered_set<in_addr_t> waitingFor;
+        std::promise<bool> done;
+        Continuation continuation;
+        Clock::time_point deadline;
+    };
+
+    // removed requests are completed once the lock has been released
+    static void complete(std::vector<Request> &requests, bool acknowledged);
+
+    Clock::duration timeout;
+
+    mutable Mutex mutex;
+    std::unordered_map<uint32_t, Request> requests;
+    uint32_t lastId = 0;
+};
+
+
+#endif //TIN_P2P_PENDINGREQUESTS_HPP
@@ -0,0 +1,33 @@
+#ifndef TIN_P2P_PERIODICTASK_HPP
+#define TIN_P2P_PERIODICTASK_HPP
+
+#include <functional>
+#include "Thread.hpp"
+#include "Mutex.hpp"
+#include "Guard.hpp"
+#include "ConditionVariable.hpp"
+
+/// Runs the task on its own thread every period, the first time one period after the start.
+/// Destructor waits for the running task and stops the thread.
+class PeriodicTask {
+public:
+    typedef std::function<void()> Task;
+
+    PeriodicTask(Task task, long periodMs);
+    ~PeriodicTask();
+
+private:
+    static void *runHelper(void *periodicTask);
+    void run();
+
+    Task task;
+    long periodMs;
+
+    Mutex mutex;
+    ConditionVariable stopped;
+    bool stopping;
+    Thread *thread;
+};
+
+
+#endif //TIN_P2P_PERIODICTASK_HPP
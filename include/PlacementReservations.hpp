@@ -0,0 +1,53 @@
+#ifndef TIN_P2P_PLACEMENTRESERVATIONS_HPP
+#define TIN_P2P_PLACEMENTRESERVATIONS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <netinet/in.h>
+#include "Md5hash.hpp"
+#include "Mutex.hpp"
+#include "NodeLoadTable.hpp"
+
+/// Tentative placements of the files being uploaded. Their bytes count into the loads of the chosen nodes,
+/// so uploads started at the same time spread over the network instead of all choosing the same least
+/// loaded node. A reservation lasts until the file is published, the upload fails or it expires.
+/// Synchronized; takes the load table's lock inside its own.
+class PlacementReservations {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    PlacementReservations(NodeLoadTable &loads, long ttlMs);
+
+    // replaces an earlier reservation of the file
+    void reserve(const Md5Hash &hash, in_addr_t node, uint64_t size, Clock::time_point now = Clock::now());
+    // false if the file has not been reserved
+    bool release(const Md5Hash &hash);
+    // all the reservations on the node, e.g. when it leaves
+    void releaseNode(in_addr_t node);
+    // releases the reservations older than the time to live
+    void expire(Clock::time_point now = Clock::now());
+    void clear();
+
+    size_t size() const;
+
+private:
+    struct Reservation {
+        in_addr_t node;
+        uint64_t size;
+        Clock::time_point expires;
+    };
+
+    void remove(std::unordered_map<Md5Hash, Reservation>::iterator reservation);
+
+    NodeLoadTable &loads;
+    Clock::duration ttl;
+
+    mutable Mutex mutex;
+    std::unordered_map<Md5Hash, Reservation> reservations;
+    std::multimap<Clock::time_point, Md5Hash> byExpiry;
+};
+
+
+#endif //TIN_P2P_PLACEMENTRESERVATIONS_HPP
@@ -0,0 +1,66 @@
+#ifndef TIN_P2P_PLACEMENTSTRATEGY_HPP
+#define TIN_P2P_PLACEMENTSTRATEGY_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <netinet/in.h>
+#include "Md5hash.hpp"
+#include "Mutex.hpp"
+#include "NodeLoadTable.hpp"
+
+enum class PlacementMode {
+    LEAST_LOADED,
+    RENDEZVOUS,
+};
+
+/// Chooses the node which should hold a file. All the nodes of the network have to use the same mode.
+class PlacementStrategy {
+public:
+    virtual ~PlacementStrategy() = default;
+
+    // members of the network; weight is the share of the files the node should hold
+    virtual void addNode(in_addr_t /*node*/, uint32_t /*weight*/) {}
+    virtual void removeNode(in_addr_t /*node*/) {}
+
+    // node other than excluded (INADDR_NONE - any) which should hold the file;
+    // throws std::logic_error if there is no such node
+    virtual in_addr_t choose(const Md5Hash &hash, in_addr_t excluded = INADDR_NONE) const = 0;
+    // true if the holder follows from the digest and the members alone - then a joining node
+    // takes over exactly the files it is chosen for and every node can find the holder by itself
+    virtual bool isDeterministic() const = 0;
+};
+
+/// File goes to the node holding the least bytes at the moment.
+class LeastLoadedPlacement : public PlacementStrategy {
+public:
+    explicit LeastLoadedPlacement(const NodeLoadTable &loads);
+
+    in_addr_t choose(const Md5Hash &hash, in_addr_t excluded = INADDR_NONE) const override;
+    bool isDeterministic() const override;
+
+private:
+    const NodeLoadTable &loads;
+};
+
+/// Weighted rendezvous (highest random weight) hashing: every node gets a pseudo-random score
+/// for every digest, scaled by the node's weight, and the file goes to the best scored node.
+/// When a node joins or leaves only the files it wins or held move - about 1/N of the data.
+/// Synchronized.
+class RendezvousPlacement : public PlacementStrategy {
+public:
+    void addNode(in_addr_t node, uint32_t weight) override;
+    void removeNode(in_addr_t node) override;
+    size_t size() const;
+
+    in_addr_t choose(const Md5Hash &hash, in_addr_t excluded = INADDR_NONE) const override;
+    bool isDeterministic() const override;
+
+    static double score(const Md5Hash &hash, in_addr_t node, uint32_t weight);
+
+private:
+    mutable Mutex mutex;
+    std::unordered_map<in_addr_t, uint32_t> weights;
+};
+
+
+#endif //TIN_P2P_PLACEMENTSTRATEGY_HPP
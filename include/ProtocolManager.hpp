@@ -10,6 +10,7 @@
 #include "FileDescriptor.hpp"
 #include <boost/log/trivial.hpp>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <P2PMessage.hpp>
 #include <iostream>
@@ -19,18 +20,58 @@
 #include "Mutex.hpp"
 #include "Guard.hpp"
 #include "FileDeleter.hpp"
+#include "FileReceiver.hpp"
+#include "MessageBuilder.hpp"
+#include "DescriptorBatcher.hpp"
+#include "DescriptorCodec.hpp"
+#include "ShardedCatalog.hpp"
+#include "CatalogLog.hpp"
+#include "CatalogState.hpp"
+#include "MerkleTree.hpp"
+#include "PeriodicTask.hpp"
+#include "PlacementStrategy.hpp"
+#include "Rebalancer.hpp"
+#include "PlacementReservations.hpp"
+#include "DrainJob.hpp"
+#include "PendingRequests.hpp"
+#include "PendingOperations.hpp"
 
 namespace p2p {
     const char *getFormatedIp(in_addr_t addr);
-    void startSession();
+    // placement mode has to be the same in the whole network; weight is this node's share of the files
+    // in the rendezvous mode
+    void startSession(PlacementMode placementMode = PlacementMode::LEAST_LOADED, uint32_t placementWeight = 1);
     void endSession();
     std::vector<FileDescriptor> getLocalFileDescriptors();
     std::vector<FileDescriptor> getNetworkFileDescriptors();
     bool uploadFile(std::string name);
     bool getFile(std::string name);
     bool getFile(std::string name, std::string hash);
+    // partial read, see async::getFile
+    bool getFile(std::string name, uint64_t offset, uint64_t length);
+    bool getFile(std::string name, std::string hash, uint64_t offset, uint64_t length);
     bool deleteFile(std::string name);
     bool deleteFile(std::string name, std::string hash);
+
+    // same operations completing once the network has answered: upload with NEW_FILE of the holder,
+    // get with the verified FILE_TRANSFER, delete with REVOKE_FILE; any of them with CMD_REFUSED
+    namespace async {
+        typedef PendingOperations::Future Operation;
+
+        Operation uploadFile(const std::string &name, const PendingOperations::Callback &callback = nullptr);
+        Operation getFile(const std::string &name, const PendingOperations::Callback &callback = nullptr);
+        Operation getFile(const std::string &name, const std::string &hash,
+                          const PendingOperations::Callback &callback = nullptr);
+        // reads length bytes from the offset (fewer at the end of the file) into <name>.<offset>-<end>,
+        // see FileReceiver::getRangeFileName; length 0 gets the whole file
+        Operation getFile(const std::string &name, uint64_t offset, uint64_t length,
+                          const PendingOperations::Callback &callback = nullptr);
+        Operation getFile(const std::string &name, const std::string &hash, uint64_t offset, uint64_t length,
+                          const PendingOperations::Callback &callback = nullptr);
+        Operation deleteFile(const std::string &name, const PendingOperations::Callback &callback = nullptr);
+        Operation deleteFile(const std::string &name, const std::string &hash,
+                             const PendingOperations::Callback &callback = nullptr);
+    }
 };
 
 
@@ -38,42 +79,158 @@ namespace p2p {
 namespace p2p {
     namespace util {
         extern std::unordered_map<MessageType, std::function<void(const uint8_t *, uint32_t, in_addr_t)>> msgProcessors;
+        // messages carrying files, run after the file has been streamed into the store
+        extern std::unordered_map<MessageType, FileReceiver::Completion> fileProcessors;
         extern std::shared_ptr<TcpServer> tcpServer;
         extern std::shared_ptr<UdpServer> udpServer;
+        // collects UPDATE_DESCRIPTOR publications of received files
+        extern std::shared_ptr<DescriptorBatcher> updatesBatcher;
+        // collects NEW_FILE publications of stored uploads and REVOKE_FILE publications of deleted files
+        extern std::shared_ptr<DescriptorBatcher> newFilesBatcher;
+        extern std::shared_ptr<DescriptorBatcher> revocationsBatcher;
+        // how long a descriptor waits for others to share its datagram
+        const long DESCRIPTORS_LINGER_MS = 20;
+        // descriptors published at once; broadcastDescriptors splits them into datagrams
+        const size_t DESCRIPTORS_BATCH_SIZE = 64;
+        // compares the catalog with a random node from time to time, repairing lost broadcasts
+        extern std::shared_ptr<PeriodicTask> antiEntropy;
+        const long ANTI_ENTROPY_PERIOD_MS = 5000;
+        // tree levels descended in one SYNC_HASHES exchange
+        const unsigned SYNC_LEVELS_PER_ROUND = 4;
+        // hands files over to the joining nodes in the background
+        extern std::shared_ptr<Rebalancer> rebalancer;
+        // bandwidth of this node spent on rebalancing; the rest is left for user transfers
+        const uint64_t REBALANCE_BYTES_PER_SECOND = 8 * 1024 * 1024;
+        // announces the nodes chosen for the uploads in progress (RESERVE_PLACEMENTS)
+        extern std::shared_ptr<DescriptorBatcher> reservationsBatcher;
+        // how long an upload may count into the load of its node before the file is published
+        const long RESERVATION_TTL_MS = 30000;
+        // evacuation of our files while leaving, confirmed by UPDATE_DESCRIPTOR of the new holders
+        extern std::shared_ptr<DrainJob> drain;
+        // files sent at once while leaving
+        const size_t DRAIN_CONCURRENCY = 8;
+        // file is resent elsewhere if not confirmed in this time plus the time it takes at the minimal rate
+        const long DRAIN_CONFIRM_TIMEOUT_MS = 10000;
+        const uint64_t DRAIN_MIN_BYTES_PER_SECOND = 1024 * 1024;
+        const long DRAIN_REPORT_PERIOD_MS = 1000;
+        // our messages waiting for ACKs of the other nodes
+        extern PendingRequests pendingRequests;
+        // protocol step goes on without the ACKs which have not come in this time, e.g. lost datagrams
+        const long ACK_TIMEOUT_MS = 2000;
+        // ends the requests and client operations which have not been answered in time
+        extern std::shared_ptr<PeriodicTask> expiry;
+        const long EXPIRY_PERIOD_MS = 500;
+        // client operations waiting for the answers of the holders
+        extern PendingOperations operations;
+        // operation fails if not answered in this time plus the time its file takes at the minimal rate
+        const long OPERATION_TIMEOUT_MS = 10000;
+        const uint64_t OPERATION_MIN_BYTES_PER_SECOND = 1024 * 1024;
 
         extern std::vector<FileDescriptor> localDescriptors;
-        extern std::vector<FileDescriptor> networkDescriptors;
+        // synchronized by its shards; readers work on snapshots
+        extern ShardedCatalog networkDescriptors;
+        // uploads in progress, ours and announced by the other nodes; count into the loads of networkDescriptors
+        extern PlacementReservations reservations;
         extern std::vector<in_addr_t> nodesAddresses;
+        // changes of localDescriptors, sent to the joining nodes which have seen some older version
+        extern CatalogLog localChanges;
+        // versions of the other nodes' catalogs reflected in networkDescriptors
+        extern std::unordered_map<in_addr_t, CatalogLog::Version> peerVersions;
+        // peer catalogs saved by the previous session, restored once their holders reply with the changes only
+        extern std::unordered_map<in_addr_t, std::vector<FileDescriptor>> rememberedCatalogs;
+        // localChanges, peerVersions and the peer catalogs survive a restart in this file, next to the stored files
+        const char *const CATALOG_STATE_FILE = "catalog.state";
+        // guards localDescriptors, localChanges, peerVersions, rememberedCatalogs and nodesAddresses;
+        // taken before the shards, never inside withShard
         extern Mutex mutex;
+        // chooses holders of the new files and of the files moved on join or leave
+        extern std::shared_ptr<PlacementStrategy> placement;
+        // advertised in HELLO and HELLO_REPLY
+        extern uint32_t placementWeight;
+        // HELLO_REPLY: placement weight (4 bytes), full flag (1 byte), epoch, sequence and digest (8 bytes each),
+        // size of the put records (4 bytes), put records, removed records; full reply puts all the descriptors
+        const size_t CATALOG_REPLY_HEADER_SIZE = sizeof(uint32_t) + 1 + 3 * sizeof(uint64_t) + sizeof(uint32_t);
 
         void initProcessingFunctions();
-        uint32_t getAverageNodesLoad();
-        uint32_t getThisNodeLoad();
-        void moveFilesWithSumaricSizeToNode(int64_t sourceAddress, in_addr_t i);
+        // replaces the moves of the rebalancer with a plan for the current members and loads:
+        // files placed on other nodes by the deterministic placement, or excess over the average load
+        void planRebalancing();
+        // mover of the rebalancer; skips files which are no longer ours or placed on the target
+        bool moveLocalFile(const RebalancePlanner::Move &move);
+        // message will be acknowledged by all the nodes known at the moment; mutex must not be held
+        PendingRequests::Future requestAcks(MessageBuilder &message,
+                                            const PendingRequests::Continuation &continuation = nullptr);
+        // waits for the ACKs, logging the step which goes on without some of them
+        void waitForAcks(const std::vector<PendingRequests::Future> &acks, const char *step);
+        void sendAck(uint32_t requestId, in_addr_t nodeAddress);
         void processTcpMsg(uint8_t *data, uint32_t size, SocketOperation operation);
         void processTcpError(SocketOperation operation);
+        IncomingStream *createTcpStream(const P2PMessage &header, in_addr_t sourceAddress);
+        // requested file has disappeared from the store - the requester is refused instead of waiting
+        void processMissingFile(MessageType messageType, const std::string &filename, in_addr_t nodeAddress);
         void processUdpMsg(uint8_t *data, uint32_t size, SocketOperation operation);
         void joinToNetwork();
+        // HELLO_REPLY with the changes made after the version, or all the descriptors if they are not kept
+        MessageBuilder buildCatalogReply(const CatalogLog::Version &since);
+        void requestCatalog(in_addr_t nodeAddress);
+        void forgetPeerVersion(in_addr_t nodeAddress);
+        // mutex must be held
+        void saveCatalogState();
+        void loadCatalogState();
+        // descriptors of the files held by the node: local ones for this node, as seen in the network for others
+        std::vector<FileDescriptor> getHeldDescriptors(in_addr_t holder);
+        // anti-entropy: both nodes compare their views of the files held by each of them
+        void syncWithRandomNode();
+        // descriptors of the holder in the leaves if we are the holder, a request for them otherwise
+        void sendSyncLeaves(in_addr_t holder, const std::vector<uint16_t> &leaves, in_addr_t nodeAddress);
         void quitFromNetwork();
+        // spreads our files over the other nodes, returns once each of them is confirmed or given up
         void moveLocalDescriptorsIntoOtherNodes();
-        in_addr_t findLeastLoadedNode();
-        void discardDescriptor(FileDescriptor &descriptor);
+        // the node will not confirm the files sent to it while leaving
+        void failDrainTarget(in_addr_t nodeAddress);
+        // chooses the node for the new file and reserves the space there until the file is published;
+        // this node if no other is known
+        in_addr_t reserveHolderNode(const FileDescriptor &descriptor);
+        // upload failed - the reservation is released here and in the network
+        void releaseHolderNode(FileDescriptor descriptor);
+        // keep node load table and placement in line with the known nodes; mutex must be held
+        void addNodeAddress(in_addr_t address, uint32_t weight = 1);
+        void removeNodeAddress(in_addr_t address);
+        // completes once the other nodes have marked the descriptor invalid
+        PendingRequests::Future discardDescriptor(FileDescriptor &descriptor,
+                                                  const PendingRequests::Continuation &continuation = nullptr);
         void changeHolderNode(FileDescriptor &descriptor, in_addr_t newNodeAddress);
-        std::vector<uint8_t> getFileContent(const std::string &name);
-        void storeFileContent(std::vector<uint8_t> &content, const std::string &name);
+        void sendDescriptorWithFile(MessageType messageType, const FileDescriptor &descriptor,
+                                    const std::string &filename, in_addr_t address);
+        // length 0 copies up to the end
+        bool copyFile(const std::string &from, const std::string &to, uint64_t offset = 0, uint64_t length = 0);
         void publishDescriptor(FileDescriptor &descriptor);
+        // broadcasts batch message (DISCARD_DESCRIPTORS, UPDATE_DESCRIPTORS, NEW_FILES, REVOKE_FILES)
+        // in as few datagrams as possible; with acks every datagram is a request acknowledged by the nodes
+        void broadcastDescriptors(MessageType batchType, const std::vector<FileDescriptor> &descriptors,
+                                  std::vector<PendingRequests::Future> *acks = nullptr);
         void uploadFile(FileDescriptor &descriptor);
-        in_addr_t findOtherLeastLoadedNode();
+        // throws std::logic_error if no other node is known
+        in_addr_t findOtherHolderNode(const Md5Hash &hash);
         void removeDuplicatesFromLists();
-        void sendCommandRefused(MessageType messageType, const char *msg, in_addr_t sourceAddress);
-        void sendShutdown();
+        // digest of the file lets the requesting node tell which of its operations has been refused
+        void sendCommandRefused(MessageType messageType, const char *msg, in_addr_t sourceAddress,
+                                const Md5Hash &hash = Md5Hash());
+        PendingRequests::Future sendShutdown();
         void publishLostNode(in_addr_t nodeAddress);
-        void requestGetFile(FileDescriptor &descriptor);
+        // partial read into FileReceiver::getRangeFileName(), from this host if the file is here
+        PendingOperations::Future getFileRange(FileDescriptor &descriptor, uint64_t offset, uint64_t length,
+                                               const PendingOperations::Callback &callback);
+        // asks for the range of the file; length 0 means up to the end
+        void requestGetFile(FileDescriptor &descriptor, uint64_t offset = 0, uint64_t length = 0);
         void requestDeleteFile(FileDescriptor &descriptor);
-        bool isDescriptorUnique(FileDescriptor &descriptor);
-        bool getFile(FileDescriptor &descriptor);
-        bool deleteFile(FileDescriptor &descriptor);
-        FileDescriptor &getRepetedDescriptor(FileDescriptor &descriptor);
+        bool isDescriptorUnique(const FileDescriptor &descriptor);
+        // length 0 gets (or continues getting) the whole file, other ranges are partial reads
+        PendingOperations::Future getFile(FileDescriptor &descriptor, uint64_t offset, uint64_t length,
+                                          const PendingOperations::Callback &callback);
+        PendingOperations::Future deleteFile(FileDescriptor &descriptor, const PendingOperations::Callback &callback);
+        // sync API reports only the operations which have not failed at once
+        bool isStarted(const PendingOperations::Future &operation);
     }
 }
 
@@ -0,0 +1,37 @@
+#ifndef TIN_P2P_REBALANCEPLANNER_HPP
+#define TIN_P2P_REBALANCEPLANNER_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <netinet/in.h>
+#include "FileDescriptor.hpp"
+#include "NodeLoadTable.hpp"
+
+/// Chooses the files a node should hand over so that all the nodes come close to the average load.
+/// Every node plans for itself from its load table, without exchanging any messages: its excess is split
+/// among the underloaded nodes in proportion to their deficits, so together the overloaded nodes fill
+/// every deficit once instead of all of them filling the same newcomer.
+class RebalancePlanner {
+public:
+    struct Move {
+        Md5Hash hash;
+        uint64_t size;
+        in_addr_t target;
+    };
+
+    // moves which cost more bytes than the imbalance they remove are not planned
+    static constexpr double MAX_BYTES_PER_REDUCTION = 1.0;
+
+    // moves of the source's files ranked by the bytes moved per unit of imbalance reduced,
+    // larger files first among equally ranked ones
+    static std::vector<Move> plan(in_addr_t source, const std::vector<FileDescriptor> &files,
+                                  const std::unordered_map<in_addr_t, NodeLoadTable::NodeLoad> &loads);
+
+    // decrease of the sum of distances from the target load when size bytes go
+    // from a node excess bytes above the target to a node deficit bytes below it
+    static int64_t getReduction(int64_t excess, int64_t deficit, uint64_t size);
+};
+
+
+#endif //TIN_P2P_REBALANCEPLANNER_HPP
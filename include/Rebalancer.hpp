@@ -0,0 +1,44 @@
+#ifndef TIN_P2P_REBALANCER_HPP
+#define TIN_P2P_REBALANCER_HPP
+
+#include <deque>
+#include <functional>
+#include <vector>
+#include "Thread.hpp"
+#include "Mutex.hpp"
+#include "Guard.hpp"
+#include "ConditionVariable.hpp"
+#include "RebalancePlanner.hpp"
+#include "TokenBucket.hpp"
+
+/// Performs planned moves on its own thread, no faster than the given number of bytes per second,
+/// so rebalancing after a join does not saturate the network and starve the user transfers.
+/// A new plan replaces the moves which have not started yet.
+/// Destructor abandons the rest of the plan and stops the thread.
+class Rebalancer {
+public:
+    // moves the file; false if the move is no longer valid, which costs no bandwidth
+    typedef std::function<bool(const RebalancePlanner::Move &)> Mover;
+
+    Rebalancer(Mover mover, uint64_t bytesPerSecond);
+    ~Rebalancer();
+
+    void schedule(std::vector<RebalancePlanner::Move> moves);
+    size_t getPendingMoves() const;
+
+private:
+    static void *runHelper(void *rebalancer);
+    void run();
+
+    Mover mover;
+    TokenBucket bucket;
+    std::deque<RebalancePlanner::Move> pending;
+
+    mutable Mutex mutex;
+    ConditionVariable changed;
+    bool stopping;
+    Thread *thread;
+};
+
+
+#endif //TIN_P2P_REBALANCER_HPP
@@ -4,18 +4,22 @@
 
 #include <vector>
 #include <atomic>
+#include <cstddef>
 
 #include "SocketOperation.hpp"
 #include "Thread.hpp"
+#include "ThreadPool.hpp"
 #include "Guard.hpp"
 
 class Server
 {
+public:
+	static const unsigned DEFAULT_WORKER_THREADS = 16;
+	static const size_t DEFAULT_TASK_QUEUE_CAPACITY = 1024;
+
 protected:
-	std::vector <Thread> connectionThreads;
+	ThreadPool executor;
 	Thread* listenerThread;
-	Mutex threadsVecMutex;
-	Mutex stopMutex;
 	int listenSocket;
 	std::atomic<bool> stop;
 
@@ -30,16 +34,28 @@ protected:
 		}
 	};
 
-	void finishThread();
-	void pushConnectionThread(Thread& t);
-	void waitForThreadsToFinish();
+	// queues the task for the worker threads; false once the server is stopping
 	bool addDispatcherThread(void * function_pointer(void *), void * arg, void ** retval);
+	void stopListener();
+	// executes already queued tasks and joins the workers
+	void stopExecutor();
 public:
-	Server();
+	Server(unsigned workerThreads = DEFAULT_WORKER_THREADS,
+			size_t taskQueueCapacity = DEFAULT_TASK_QUEUE_CAPACITY);
 	virtual void startListening() = 0;
-	void stopListening();
+	virtual void stopListening();
 	virtual ~Server();
+	// resolved once and then only when the kernel reports an address or route change
 	static in_addr_t getLocalhostIp();
+	// resolves the address again, e.g. when netlink is not available
+	static void refreshLocalhostIp();
+
+private:
+	static std::atomic<in_addr_t> localhostIp;
+
+	static in_addr_t resolveLocalhostIp();
+	static void initLocalhostIp();
+	static void* watchAddressChanges(void* arg);
 };
 
 
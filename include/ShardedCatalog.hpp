@@ -0,0 +1,97 @@
+#ifndef TIN_P2P_SHARDEDCATALOG_HPP
+#define TIN_P2P_SHARDEDCATALOG_HPP
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "DescriptorCatalog.hpp"
+#include "NodeLoadTable.hpp"
+#include "Mutex.hpp"
+#include "Guard.hpp"
+
+/// Network descriptors split by digest into shards with separate locks, so handlers
+/// of different files do not wait for each other. Readers never lock (RCU-style): a writer which has changed
+/// a shard copies it into a new immutable snapshot and publishes it before unlocking the shard; readers take
+/// the published snapshots atomically and keep them as long as they need. A write costs a copy of its shard,
+/// hence many small shards.
+/// Loads of all the shards are collected in a single NodeLoadTable.
+/// Lock order: p2p::util::mutex, shard, load table.
+class ShardedCatalog {
+public:
+    static const size_t SHARDS_COUNT = 4096;
+
+    // snapshots of the shards; descriptors are not copied again
+    class Snapshot {
+        std::vector<DescriptorCatalog::Snapshot> shards;
+    public:
+        explicit Snapshot(std::vector<DescriptorCatalog::Snapshot> &&shardSnapshots);
+        size_t size() const;
+        std::vector<FileDescriptor> toVector() const;
+
+        template<typename Function>
+        void forEach(Function function) const {
+            for (auto &&shard : shards) {
+                for (auto &&descriptor : *shard) {
+                    function(descriptor);
+                }
+            }
+        }
+    };
+
+    ShardedCatalog();
+
+    // runs the function with the shard of the digest locked, e.g. to check and change a descriptor at once;
+    // the function must not take p2p::util::mutex
+    template<typename Function>
+    auto withShard(const Md5Hash &hash, Function function) -> decltype(function(std::declval<DescriptorCatalog &>())) {
+        Shard &shard = getShard(hash);
+        Guard guard(shard.mutex);
+        // destroyed before the guard, so the changes are published while the shard is still locked
+        Publisher publisher(shard.catalog);
+        return function(shard.catalog);
+    }
+
+    bool insert(const FileDescriptor &descriptor);
+    void upsert(const FileDescriptor &descriptor);
+    bool erase(const Md5Hash &hash);
+    bool setValid(const Md5Hash &hash, bool valid);
+    size_t invalidateHolder(in_addr_t holder);
+    size_t eraseHolder(in_addr_t holder);
+
+    // false if not present
+    bool find(const Md5Hash &hash, FileDescriptor &found) const;
+    bool contains(const Md5Hash &hash) const;
+    std::vector<FileDescriptor> findByName(const std::string &name) const;
+    std::vector<FileDescriptor> findByHolder(in_addr_t holder) const;
+    size_t size() const;
+    bool empty() const;
+
+    Snapshot getSnapshot() const;
+    NodeLoadTable &getLoads();
+
+private:
+    struct Shard {
+        mutable Mutex mutex;
+        DescriptorCatalog catalog;
+
+        explicit Shard(NodeLoadTable *loads) : catalog(loads) {}
+    };
+
+    struct Publisher {
+        DescriptorCatalog &catalog;
+
+        explicit Publisher(DescriptorCatalog &catalog) : catalog(catalog) {}
+        ~Publisher() { catalog.publish(); }
+    };
+
+    static size_t shardIndex(const Md5Hash &hash);
+    Shard &getShard(const Md5Hash &hash);
+    const Shard &getShard(const Md5Hash &hash) const;
+
+    NodeLoadTable loads;
+    std::vector<std::unique_ptr<Shard>> shards;
+};
+
+
+#endif //TIN_P2P_SHARDEDCATALOG_HPP
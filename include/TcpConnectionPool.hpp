@@ -0,0 +1,91 @@
+
+#ifndef INCLUDE_TCP_CONNECTION_POOL_HPP_
+#define INCLUDE_TCP_CONNECTION_POOL_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "SocketOperation.hpp"
+#include "Mutex.hpp"
+#include "Guard.hpp"
+
+/// Per-peer pool of long-lived outbound TCP connections.
+/// A connection is checked out for a single send, so every frame is written
+/// as a whole and frames from many senders go back to back on pooled sockets.
+class TcpConnectionPool
+{
+	typedef std::chrono::steady_clock Clock;
+
+	struct IdleConnection
+	{
+		int socket;
+		Clock::time_point lastUsed;
+
+		IdleConnection(int s, Clock::time_point t) : socket(s), lastUsed(t) {}
+	};
+
+	// bytes written as a single frame: segments followed by an optional part of a file
+	struct Payload
+	{
+		const iovec* segments;
+		int segmentsCount;
+		int fileFd;
+		off_t fileOffset;
+		size_t fileSize;
+
+		Payload(const iovec* s, int count, int fd = -1, off_t offset = 0, size_t fSize = 0)
+			: segments(s), segmentsCount(count), fileFd(fd), fileOffset(offset), fileSize(fSize) {}
+	};
+
+	// has to be shorter than the idle timeout of the receiving side,
+	// otherwise we could write into a connection which is just being closed
+	const std::chrono::seconds IDLE_TIMEOUT{30};
+	static const unsigned MAX_IDLE_PER_PEER = 4;
+	static const int SEND_TIMEOUT_SEC = 5;
+
+	int port;
+	Mutex poolMutex;
+	std::unordered_map<in_addr_t, std::vector<IdleConnection> > idleConnections;
+
+	// returns -1 if there is no usable idle connection to the peer
+	int acquire(in_addr_t toWhom);
+	void release(in_addr_t toWhom, int socket);
+	void closeExpired(Clock::time_point now);
+	int connectTo(in_addr_t toWhom, SocketOperation::Status &failure);
+	static bool isAlive(int socket);
+	SocketOperation::Status sendPooled(const Payload &payload, in_addr_t toWhom);
+	// written counts the bytes which have left for the socket, also when the write fails
+	static bool writePayload(int socket, const Payload &payload, size_t &written);
+	static bool sendAll(int socket, const iovec* segments, int segmentsCount, size_t &written, int flags = 0);
+	static bool sendFileAll(int socket, int fileFd, off_t offset, size_t size, size_t &written);
+public:
+	explicit TcpConnectionPool(int port);
+
+	// sends data over a pooled connection; a broken idle connection is replaced
+	// by a fresh one once, before the failure is reported, if nothing has been written to it.
+	// Part of the frame is never sent again - the peer drops the connection it came on
+	SocketOperation::Status send(const uint8_t* data, size_t size, in_addr_t toWhom);
+	// segments are written with a single sendmsg, without joining them into one buffer
+	SocketOperation::Status send(const iovec* segments, int segmentsCount, in_addr_t toWhom);
+	// like send, but the segments are followed by fileSize bytes of the file starting at offset,
+	// copied by the kernel straight from the page cache to the socket
+	SocketOperation::Status sendFile(const iovec* segments, int segmentsCount, int fileFd, off_t offset,
+			size_t fileSize, in_addr_t toWhom);
+	SocketOperation::Status sendFile(const uint8_t* head, size_t headSize, int fileFd, off_t offset,
+			size_t fileSize, in_addr_t toWhom);
+	// sends data over a dedicated connection which is closed right after
+	SocketOperation::Status sendOnce(const uint8_t* data, size_t size, in_addr_t toWhom);
+	SocketOperation::Status sendOnce(const iovec* segments, int segmentsCount, in_addr_t toWhom);
+	void closeAll();
+	~TcpConnectionPool();
+};
+
+
+
+#endif /* INCLUDE_TCP_CONNECTION_POOL_HPP_ */
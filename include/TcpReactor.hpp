@@ -0,0 +1,123 @@
+
+#ifndef INCLUDE_TCP_REACTOR_HPP_
+#define INCLUDE_TCP_REACTOR_HPP_
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <arpa/inet.h>
+
+#include "SocketOperation.hpp"
+#include "P2PMessage.hpp"
+#include "Thread.hpp"
+#include "Mutex.hpp"
+#include "Guard.hpp"
+#include "ThreadPool.hpp"
+#include "IncomingStream.hpp"
+
+/// Single epoll event loop serving a set of accepted TCP connections.
+/// Reads framed P2PMessages incrementally from non-blocking sockets and
+/// passes every complete frame to the react callback, executed by the executor
+/// (or by the reactor thread itself if there is no executor).
+/// Payloads claimed by the stream factory are passed to the stream chunk by chunk instead.
+class TcpReactor
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// per connection framing state, owned by the reactor thread
+	struct Connection
+	{
+		int socket;
+		in_addr_t addr;
+		P2PMessage header;
+		uint32_t headerRead;
+		// whole frame, or single chunk if the payload is streamed
+		uint8_t* buffer;
+		IncomingStream* stream;
+		uint32_t bodyRead;
+		bool frameDelivered;
+		Clock::time_point lastActivity;
+
+		Connection(int s, in_addr_t a) : socket(s), addr(a), header(), headerRead(0),
+				buffer(nullptr), stream(nullptr), bodyRead(0), frameDelivered(false), lastActivity(Clock::now()) {}
+
+		bool isInsideFrame() const
+		{
+			return headerRead > 0 || !frameDelivered;
+		}
+	};
+
+	// connection which doesn't deliver a started frame within this time is failed
+	const std::chrono::seconds RECEIVE_TIMEOUT{10};
+	// connection idle between frames is closed quietly after this time
+	const std::chrono::seconds IDLE_TIMEOUT{60};
+	const int EPOLL_WAIT_MS = 500;
+	static const int MAX_EVENTS = 64;
+
+	void (*react)(uint8_t*, uint32_t, SocketOperation);
+	void (*errorCallback)(SocketOperation op);
+	StreamFactory streamFactory;
+
+	// complete frame handed over to the executor
+	struct FrameTask
+	{
+		void (*react)(uint8_t*, uint32_t, SocketOperation);
+		uint8_t* buffer;
+		uint32_t size;
+		SocketOperation op;
+
+		FrameTask(void (*r)(uint8_t*, uint32_t, SocketOperation), uint8_t* b, uint32_t s,
+				SocketOperation o) : react(r), buffer(b), size(s), op(o) {}
+	};
+
+	ThreadPool* executor;
+	int epollFd;
+	int wakeupFd;
+	Thread* reactorThread;
+	std::atomic<bool> stopping;
+
+	// sockets handed over by the listener, waiting to be registered in epoll
+	Mutex pendingMutex;
+	std::vector<std::pair<int, in_addr_t> > pendingConnections;
+
+	std::unordered_map<int, Connection*> connections;
+
+	static void* runHelper(void* reactor);
+	static void* reactHelper(void* frameTask);
+	static void* finishStreamHelper(void* stream);
+	void run();
+	void registerPendingConnections();
+	// returns false if connection has been closed
+	bool handleReadable(Connection* connection);
+	bool prepareFrameBuffer(Connection* connection);
+	void deliverFrame(Connection* connection);
+	void failConnection(Connection* connection);
+	void closeConnection(Connection* connection);
+	void checkTimeouts();
+	bool hasConnectionsInsideFrame() const;
+	void wakeup();
+public:
+	// runs react for the frame on the executor, takes ownership of the buffer
+	static void dispatchFrame(ThreadPool* executor, void (*react)(uint8_t*, uint32_t, SocketOperation),
+			uint8_t* buffer, uint32_t size, SocketOperation op);
+	// finishes completely received stream on the executor, takes ownership of the stream
+	static void dispatchStreamEnd(ThreadPool* executor, IncomingStream* stream);
+
+	TcpReactor(void (*react)(uint8_t*, uint32_t, SocketOperation),
+			void (*errorCallbackFunc)(SocketOperation), ThreadPool* executor = nullptr,
+			StreamFactory streamFactory = nullptr);
+
+	void start();
+	// passes ownership of accepted socket to the reactor; can be called from any thread
+	void addConnection(int socket, in_addr_t senderAddr);
+	// serves frames which are already in progress, closes every connection and joins the reactor thread
+	void stop();
+	~TcpReactor();
+};
+
+
+
+#endif /* INCLUDE_TCP_REACTOR_HPP_ */
@@ -7,20 +7,40 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <arpa/inet.h>
+#include <vector>
+#include <string>
 
 #include "Server.hpp"
+#include "ConditionVariable.hpp"
+#include "TcpReactor.hpp"
+#include "IncomingStream.hpp"
+#include "MessageBuilder.hpp"
+#include "TcpConnectionPool.hpp"
 
 class TcpServer : public Server
 {
+public:
+	// strategy of serving accepted connections; in both modes received frames
+	// are processed by the worker threads
+	enum class Mode
+	{
+		ThreadPerConnection,	// dedicated thread blocking on every accepted socket
+		EventLoop				// fixed number of epoll reactor threads
+	};
+
+	static const unsigned DEFAULT_REACTOR_THREADS = 4;
+
+	// file attached to the message could not be opened, nothing has been sent
+	typedef void (*MissingFileCallback)(MessageType messageType, const std::string& filename, in_addr_t toWhom);
+
 private:
 	// arguments struct for actualSendData
 	struct SendArgs
 	{
-		uint8_t* data;
-		uint32_t size;
+		MessageBuilder message;
 		in_addr_t toWhom;
 
-		SendArgs(uint8_t* d, uint32_t s, in_addr_t w) : data(d), size(s), toWhom(w) {}
+		SendArgs(MessageBuilder&& m, in_addr_t w) : message(std::move(m)), toWhom(w) {}
 	};
 
 	// pthreads can't handle instance methods therefore context struct
@@ -33,26 +53,68 @@ private:
 		ActualSendDataContext(TcpServer* s, SendArgs* a) : serverInstance(s), args(a) {}
 	};
 
-	const int LISTEN_PORT = 3333;
+	static const int LISTEN_PORT = 3333;
+	// connection without next frame is closed after this time
+	static const int IDLE_CONNECTION_TIMEOUT_MS = 60000;
+	static const int STOP_CHECK_INTERVAL_MS = 100;
 
 	void (*react)(uint8_t*, uint32_t, SocketOperation);
 	void (*errorCallback)(SocketOperation op);
+	StreamFactory streamFactory;
+	MissingFileCallback missingFileCallback;
+
+	Mode mode;
+	unsigned reactorThreadsNumber;
+	std::vector<TcpReactor*> reactors;
+
+	// connection threads of ThreadPerConnection mode
+	Mutex connectionThreadsMutex;
+	ConditionVariable connectionThreadsFinished;
+	unsigned activeConnectionThreads;
+	// sends queued in the executor, finished before the listener is closed
+	Mutex pendingSendsMutex;
+	ConditionVariable pendingSendsFinished;
+	unsigned pendingSends;
+	TcpConnectionPool connectionPool;
 
 	bool checkReceiveIssues(int readLength, in_addr_t sender, int expectedSize=-1);
 
 	static void* actualStartListening(void* context);
 	static void* handleConnectionHelper(void* context);
+	bool startConnectionThread(SocketContext* ctx);
+	void finishConnectionThread();
+	void waitForConnectionThreads();
+	void finishPendingSend();
+	void waitForPendingSends();
 	static void* actualSendDataHelper(void* context);
 	void handleConnection(int connSocket, in_addr_t senderAddr);
-	void actualSendData(uint8_t* data, uint32_t size, in_addr_t toWhom);
+	// receives the frame and passes it to the worker threads; returns false on failure
+	// or (if quietEof) when the connection is closed before the frame starts
+	bool receiveFrame(int connSocket, in_addr_t senderAddr, bool quietEof);
+	bool receiveStream(int connSocket, in_addr_t senderAddr, uint32_t size, IncomingStream* stream);
+	bool waitForNextFrame(int connSocket);
+	void actualSendData(MessageBuilder &message, in_addr_t toWhom);
+	void actualSendFile(MessageBuilder &message, in_addr_t toWhom);
 public:
 	TcpServer(void (*react)(uint8_t*, uint32_t, SocketOperation),
-			void (*errorCallbackFunc)(SocketOperation));
+			void (*errorCallbackFunc)(SocketOperation),
+			Mode mode = Mode::ThreadPerConnection,
+			unsigned reactorThreads = DEFAULT_REACTOR_THREADS,
+			unsigned workerThreads = DEFAULT_WORKER_THREADS);
 
-    // starts thread that will listen for connections and start new callback threads if something connects
+    // starts thread that will listen for connections and start new connection threads if something connects
+    // (or hand them over to the reactors in EventLoop mode)
 	void startListening();
-	// sends data to given address in new thread.
+	// payloads claimed by the factory are streamed instead of buffered; set before startListening()
+	void setStreamFactory(StreamFactory factory);
+	// lets the receiver know that the file will not come; without it the file is only logged as missing
+	void setMissingFileCallback(MissingFileCallback callback);
+	void stopListening();
+	// sends data to given address from a worker thread, over pooled connection if data is a complete frame
 	void sendData(uint8_t* data, size_t n, in_addr_t toWhom);
+	// sends the message segments with a single sendmsg from a worker thread; attached file
+	// is passed by the kernel with sendfile, without copying it to the user space
+	void sendMessage(MessageBuilder&& message, in_addr_t toWhom);
 	~TcpServer();
 };
 
@@ -10,6 +10,8 @@ private:
 public:
     Thread(void * function_pointer(void *), void * arg, void ** retval);
     void * get();
+    // thread releases its resources by itself when it ends
+    void detach();
     static void exit();
     bool isCurrentThread();
     void kill(int signal);
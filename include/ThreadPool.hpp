@@ -0,0 +1,53 @@
+
+#ifndef INCLUDE_THREAD_POOL_HPP_
+#define INCLUDE_THREAD_POOL_HPP_
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include "Thread.hpp"
+#include "Mutex.hpp"
+#include "Guard.hpp"
+#include "ConditionVariable.hpp"
+
+/// Fixed number of worker threads executing tasks from a bounded queue.
+/// Tasks have the pthread routine signature, so they can be moved from
+/// dedicated threads without changes.
+class ThreadPool
+{
+	struct Task
+	{
+		void* (*function)(void*);
+		void* arg;
+
+		Task(void* (*f)(void*), void* a) : function(f), arg(a) {}
+	};
+
+	std::vector<Thread*> workers;
+	std::deque<Task> tasks;
+	size_t queueCapacity;
+	bool stopping;
+
+	Mutex queueMutex;
+	ConditionVariable taskAvailable;
+	ConditionVariable spaceAvailable;
+
+	static void* workerLoop(void* pool);
+	bool isWorkerThread();
+public:
+	ThreadPool(unsigned workersNumber, size_t queueCapacity);
+
+	// queues a task, blocking while the queue is full; a worker which submits
+	// into a full queue runs the task itself, so workers never wait for each other.
+	// Returns false if the pool is already shut down (tasks submitted by the workers
+	// are accepted until the queue is drained).
+	bool submit(void* function(void*), void* arg);
+	// executes every queued task and joins the workers
+	void shutdown();
+	~ThreadPool();
+};
+
+
+
+#endif /* INCLUDE_THREAD_POOL_HPP_ */
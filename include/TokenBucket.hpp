@@ -0,0 +1,28 @@
+#ifndef TIN_P2P_TOKENBUCKET_HPP
+#define TIN_P2P_TOKENBUCKET_HPP
+
+#include <chrono>
+#include <cstdint>
+
+/// Limits the rate of transfers: every byte takes a token, tokens come at the given rate
+/// and up to burst of them are saved while nothing is sent. Taking more tokens than there are
+/// goes into debt, so a file larger than the burst still goes at once and the next one waits longer.
+/// Not synchronized.
+class TokenBucket {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    TokenBucket(uint64_t bytesPerSecond, uint64_t burstBytes);
+
+    // takes the tokens for the bytes just sent; returns how long to wait before sending more
+    Clock::duration take(uint64_t bytes, Clock::time_point now = Clock::now());
+
+private:
+    double rate;
+    double burst;
+    double tokens;
+    Clock::time_point refilled;
+};
+
+
+#endif //TIN_P2P_TOKENBUCKET_HPP
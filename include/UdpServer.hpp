@@ -7,9 +7,15 @@
 #include <arpa/inet.h>
 
 #include "Server.hpp"
+#include "MessageBuilder.hpp"
 
 class UdpServer : public Server
 {
+public:
+	// biggest datagram which fits into the Ethernet MTU without IP fragmentation
+	static const uint32_t MAX_DATAGRAM_SIZE = 1472;
+
+private:
 	const int PORT = 2000;
 	int broadcastEnable = 1;
 	bool isSelfBroadcastDisable = true;
@@ -31,15 +37,18 @@ class UdpServer : public Server
 
 	static void* actualStartListening(void* ctx);
 	static void* handleBroadcastReceive(void* ctx);
+	void broadcastSegments(const iovec* segments, int segmentsCount);
 public:
 	UdpServer(void (*receiveBroadcastCallback)(uint8_t* data, uint32_t size,
-			SocketOperation op));
-    // starts thread that will run callbacks in new threads if broadcast is received
+			SocketOperation op), unsigned workerThreads = DEFAULT_WORKER_THREADS);
+    // starts thread that will run callbacks on the worker threads if broadcast is received
 	void startListening();
 	void enableSelfBroadcasts();
 	void disableSelfBroadcasts();
 	// sends broadcast from current thread
 	void broadcast(uint8_t* bytes, uint32_t size);
+	// sends message segments as a single datagram, without joining them into one buffer
+	void broadcast(const MessageBuilder& message);
 	~UdpServer();
 };
 
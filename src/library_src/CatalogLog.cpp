@@ -0,0 +1,149 @@
+#include <cstring>
+#include <random>
+#include <unordered_map>
+#include "CatalogLog.hpp"
+#include "DescriptorCodec.hpp"
+
+namespace {
+    uint64_t drawEpoch() {
+        std::random_device device;
+        // 0 is never used, so it can stand for "nothing seen yet"
+        uint64_t epoch = 0;
+        while (epoch == 0) {
+            epoch = (uint64_t) device() << 32 | device();
+        }
+        return epoch;
+    }
+
+    uint64_t mix(uint64_t value) {
+        // splitmix64 finalizer
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ull;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebull;
+        return value ^ (value >> 31);
+    }
+
+    template<typename T>
+    void putField(T value, std::vector<uint8_t> &output) {
+        output.insert(output.end(), (const uint8_t *) &value, (const uint8_t *) &value + sizeof value);
+    }
+
+    template<typename T>
+    bool getField(const uint8_t *&data, const uint8_t *end, T &value) {
+        if ((size_t) (end - data) < sizeof value) {
+            return false;
+        }
+        memcpy(&value, data, sizeof value);
+        data += sizeof value;
+        return true;
+    }
+}
+
+const size_t CatalogLog::DEFAULT_CAPACITY;
+
+CatalogLog::CatalogLog(size_t capacity) : CatalogLog(capacity, drawEpoch()) {
+}
+
+CatalogLog::CatalogLog(size_t capacity, uint64_t epoch) : capacity(capacity), epoch(epoch) {
+}
+
+void CatalogLog::put(const FileDescriptor &descriptor) {
+    append(descriptor, false);
+}
+
+void CatalogLog::remove(const FileDescriptor &descriptor) {
+    append(descriptor, true);
+}
+
+CatalogLog::Version CatalogLog::getVersion() const {
+    return Version{epoch, sequence};
+}
+
+bool CatalogLog::getChangesSince(const Version &since, std::vector<FileDescriptor> &put,
+                                 std::vector<FileDescriptor> &removed) const {
+    if (since.epoch != epoch || since.sequence > sequence) {
+        return false;
+    }
+    // changes after since.sequence have to be kept in full
+    if (since.sequence < sequence && (changes.empty() || changes.front().sequence > since.sequence + 1)) {
+        return false;
+    }
+
+    // only the last change of every descriptor matters; later ones are at the back
+    std::unordered_map<Md5Hash, const Change *> last;
+    for (auto change = changes.rbegin(); change != changes.rend() && change->sequence > since.sequence; ++change) {
+        last.emplace(change->descriptor.getMd5(), &*change);
+    }
+    for (auto &&entry : last) {
+        (entry.second->removed ? removed : put).push_back(entry.second->descriptor);
+    }
+    return true;
+}
+
+void CatalogLog::encode(std::vector<uint8_t> &output) const {
+    // epoch, sequence, number of changes (8 bytes each), then every change:
+    // its sequence (8 bytes), removed flag (1 byte), descriptor record
+    putField(epoch, output);
+    putField(sequence, output);
+    putField((uint64_t) changes.size(), output);
+    for (auto &&change : changes) {
+        putField(change.sequence, output);
+        putField((uint8_t) change.removed, output);
+        DescriptorCodec::encode(change.descriptor, output);
+    }
+}
+
+bool CatalogLog::decode(const uint8_t *&data, const uint8_t *end) {
+    const uint8_t *position = data;
+    uint64_t decodedEpoch, decodedSequence, count;
+    if (!getField(position, end, decodedEpoch) || !getField(position, end, decodedSequence)
+        || !getField(position, end, count) || decodedEpoch == 0) {
+        return false;
+    }
+    std::deque<Change> decodedChanges;
+    for (uint64_t i = 0; i < count; ++i) {
+        Change change;
+        uint8_t removed;
+        if (!getField(position, end, change.sequence) || !getField(position, end, removed)) {
+            return false;
+        }
+        size_t consumed = DescriptorCodec::decode(position, end - position, change.descriptor);
+        if (consumed == 0) {
+            return false;
+        }
+        position += consumed;
+        change.removed = removed != 0;
+        decodedChanges.push_back(change);
+    }
+    // the log may have been saved with a bigger capacity
+    while (decodedChanges.size() > capacity) {
+        decodedChanges.pop_front();
+    }
+
+    epoch = decodedEpoch;
+    sequence = decodedSequence;
+    changes.swap(decodedChanges);
+    data = position;
+    return true;
+}
+
+uint64_t CatalogLog::digest(const std::vector<FileDescriptor> &descriptors) {
+    uint64_t digest = 0;
+    for (auto &&descriptor : descriptors) {
+        digest ^= CatalogLog::digest(descriptor);
+    }
+    return digest;
+}
+
+uint64_t CatalogLog::digest(const FileDescriptor &descriptor) {
+    uint64_t state = (uint64_t) descriptor.getHolderIp() << 32 | (descriptor.isValid() ? 1 : 0);
+    return mix(descriptor.getMd5().hashCode() ^ mix(state ^ mix(descriptor.getSize())));
+}
+
+void CatalogLog::append(const FileDescriptor &descriptor, bool removed) {
+    changes.push_back(Change{++sequence, removed, descriptor});
+    if (changes.size() > capacity) {
+        changes.pop_front();
+    }
+}
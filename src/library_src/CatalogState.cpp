@@ -0,0 +1,86 @@
+#include <cstring>
+#include <stdexcept>
+#include "CatalogState.hpp"
+#include "DescriptorCodec.hpp"
+#include "FileLoader.hpp"
+#include "FileStorer.hpp"
+
+namespace {
+    const uint8_t FORMAT_VERSION = 1;
+
+    template<typename T>
+    void putField(T value, std::vector<uint8_t> &output) {
+        output.insert(output.end(), (const uint8_t *) &value, (const uint8_t *) &value + sizeof value);
+    }
+
+    template<typename T>
+    bool getField(const uint8_t *&data, const uint8_t *end, T &value) {
+        if ((size_t) (end - data) < sizeof value) {
+            return false;
+        }
+        memcpy(&value, data, sizeof value);
+        data += sizeof value;
+        return true;
+    }
+}
+
+bool CatalogState::save(const std::string &filename) const {
+    // format version (1 byte), log, number of peers (8 bytes), then every peer: address (4 bytes),
+    // epoch and sequence of its catalog (8 bytes each), size of its records (8 bytes), records
+    std::vector<uint8_t> content;
+    putField(FORMAT_VERSION, content);
+    log.encode(content);
+    putField((uint64_t) peerVersions.size(), content);
+    for (auto &&peerVersion : peerVersions) {
+        std::vector<uint8_t> records;
+        auto catalog = peerCatalogs.find(peerVersion.first);
+        if (catalog != peerCatalogs.end()) {
+            records = DescriptorCodec::encode(catalog->second);
+        }
+        putField(peerVersion.first, content);
+        putField(peerVersion.second.epoch, content);
+        putField(peerVersion.second.sequence, content);
+        putField((uint64_t) records.size(), content);
+        content.insert(content.end(), records.begin(), records.end());
+    }
+    return FileStorer(filename).storeFile(content);
+}
+
+bool CatalogState::load(const std::string &filename) {
+    std::vector<uint8_t> content;
+    try {
+        content = FileLoader(filename).getContent();
+    } catch (std::runtime_error &e) {
+        return false;
+    }
+
+    const uint8_t *position = content.data();
+    const uint8_t *end = position + content.size();
+    uint8_t formatVersion;
+    CatalogLog decodedLog;
+    uint64_t peers;
+    if (!getField(position, end, formatVersion) || formatVersion != FORMAT_VERSION
+        || !decodedLog.decode(position, end) || !getField(position, end, peers)) {
+        return false;
+    }
+    std::unordered_map<in_addr_t, CatalogLog::Version> decodedVersions;
+    std::unordered_map<in_addr_t, std::vector<FileDescriptor>> decodedCatalogs;
+    for (uint64_t i = 0; i < peers; ++i) {
+        in_addr_t address;
+        CatalogLog::Version version;
+        uint64_t recordsSize;
+        if (!getField(position, end, address) || !getField(position, end, version.epoch)
+            || !getField(position, end, version.sequence) || !getField(position, end, recordsSize)
+            || recordsSize > (uint64_t) (end - position)
+            || !DescriptorCodec::decode(position, recordsSize, decodedCatalogs[address])) {
+            return false;
+        }
+        position += recordsSize;
+        decodedVersions[address] = version;
+    }
+
+    log = decodedLog;
+    peerVersions.swap(decodedVersions);
+    peerCatalogs.swap(decodedCatalogs);
+    return true;
+}
@@ -0,0 +1,39 @@
+#include "ConditionVariable.hpp"
+#include <time.h>
+#include <errno.h>
+
+ConditionVariable::ConditionVariable() {
+	pthread_condattr_t attributes;
+	pthread_condattr_init(&attributes);
+	pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+	pthread_cond_init(&condition, &attributes);
+	pthread_condattr_destroy(&attributes);
+}
+
+void ConditionVariable::wait(Mutex& mutex) {
+	pthread_cond_wait(&condition, &mutex.mutex);
+}
+
+bool ConditionVariable::waitFor(Mutex& mutex, long milliseconds) {
+	timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += milliseconds / 1000;
+	deadline.tv_nsec += (milliseconds % 1000) * 1000000;
+	if (deadline.tv_nsec >= 1000000000) {
+		deadline.tv_sec += 1;
+		deadline.tv_nsec -= 1000000000;
+	}
+	return pthread_cond_timedwait(&condition, &mutex.mutex, &deadline) != ETIMEDOUT;
+}
+
+void ConditionVariable::notifyOne() {
+	pthread_cond_signal(&condition);
+}
+
+void ConditionVariable::notifyAll() {
+	pthread_cond_broadcast(&condition);
+}
+
+ConditionVariable::~ConditionVariable() {
+	pthread_cond_destroy(&condition);
+}
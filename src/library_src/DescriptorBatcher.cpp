@@ -0,0 +1,64 @@
+#include <chrono>
+#include "DescriptorBatcher.hpp"
+
+DescriptorBatcher::DescriptorBatcher(Publisher publisherFunc, size_t size, long linger)
+        : publisher(std::move(publisherFunc)), batchSize(size > 0 ? size : 1), lingerMs(linger),
+          stopping(false) {
+    thread = new Thread(&DescriptorBatcher::runHelper, (void *) this, NULL);
+}
+
+void DescriptorBatcher::add(const FileDescriptor &descriptor) {
+    Guard guard(mutex);
+    pending.push_back(descriptor);
+    changed.notifyOne();
+}
+
+void *DescriptorBatcher::runHelper(void *batcher) {
+    ((DescriptorBatcher *) batcher)->run();
+    return NULL;
+}
+
+void DescriptorBatcher::run() {
+    typedef std::chrono::steady_clock Clock;
+
+    mutex.lock();
+    while (true) {
+        while (pending.empty() && !stopping) {
+            changed.wait(mutex);
+        }
+        if (pending.empty()) {
+            break;
+        }
+
+        // descriptors published shortly after the first one join its batch
+        Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(lingerMs);
+        while (pending.size() < batchSize && !stopping) {
+            long left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            if (left <= 0 || !changed.waitFor(mutex, left)) {
+                break;
+            }
+        }
+
+        std::vector<FileDescriptor> batch;
+        if (pending.size() > batchSize) {
+            batch.assign(pending.begin(), pending.begin() + batchSize);
+            pending.erase(pending.begin(), pending.begin() + batchSize);
+        } else {
+            batch.swap(pending);
+        }
+        mutex.unlock();
+        publisher(std::move(batch));
+        mutex.lock();
+    }
+    mutex.unlock();
+}
+
+DescriptorBatcher::~DescriptorBatcher() {
+    mutex.lock();
+    stopping = true;
+    changed.notifyAll();
+    mutex.unlock();
+
+    thread->get();
+    delete thread;
+}
@@ -0,0 +1,204 @@
+#include "DescriptorCatalog.hpp"
+
+DescriptorCatalog::DescriptorCatalog(NodeLoadTable *sharedLoads)
+        : loads(sharedLoads != nullptr ? sharedLoads : &ownLoads),
+          snapshot(std::make_shared<const std::vector<FileDescriptor>>()), changed(false) {
+}
+
+bool DescriptorCatalog::insert(const FileDescriptor &descriptor) {
+    if (byDigest.count(descriptor.getMd5()) != 0) {
+        return false;
+    }
+    descriptors.push_back(descriptor);
+    index(descriptors.size() - 1);
+    return true;
+}
+
+void DescriptorCatalog::upsert(const FileDescriptor &descriptor) {
+    auto position = byDigest.find(descriptor.getMd5());
+    if (position == byDigest.end()) {
+        insert(descriptor);
+        return;
+    }
+    // name and holder may change, so the secondary indexes are rebuilt for this descriptor;
+    // unindex() erases the digest entry, so its position is copied first
+    size_t replaced = position->second;
+    unindex(replaced);
+    descriptors[replaced] = descriptor;
+    index(replaced);
+}
+
+bool DescriptorCatalog::erase(const Md5Hash &hash) {
+    auto position = byDigest.find(hash);
+    if (position == byDigest.end()) {
+        return false;
+    }
+    size_t erased = position->second;
+    size_t last = descriptors.size() - 1;
+    unindex(erased);
+    markChanged();
+    if (erased != last) {
+        // last descriptor fills the gap
+        descriptors[erased] = descriptors[last];
+        byDigest[descriptors[erased].getMd5()] = erased;
+    }
+    descriptors.pop_back();
+    return true;
+}
+
+void DescriptorCatalog::clear() {
+    for (auto &&descriptor : descriptors) {
+        loads->removeFile(descriptor.getHolderIp(), descriptor.getSize());
+    }
+    markChanged();
+    descriptors.clear();
+    byDigest.clear();
+    byName.clear();
+    byHolder.clear();
+}
+
+const FileDescriptor *DescriptorCatalog::find(const Md5Hash &hash) const {
+    auto position = byDigest.find(hash);
+    if (position == byDigest.end()) {
+        return nullptr;
+    }
+    return &descriptors[position->second];
+}
+
+std::vector<FileDescriptor> DescriptorCatalog::findByName(const std::string &name) const {
+    std::vector<FileDescriptor> found;
+    auto hashes = byName.find(name);
+    if (hashes != byName.end()) {
+        for (auto &&hash : hashes->second) {
+            found.push_back(*find(hash));
+        }
+    }
+    return found;
+}
+
+size_t DescriptorCatalog::countByName(const std::string &name) const {
+    auto hashes = byName.find(name);
+    return hashes == byName.end() ? 0 : hashes->second.size();
+}
+
+std::vector<FileDescriptor> DescriptorCatalog::findByHolder(in_addr_t holder) const {
+    std::vector<FileDescriptor> found;
+    auto hashes = byHolder.find(holder);
+    if (hashes != byHolder.end()) {
+        for (auto &&hash : hashes->second) {
+            found.push_back(*find(hash));
+        }
+    }
+    return found;
+}
+
+bool DescriptorCatalog::setValid(const Md5Hash &hash, bool valid) {
+    auto position = byDigest.find(hash);
+    if (position == byDigest.end()) {
+        return false;
+    }
+    FileDescriptor &descriptor = descriptors[position->second];
+    if (valid) {
+        descriptor.makeValid();
+    } else {
+        descriptor.makeUnvalid();
+    }
+    markChanged();
+    return true;
+}
+
+size_t DescriptorCatalog::invalidateHolder(in_addr_t holder) {
+    auto hashes = byHolder.find(holder);
+    if (hashes == byHolder.end()) {
+        return 0;
+    }
+    for (auto &&hash : hashes->second) {
+        descriptors[byDigest[hash]].makeUnvalid();
+    }
+    markChanged();
+    return hashes->second.size();
+}
+
+size_t DescriptorCatalog::eraseHolder(in_addr_t holder) {
+    auto hashes = byHolder.find(holder);
+    if (hashes == byHolder.end()) {
+        return 0;
+    }
+    // erase() changes the index, so it works on a copy
+    std::vector<Md5Hash> erased(hashes->second.begin(), hashes->second.end());
+    for (auto &&hash : erased) {
+        erase(hash);
+    }
+    return erased.size();
+}
+
+size_t DescriptorCatalog::size() const {
+    return descriptors.size();
+}
+
+bool DescriptorCatalog::empty() const {
+    return descriptors.empty();
+}
+
+DescriptorCatalog::const_iterator DescriptorCatalog::begin() const {
+    return descriptors.begin();
+}
+
+DescriptorCatalog::const_iterator DescriptorCatalog::end() const {
+    return descriptors.end();
+}
+
+const std::vector<FileDescriptor> &DescriptorCatalog::getAll() const {
+    return descriptors;
+}
+
+NodeLoadTable &DescriptorCatalog::getLoads() {
+    return *loads;
+}
+
+const NodeLoadTable &DescriptorCatalog::getLoads() const {
+    return *loads;
+}
+
+void DescriptorCatalog::publish() {
+    if (!changed) {
+        return;
+    }
+    // readers keep the previous snapshot as long as they need it
+    std::atomic_store(&snapshot, Snapshot(std::make_shared<const std::vector<FileDescriptor>>(descriptors)));
+    changed = false;
+}
+
+DescriptorCatalog::Snapshot DescriptorCatalog::getSnapshot() const {
+    return std::atomic_load(&snapshot);
+}
+
+void DescriptorCatalog::markChanged() {
+    changed = true;
+}
+
+void DescriptorCatalog::index(size_t position) {
+    const FileDescriptor &descriptor = descriptors[position];
+    byDigest[descriptor.getMd5()] = position;
+    byName[descriptor.getName()].insert(descriptor.getMd5());
+    byHolder[descriptor.getHolderIp()].insert(descriptor.getMd5());
+    loads->addFile(descriptor.getHolderIp(), descriptor.getSize());
+    markChanged();
+}
+
+void DescriptorCatalog::unindex(size_t position) {
+    const FileDescriptor &descriptor = descriptors[position];
+    byDigest.erase(descriptor.getMd5());
+
+    auto names = byName.find(descriptor.getName());
+    names->second.erase(descriptor.getMd5());
+    if (names->second.empty()) {
+        byName.erase(names);
+    }
+    auto holders = byHolder.find(descriptor.getHolderIp());
+    holders->second.erase(descriptor.getMd5());
+    if (holders->second.empty()) {
+        byHolder.erase(holders);
+    }
+    loads->removeFile(descriptor.getHolderIp(), descriptor.getSize());
+}
@@ -0,0 +1,133 @@
+#include "DescriptorCodec.hpp"
+
+const uint8_t DescriptorCodec::VERSION;
+const size_t DescriptorCodec::DIGEST_SIZE;
+const size_t DescriptorCodec::MAX_ENCODED_SIZE;
+
+static const uint8_t VALID_FLAG = 1;
+
+void DescriptorCodec::encode(const FileDescriptor &descriptor, std::vector<uint8_t> &output) {
+	std::vector<uint8_t> record;
+	record.reserve(MAX_ENCODED_SIZE);
+	record.push_back(VERSION);
+
+	const uint8_t *digest = descriptor.getMd5().getDigest();
+	record.insert(record.end(), digest, digest + DIGEST_SIZE);
+
+	record.push_back(descriptor.isValid() ? VALID_FLAG : 0);
+	putVarint(descriptor.getSize(), record);
+	int64_t uploadTime = descriptor.getUploadTime();
+	putVarint(((uint64_t) uploadTime << 1) ^ (uint64_t) (uploadTime >> 63), record);
+
+	in_addr_t ownerIp = descriptor.getOwnerIp();
+	in_addr_t holderIp = descriptor.getHolderIp();
+	record.insert(record.end(), (const uint8_t *) &ownerIp, (const uint8_t *) &ownerIp + sizeof ownerIp);
+	record.insert(record.end(), (const uint8_t *) &holderIp, (const uint8_t *) &holderIp + sizeof holderIp);
+
+	size_t nameLength = strnlen(descriptor.name, MAX_FILENAME_LEN);
+	putVarint(nameLength, record);
+	record.insert(record.end(), descriptor.name, descriptor.name + nameLength);
+
+	putVarint(record.size(), output);
+	output.insert(output.end(), record.begin(), record.end());
+}
+
+std::vector<uint8_t> DescriptorCodec::encode(const FileDescriptor &descriptor) {
+	std::vector<uint8_t> output;
+	encode(descriptor, output);
+	return output;
+}
+
+std::vector<uint8_t> DescriptorCodec::encode(const std::vector<FileDescriptor> &descriptors) {
+	std::vector<uint8_t> output;
+	for (auto &&descriptor : descriptors) {
+		encode(descriptor, output);
+	}
+	return output;
+}
+
+size_t DescriptorCodec::decode(const uint8_t *data, size_t size, FileDescriptor &descriptor) {
+	const uint8_t *position = data;
+	const uint8_t *end = data + size;
+
+	uint64_t recordSize;
+	if (!getVarint(position, end, recordSize) || recordSize > (uint64_t) (end - position)) {
+		return 0;
+	}
+	const uint8_t *recordEnd = position + recordSize;
+
+	// version 1 fields are present in every record
+	if (recordEnd - position < 1 + (ptrdiff_t) DIGEST_SIZE + 1 || *position < 1) {
+		return 0;
+	}
+	++position;
+
+	Md5Hash hash = Md5Hash::fromDigest(position);
+	position += DIGEST_SIZE;
+
+	uint8_t flags = *position++;
+
+	uint64_t fileSize, zigzagTime, nameLength;
+	if (!getVarint(position, recordEnd, fileSize) || fileSize > MAX_FILE_SIZE
+	    || !getVarint(position, recordEnd, zigzagTime) || recordEnd - position < 2 * (ptrdiff_t) sizeof(in_addr_t)) {
+		return 0;
+	}
+
+	in_addr_t ownerIp, holderIp;
+	memcpy(&ownerIp, position, sizeof ownerIp);
+	position += sizeof ownerIp;
+	memcpy(&holderIp, position, sizeof holderIp);
+	position += sizeof holderIp;
+
+	if (!getVarint(position, recordEnd, nameLength) || nameLength > MAX_FILENAME_LEN
+	    || nameLength > (uint64_t) (recordEnd - position)) {
+		return 0;
+	}
+
+	descriptor = FileDescriptor();
+	descriptor.md5 = hash;
+	descriptor.valid = (flags & VALID_FLAG) != 0;
+	descriptor.size = fileSize;
+	descriptor.uploadTime = (time_t) ((zigzagTime >> 1) ^ -(zigzagTime & 1));
+	descriptor.ownerIp = ownerIp;
+	descriptor.holderIp = holderIp;
+	memcpy(descriptor.name, position, nameLength);
+	descriptor.name[nameLength] = 0;
+
+	// anything after the name belongs to the newer versions
+	return recordEnd - data;
+}
+
+bool DescriptorCodec::decode(const uint8_t *data, size_t size, std::vector<FileDescriptor> &descriptors) {
+	while (size > 0) {
+		FileDescriptor descriptor;
+		size_t consumed = decode(data, size, descriptor);
+		if (consumed == 0) {
+			return false;
+		}
+		descriptors.push_back(descriptor);
+		data += consumed;
+		size -= consumed;
+	}
+	return true;
+}
+
+void DescriptorCodec::putVarint(uint64_t value, std::vector<uint8_t> &output) {
+	while (value >= 0x80) {
+		output.push_back((uint8_t) (value | 0x80));
+		value >>= 7;
+	}
+	output.push_back((uint8_t) value);
+}
+
+bool DescriptorCodec::getVarint(const uint8_t *&data, const uint8_t *end, uint64_t &value) {
+	value = 0;
+	for (int shift = 0; shift < 64 && data < end; shift += 7) {
+		uint8_t byte = *data++;
+		value |= (uint64_t) (byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
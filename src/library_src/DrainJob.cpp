@@ -0,0 +1,143 @@
+#include <algorithm>
+#include "DrainJob.hpp"
+#include "Guard.hpp"
+
+const unsigned DrainJob::MAX_ATTEMPTS;
+
+DrainJob::DrainJob(std::vector<Move> moves, size_t concurrencyLimit, long timeoutMs, uint64_t minRate)
+        : concurrency(concurrencyLimit > 0 ? concurrencyLimit : 1), timeout(std::chrono::milliseconds(timeoutMs)),
+          minBytesPerSecond(minRate > 0 ? minRate : 1), progress{0, 0, 0, 0, 0} {
+    for (auto &&move : moves) {
+        waiting.push_back(Transfer{move, 0, Clock::time_point()});
+        ++progress.totalFiles;
+        progress.totalBytes += move.size;
+    }
+}
+
+bool DrainJob::confirm(const Md5Hash &hash) {
+    Guard guard(mutex);
+    auto transfer = inFlight.find(hash);
+    if (transfer != inFlight.end()) {
+        progress.confirmedBytes += transfer->second.move.size;
+        inFlight.erase(transfer);
+    } else {
+        // late confirmation of a transfer which is waiting for its retry
+        auto retried = std::find_if(waiting.begin(), waiting.end(), [&hash](const Transfer &waitingTransfer) {
+            return waitingTransfer.attempts > 0 && waitingTransfer.move.hash == hash;
+        });
+        if (retried == waiting.end()) {
+            return false;
+        }
+        progress.confirmedBytes += retried->move.size;
+        waiting.erase(retried);
+    }
+    ++progress.confirmedFiles;
+    changed.notifyAll();
+    return true;
+}
+
+void DrainJob::failNode(in_addr_t node) {
+    Guard guard(mutex);
+    for (auto transfer = inFlight.begin(); transfer != inFlight.end();) {
+        if (transfer->second.move.target == node) {
+            failed.push_back(transfer->second);
+            transfer = inFlight.erase(transfer);
+        } else {
+            ++transfer;
+        }
+    }
+    // not started ones would fail as well
+    for (auto &&transfer : waiting) {
+        if (transfer.move.target == node) {
+            transfer.move.target = INADDR_NONE;
+        }
+    }
+    changed.notifyAll();
+}
+
+DrainJob::Progress DrainJob::run(const Sender &send, const Retargeter &retarget, const Reporter &report,
+                                 long reportPeriodMs) {
+    const Clock::duration reportPeriod = std::chrono::milliseconds(reportPeriodMs);
+    Clock::time_point nextReport = Clock::now() + reportPeriod;
+
+    mutex.lock();
+    while (!waiting.empty() || !inFlight.empty() || !failed.empty()) {
+        Clock::time_point now = Clock::now();
+        for (auto transfer = inFlight.begin(); transfer != inFlight.end();) {
+            if (transfer->second.deadline <= now) {
+                failed.push_back(transfer->second);
+                transfer = inFlight.erase(transfer);
+            } else {
+                ++transfer;
+            }
+        }
+
+        if (!failed.empty()) {
+            std::vector<Transfer> retried;
+            retried.swap(failed);
+            mutex.unlock();
+            for (auto &&transfer : retried) {
+                transfer.move.target = transfer.attempts < MAX_ATTEMPTS ? retarget(transfer.move) : INADDR_NONE;
+            }
+            mutex.lock();
+            for (auto &&transfer : retried) {
+                if (transfer.move.target == INADDR_NONE) {
+                    ++progress.failedFiles;
+                } else {
+                    // retries go before the files not started yet
+                    waiting.push_front(transfer);
+                }
+            }
+            continue;
+        }
+
+        if (!waiting.empty() && inFlight.size() < concurrency) {
+            Transfer transfer = waiting.front();
+            waiting.pop_front();
+            if (transfer.move.target == INADDR_NONE) {
+                // its target has left before the start
+                failed.push_back(transfer);
+                continue;
+            }
+            ++transfer.attempts;
+            transfer.deadline = getDeadline(transfer.move, now);
+            inFlight.emplace(transfer.move.hash, transfer);
+            mutex.unlock();
+            send(transfer.move);
+            mutex.lock();
+            continue;
+        }
+
+        if (now >= nextReport) {
+            Progress current = progress;
+            mutex.unlock();
+            report(current);
+            mutex.lock();
+            nextReport = now + reportPeriod;
+            continue;
+        }
+
+        // woken up by a confirmation or a failed node, otherwise at the earliest deadline or report
+        Clock::time_point wakeUp = nextReport;
+        for (auto &&transfer : inFlight) {
+            wakeUp = std::min(wakeUp, transfer.second.deadline);
+        }
+        long left = std::chrono::duration_cast<std::chrono::milliseconds>(wakeUp - now).count();
+        changed.waitFor(mutex, std::max(left, 1L));
+    }
+    Progress result = progress;
+    mutex.unlock();
+
+    report(result);
+    return result;
+}
+
+DrainJob::Progress DrainJob::getProgress() const {
+    Guard guard(mutex);
+    return progress;
+}
+
+DrainJob::Clock::time_point DrainJob::getDeadline(const Move &move, Clock::time_point now) const {
+    std::chrono::duration<double> transferTime((double) move.size / minBytesPerSecond);
+    return now + timeout + std::chrono::duration_cast<Clock::duration>(transferTime);
+}
@@ -6,6 +6,11 @@ FileDescriptor::FileDescriptor(const std::string& filename) {
 	this->md5 = Md5sum(filename).getMd5Hash();
 }
 
+FileDescriptor::FileDescriptor(const std::string& filename, const Md5Hash& md5, uint32_t size)
+	: md5(md5), size(size) {
+	setName(filename);
+}
+
 FileDescriptor::FileDescriptor(const FileDescriptor &other) {
     *this = other;
 }
@@ -56,6 +61,9 @@ uint32_t FileDescriptor::obtainFileSize(const char* fn) {
 	if (stat(fn, &st) == -1) {
 		throw std::invalid_argument(std::string(fn) + " doesn't exist");
 	}
+	if ((uint64_t) st.st_size > MAX_FILE_SIZE) {
+		throw std::invalid_argument(std::string(fn) + " is too big");
+	}
 	return st.st_size;
 }
 
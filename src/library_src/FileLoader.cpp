@@ -1,16 +1,136 @@
 #include <boost/log/trivial.hpp>
+#include <memory>
+#include <stdexcept>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "FileLoader.hpp"
 
+namespace {
+    // file descriptor closed when it goes out of scope
+    class ScopedFd {
+        int fd;
+    public:
+        explicit ScopedFd(int f) : fd(f) {}
+        ~ScopedFd() {
+            if (fd != -1) {
+                close(fd);
+            }
+        }
+        int get() const {
+            return fd;
+        }
+    };
+
+    ssize_t preadFully(int fd, uint8_t *buffer, size_t size, off_t offset) {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t bytesRead = pread(fd, buffer + done, size - done, offset + done);
+            if (bytesRead < 0 && errno == EINTR) {
+                continue;
+            }
+            if (bytesRead < 0) {
+                return -1;
+            }
+            if (bytesRead == 0) {
+                break;
+            }
+            done += bytesRead;
+        }
+        return done;
+    }
+}
+
+FileLoader::View::View(void *addr, size_t len)
+        : address(addr), length(len) {
+}
+
+FileLoader::View::View(View &&other) noexcept
+        : address(other.address), length(other.length) {
+    other.address = nullptr;
+    other.length = 0;
+}
+
+FileLoader::View::~View() {
+    if (address != nullptr) {
+        munmap(address, length);
+    }
+}
+
+const uint8_t *FileLoader::View::data() const {
+    return (const uint8_t *) address;
+}
+
+size_t FileLoader::View::size() const {
+    return length;
+}
+
 FileLoader::FileLoader(std::string file)
         : filename(std::move(file)) {
 }
 
 std::vector<uint8_t> FileLoader::getContent() {
-    std::ifstream t(filename);
-    std::string fileAsString((std::istreambuf_iterator<char>(t)),
-                             std::istreambuf_iterator<char>());
+    ScopedFd fd(open(filename.c_str(), O_RDONLY));
+    struct stat fileStat;
+    if (fd.get() == -1 || fstat(fd.get(), &fileStat) == -1) {
+        throw std::runtime_error("could not open " + filename);
+    }
 
-    std::vector<uint8_t> fileContent(fileAsString.length()+1);
-    memcpy(fileContent.data(), fileAsString.data(), fileAsString.length()+1);
+    std::vector<uint8_t> fileContent(fileStat.st_size);
+    ssize_t bytesRead = preadFully(fd.get(), fileContent.data(), fileContent.size(), 0);
+    if (bytesRead < 0) {
+        throw std::runtime_error("could not read " + filename);
+    }
+    // file might have been truncated in the meantime
+    fileContent.resize(bytesRead);
     return fileContent;
 }
+
+FileLoader::View FileLoader::map() {
+    ScopedFd fd(open(filename.c_str(), O_RDONLY));
+    struct stat fileStat;
+    if (fd.get() == -1 || fstat(fd.get(), &fileStat) == -1) {
+        throw std::runtime_error("could not open " + filename);
+    }
+    if (fileStat.st_size == 0) {
+        // empty files cannot be mapped
+        return View(nullptr, 0);
+    }
+
+    void *address = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("could not map " + filename);
+    }
+    // content is read once from the beginning to the end
+    madvise(address, fileStat.st_size, MADV_SEQUENTIAL);
+    return View(address, fileStat.st_size);
+}
+
+bool FileLoader::readChunks(const ChunkConsumer &consumer, size_t chunkSize) {
+    ScopedFd fd(open(filename.c_str(), O_RDONLY));
+    if (fd.get() == -1) {
+        BOOST_LOG_TRIVIAL(error) << "Could not open " << filename;
+        return false;
+    }
+    posix_fadvise(fd.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    std::unique_ptr<uint8_t[]> chunk(new uint8_t[chunkSize]);
+    for (off_t offset = 0;; offset += chunkSize) {
+        ssize_t bytesRead = preadFully(fd.get(), chunk.get(), chunkSize, offset);
+        if (bytesRead < 0) {
+            BOOST_LOG_TRIVIAL(error) << "Could not read " << filename;
+            return false;
+        }
+        if (bytesRead == 0) {
+            return true;
+        }
+        if (!consumer(chunk.get(), bytesRead)) {
+            return false;
+        }
+        if ((size_t) bytesRead < chunkSize) {
+            return true;
+        }
+    }
+}
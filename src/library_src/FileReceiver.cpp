@@ -0,0 +1,141 @@
+#include <boost/log/trivial.hpp>
+#include "FileReceiver.hpp"
+#include "DescriptorCodec.hpp"
+
+FileReceiver::FileReceiver(MessageType type, in_addr_t source, Completion completionFunc)
+        : messageType(type), sourceAddress(source), completion(std::move(completionFunc)),
+          headerRead(false), rangeOffset(0), rangeLength(0), contentReceived(0), failed(false) {
+}
+
+std::string FileReceiver::getRangeFileName(const std::string &name, uint64_t offset, uint64_t length) {
+    return name + "." + std::to_string(offset) + "-" + std::to_string(offset + length);
+}
+
+void FileReceiver::consume(const uint8_t *data, uint32_t size) {
+    if (!headerRead) {
+        if (failed) {
+            return;
+        }
+        size_t buffered = headerBytes.size();
+        uint32_t headerPart = std::min<uint32_t>(size, MAX_HEADER_SIZE - buffered);
+        headerBytes.insert(headerBytes.end(), data, data + headerPart);
+
+        size_t headerSize = parseHeader();
+        if (headerSize == 0) {
+            // no valid header fits into the longest possible one
+            failed = headerBytes.size() >= MAX_HEADER_SIZE;
+            return;
+        }
+        headerRead = true;
+        // bytes after the header are the beginning of the content
+        data += headerSize - buffered;
+        size -= headerSize - buffered;
+        headerBytes.clear();
+
+        // descriptor tells where the content goes
+        storer.reset(new FileStorer(getStoredFileName()));
+        if (isPartialRead()) {
+            failed = !storer->beginStream();
+            storer->reserve(rangeLength);
+        } else {
+            failed = isRanged() ? !storer->resumeStream(rangeOffset) : !storer->beginStream();
+            if (!failed && rangeOffset < descriptor.getSize()) {
+                storer->reserve(descriptor.getSize() - rangeOffset);
+            }
+        }
+    }
+
+    if (!failed && size > 0) {
+        failed = !storer->append(data, size);
+        contentReceived += size;
+    }
+}
+
+void FileReceiver::finish(bool complete) {
+    if (!headerRead) {
+        if (complete) {
+            BOOST_LOG_TRIVIAL(debug) << "<<< malformed descriptor from " << inet_ntoa({sourceAddress})
+                                     << ", content dropped";
+        }
+        return;
+    }
+
+    if (isPartialRead()) {
+        // only the whole range is kept; its digest cannot be checked against the descriptor
+        bool stored = complete && !failed && contentReceived == rangeLength && storer->commit();
+        if (!stored) {
+            BOOST_LOG_TRIVIAL(debug) << "<<< received " << contentReceived << " of " << rangeLength
+                                     << " bytes of " << descriptor.getName() << " from byte " << rangeOffset;
+            storer->abort();
+        }
+        completion(descriptor, stored, sourceAddress);
+        return;
+    }
+    if (isRanged() && (!complete || failed || rangeOffset + contentReceived < descriptor.getSize())) {
+        // received part of the file is kept, the next request continues from its end
+        BOOST_LOG_TRIVIAL(debug) << "<<< received " << descriptor.getName() << ": "
+                                 << storer->getPartialSize() << " of " << descriptor.getSize()
+                                 << " bytes kept in " << storer->getPartialFilename();
+        storer->suspend();
+        // the requester learns at once that the file has not arrived
+        completion(descriptor, false, sourceAddress);
+        return;
+    }
+    if (!complete) {
+        // connection broke - partial file is dropped, and the sender is told the file has not been stored
+        storer->abort();
+        completion(descriptor, false, sourceAddress);
+        return;
+    }
+
+    bool stored = !failed;
+    if (stored) {
+        // digest was computed while writing; it covers the whole file, also the parts received before
+        auto receivedHash = storer->getStreamHash();
+        if (receivedHash != descriptor.getMd5()) {
+            BOOST_LOG_TRIVIAL(debug) << "<<< received " << descriptor.getName() << ": hashes differ!!! is: "
+                                     << receivedHash.getHash()
+                                     << " should be: " << descriptor.getMd5().getHash();
+            stored = false;
+        }
+    }
+
+    stored = stored && storer->commit();
+    if (!stored) {
+        storer->abort();
+    }
+    completion(descriptor, stored, sourceAddress);
+}
+
+size_t FileReceiver::parseHeader() {
+    size_t descriptorSize = DescriptorCodec::decode(headerBytes.data(), headerBytes.size(), descriptor);
+    if (descriptorSize == 0 || !isRanged()) {
+        return descriptorSize;
+    }
+    // FILE_TRANSFER tells which range has been sent
+    if (headerBytes.size() < descriptorSize + sizeof rangeOffset + sizeof rangeLength) {
+        return 0;
+    }
+    memcpy(&rangeOffset, headerBytes.data() + descriptorSize, sizeof rangeOffset);
+    memcpy(&rangeLength, headerBytes.data() + descriptorSize + sizeof rangeOffset, sizeof rangeLength);
+    return descriptorSize + sizeof rangeOffset + sizeof rangeLength;
+}
+
+bool FileReceiver::isRanged() const {
+    return messageType == MessageType::FILE_TRANSFER;
+}
+
+bool FileReceiver::isPartialRead() const {
+    return isRanged() && rangeLength != 0;
+}
+
+std::string FileReceiver::getStoredFileName() const {
+    // requested files are saved under their names, the others are kept in the store by their hashes
+    if (isPartialRead()) {
+        return getRangeFileName(descriptor.getName(), rangeOffset, rangeLength);
+    }
+    if (messageType == MessageType::FILE_TRANSFER) {
+        return descriptor.getName();
+    }
+    return descriptor.getMd5().getHash();
+}
@@ -1,40 +1,206 @@
+#include <fcntl.h>
+#include <cerrno>
 #include <memory>
 #include "Md5sum.hpp"
 
-Md5sum::Md5sum(const std::string &fn)
-	: filename(fn)
+namespace {
+	inline uint32_t rotateLeft(uint32_t value, uint32_t bits) {
+		return (value << bits) | (value >> (32 - bits));
+	}
+
+	// one operation of a round; constants are floor(abs(sin(i + 1)) * 2^32)
+	inline void stepF(uint32_t &a, uint32_t b, uint32_t c, uint32_t d, uint32_t word, uint32_t constant, uint32_t shift) {
+		a = b + rotateLeft(a + (d ^ (b & (c ^ d))) + word + constant, shift);
+	}
+
+	inline void stepG(uint32_t &a, uint32_t b, uint32_t c, uint32_t d, uint32_t word, uint32_t constant, uint32_t shift) {
+		a = b + rotateLeft(a + (c ^ (d & (b ^ c))) + word + constant, shift);
+	}
+
+	inline void stepH(uint32_t &a, uint32_t b, uint32_t c, uint32_t d, uint32_t word, uint32_t constant, uint32_t shift) {
+		a = b + rotateLeft(a + (b ^ c ^ d) + word + constant, shift);
+	}
+
+	inline void stepI(uint32_t &a, uint32_t b, uint32_t c, uint32_t d, uint32_t word, uint32_t constant, uint32_t shift) {
+		a = b + rotateLeft(a + (c ^ (b | ~d)) + word + constant, shift);
+	}
+}
+
+Md5sum::Md5sum()
+	: state{0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476}, length(0), buffer{}, finished(false)
 {
-	const int FILE_EXISTS_FLAG = F_OK | R_OK;
-	if( access( filename.c_str(), FILE_EXISTS_FLAG ) == -1 ) {
-	    throw std::invalid_argument(filename + " doesn't exist");
+}
+
+Md5sum::Md5sum(const std::string &filename)
+	: Md5sum()
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd == -1) {
+		throw std::invalid_argument(filename + " doesn't exist");
 	}
 
-	std::array<char, 500> buffer {0};
-	std::string cmd = "md5sum -b " + filename;
+	std::unique_ptr<uint8_t[]> block(new uint8_t[READ_BLOCK_SIZE]);
+	ssize_t bytesRead;
+	while ((bytesRead = read(fd, block.get(), READ_BLOCK_SIZE)) != 0) {
+		if (bytesRead < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			close(fd);
+			throw std::runtime_error("could not read " + filename);
+		}
+		update(block.get(), bytesRead);
+	}
+	close(fd);
+	finish();
+}
 
-	// excecute linux md5sum command
-	FILE *fp = popen(cmd.c_str(), "r");
-	fscanf(fp, "%s", buffer.data());
-	pclose(fp);
+Md5sum::Md5sum(std::istream &stream)
+	: Md5sum()
+{
+	std::unique_ptr<char[]> block(new char[READ_BLOCK_SIZE]);
+	while (stream.read(block.get(), READ_BLOCK_SIZE) || stream.gcount() > 0) {
+		update(block.get(), stream.gcount());
+	}
+	finish();
+}
 
-    hash = Md5Hash(buffer);
+void Md5sum::update(const void *data, size_t size) {
+	if (finished) {
+		throw std::logic_error("Md5sum::update(): digest has already been finished");
+	}
+	const uint8_t *bytes = (const uint8_t *) data;
+	size_t buffered = length % BLOCK_SIZE;
+	length += size;
+
+	// complete the block started by the previous update
+	if (buffered > 0) {
+		size_t missing = BLOCK_SIZE - buffered;
+		if (size < missing) {
+			memcpy(buffer + buffered, bytes, size);
+			return;
+		}
+		memcpy(buffer + buffered, bytes, missing);
+		transform(buffer);
+		bytes += missing;
+		size -= missing;
+	}
+
+	for (; size >= BLOCK_SIZE; bytes += BLOCK_SIZE, size -= BLOCK_SIZE) {
+		transform(bytes);
+	}
+	memcpy(buffer, bytes, size);
+}
+
+Md5Hash Md5sum::finish() {
+	if (finished) {
+		return hash;
+	}
+
+	// padding: 0x80, zeros up to 56 bytes of the block, message length in bits
+	uint64_t bitLength = length * 8;
+	uint8_t padding[BLOCK_SIZE] = {0x80};
+	size_t buffered = length % BLOCK_SIZE;
+	update(padding, buffered < 56 ? 56 - buffered : BLOCK_SIZE + 56 - buffered);
+
+	uint8_t lengthBytes[8];
+	for (int i = 0; i < 8; ++i) {
+		lengthBytes[i] = (uint8_t) (bitLength >> (8 * i));
+	}
+	update(lengthBytes, sizeof lengthBytes);
+
+	uint8_t digest[MD5_DIGEST_SIZE];
+	for (int i = 0; i < MD5_DIGEST_SIZE; ++i) {
+		digest[i] = (uint8_t) (state[i / 4] >> (8 * (i % 4)));
+	}
+	hash = Md5Hash::fromDigest(digest);
+	finished = true;
+	return hash;
 }
 
 Md5Hash Md5sum::getMd5Hash() const {
 	return hash;
 }
 
-Md5sum::Md5sum(std::istream &stream) {
-	std::string fileContent((std::istreambuf_iterator<char>(stream)),
-							 std::istreambuf_iterator<char>());
+void Md5sum::transform(const uint8_t *block) {
+	uint32_t x[16];
+	for (int i = 0; i < 16; ++i) {
+		x[i] = (uint32_t) block[4 * i] | (uint32_t) block[4 * i + 1] << 8
+			   | (uint32_t) block[4 * i + 2] << 16 | (uint32_t) block[4 * i + 3] << 24;
+	}
+
+	uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+
+	stepF(a, b, c, d, x[0], 0xd76aa478, 7);
+	stepF(d, a, b, c, x[1], 0xe8c7b756, 12);
+	stepF(c, d, a, b, x[2], 0x242070db, 17);
+	stepF(b, c, d, a, x[3], 0xc1bdceee, 22);
+	stepF(a, b, c, d, x[4], 0xf57c0faf, 7);
+	stepF(d, a, b, c, x[5], 0x4787c62a, 12);
+	stepF(c, d, a, b, x[6], 0xa8304613, 17);
+	stepF(b, c, d, a, x[7], 0xfd469501, 22);
+	stepF(a, b, c, d, x[8], 0x698098d8, 7);
+	stepF(d, a, b, c, x[9], 0x8b44f7af, 12);
+	stepF(c, d, a, b, x[10], 0xffff5bb1, 17);
+	stepF(b, c, d, a, x[11], 0x895cd7be, 22);
+	stepF(a, b, c, d, x[12], 0x6b901122, 7);
+	stepF(d, a, b, c, x[13], 0xfd987193, 12);
+	stepF(c, d, a, b, x[14], 0xa679438e, 17);
+	stepF(b, c, d, a, x[15], 0x49b40821, 22);
+
+	stepG(a, b, c, d, x[1], 0xf61e2562, 5);
+	stepG(d, a, b, c, x[6], 0xc040b340, 9);
+	stepG(c, d, a, b, x[11], 0x265e5a51, 14);
+	stepG(b, c, d, a, x[0], 0xe9b6c7aa, 20);
+	stepG(a, b, c, d, x[5], 0xd62f105d, 5);
+	stepG(d, a, b, c, x[10], 0x02441453, 9);
+	stepG(c, d, a, b, x[15], 0xd8a1e681, 14);
+	stepG(b, c, d, a, x[4], 0xe7d3fbc8, 20);
+	stepG(a, b, c, d, x[9], 0x21e1cde6, 5);
+	stepG(d, a, b, c, x[14], 0xc33707d6, 9);
+	stepG(c, d, a, b, x[3], 0xf4d50d87, 14);
+	stepG(b, c, d, a, x[8], 0x455a14ed, 20);
+	stepG(a, b, c, d, x[13], 0xa9e3e905, 5);
+	stepG(d, a, b, c, x[2], 0xfcefa3f8, 9);
+	stepG(c, d, a, b, x[7], 0x676f02d9, 14);
+	stepG(b, c, d, a, x[12], 0x8d2a4c8a, 20);
 
-    std::array<char, 500> buffer {0};
-    std::string cmd = "echo \"" + fileContent + "\" | md5sum";
+	stepH(a, b, c, d, x[5], 0xfffa3942, 4);
+	stepH(d, a, b, c, x[8], 0x8771f681, 11);
+	stepH(c, d, a, b, x[11], 0x6d9d6122, 16);
+	stepH(b, c, d, a, x[14], 0xfde5380c, 23);
+	stepH(a, b, c, d, x[1], 0xa4beea44, 4);
+	stepH(d, a, b, c, x[4], 0x4bdecfa9, 11);
+	stepH(c, d, a, b, x[7], 0xf6bb4b60, 16);
+	stepH(b, c, d, a, x[10], 0xbebfbc70, 23);
+	stepH(a, b, c, d, x[13], 0x289b7ec6, 4);
+	stepH(d, a, b, c, x[0], 0xeaa127fa, 11);
+	stepH(c, d, a, b, x[3], 0xd4ef3085, 16);
+	stepH(b, c, d, a, x[6], 0x04881d05, 23);
+	stepH(a, b, c, d, x[9], 0xd9d4d039, 4);
+	stepH(d, a, b, c, x[12], 0xe6db99e5, 11);
+	stepH(c, d, a, b, x[15], 0x1fa27cf8, 16);
+	stepH(b, c, d, a, x[2], 0xc4ac5665, 23);
 
-    // excecute linux md5sum command
-    FILE *fp = popen(cmd.c_str(), "r");
-    fscanf(fp, "%s", buffer.data());
-    pclose(fp);
+	stepI(a, b, c, d, x[0], 0xf4292244, 6);
+	stepI(d, a, b, c, x[7], 0x432aff97, 10);
+	stepI(c, d, a, b, x[14], 0xab9423a7, 15);
+	stepI(b, c, d, a, x[5], 0xfc93a039, 21);
+	stepI(a, b, c, d, x[12], 0x655b59c3, 6);
+	stepI(d, a, b, c, x[3], 0x8f0ccc92, 10);
+	stepI(c, d, a, b, x[10], 0xffeff47d, 15);
+	stepI(b, c, d, a, x[1], 0x85845dd1, 21);
+	stepI(a, b, c, d, x[8], 0x6fa87e4f, 6);
+	stepI(d, a, b, c, x[15], 0xfe2ce6e0, 10);
+	stepI(c, d, a, b, x[6], 0xa3014314, 15);
+	stepI(b, c, d, a, x[13], 0x4e0811a1, 21);
+	stepI(a, b, c, d, x[4], 0xf7537e82, 6);
+	stepI(d, a, b, c, x[11], 0xbd3af235, 10);
+	stepI(c, d, a, b, x[2], 0x2ad7d2bb, 15);
+	stepI(b, c, d, a, x[9], 0xeb86d391, 21);
 
-    hash = Md5Hash(buffer);
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
 }
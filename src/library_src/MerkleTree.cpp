@@ -0,0 +1,54 @@
+#include "MerkleTree.hpp"
+#include "CatalogLog.hpp"
+
+const unsigned MerkleTree::DEPTH;
+const size_t MerkleTree::LEAVES;
+const size_t MerkleTree::ROOT;
+
+MerkleTree::MerkleTree() : nodes(2 * LEAVES, 0) {
+}
+
+MerkleTree::MerkleTree(const std::vector<FileDescriptor> &descriptors) : MerkleTree() {
+    for (auto &&descriptor : descriptors) {
+        add(descriptor);
+    }
+}
+
+void MerkleTree::add(const FileDescriptor &descriptor) {
+    uint64_t hash = CatalogLog::digest(descriptor);
+    for (size_t node = getLeaf(descriptor.getMd5()); node >= ROOT; node /= 2) {
+        nodes[node] ^= hash;
+    }
+}
+
+uint64_t MerkleTree::getHash(size_t node) const {
+    return nodes[node];
+}
+
+bool MerkleTree::isNode(size_t node) {
+    return node >= ROOT && node < 2 * LEAVES;
+}
+
+bool MerkleTree::isLeaf(size_t node) {
+    return node >= LEAVES && node < 2 * LEAVES;
+}
+
+std::vector<size_t> MerkleTree::getDescendants(size_t node, unsigned levels) {
+    size_t first = node, count = 1;
+    while (levels-- > 0 && !isLeaf(first)) {
+        first *= 2;
+        count *= 2;
+    }
+    std::vector<size_t> descendants(count);
+    for (size_t i = 0; i < count; ++i) {
+        descendants[i] = first + i;
+    }
+    return descendants;
+}
+
+size_t MerkleTree::getLeaf(const Md5Hash &hash) {
+    const uint8_t *digest = hash.getDigest();
+    // first DEPTH bits of the digest
+    size_t prefix = ((size_t) digest[0] << 8 | digest[1]) >> (16 - DEPTH);
+    return LEAVES + prefix;
+}
@@ -0,0 +1,137 @@
+#include <string.h>
+
+#include "MessageBuilder.hpp"
+
+MessageBuilder::MessageBuilder() : attachedOffset(0), attachedLength(0), hasHeader(false)
+{
+}
+
+MessageBuilder::MessageBuilder(MessageType type) : attachedOffset(0), attachedLength(0), hasHeader(true)
+{
+	P2PMessage header{};
+	header.setMessageType(type);
+	header.setAdditionalDataSize(0);
+	appendToArena(&header, sizeof header);
+}
+
+MessageBuilder MessageBuilder::fromBytes(const uint8_t* data, size_t size)
+{
+	MessageBuilder message;
+	message.appendToArena(data, size);
+	return message;
+}
+
+MessageBuilder& MessageBuilder::setRequestId(uint32_t requestId)
+{
+	if (hasHeader)
+	{
+		((P2PMessage*) arena.data())->setRequestId(requestId);
+	}
+	return *this;
+}
+
+MessageType MessageBuilder::getMessageType() const
+{
+	return ((const P2PMessage*) arena.data())->getMessageType();
+}
+
+MessageBuilder& MessageBuilder::add(const void* data, size_t size)
+{
+	appendToArena(data, size);
+	growAdditionalData(size);
+	return *this;
+}
+
+void MessageBuilder::appendToArena(const void* data, size_t size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+
+	size_t offset = arena.size();
+	arena.insert(arena.end(), (const uint8_t*) data, (const uint8_t*) data + size);
+
+	// consecutive small parts make a single segment
+	if (!segments.empty() && segments.back().inArena
+			&& segments.back().arenaOffset + segments.back().size == offset)
+	{
+		segments.back().size += size;
+		return;
+	}
+	segments.emplace_back(offset, size);
+}
+
+void MessageBuilder::growAdditionalData(size_t size)
+{
+	if (!hasHeader)
+	{
+		return;
+	}
+	P2PMessage* header = (P2PMessage*) arena.data();
+	header->setAdditionalDataSize(header->getAdditionalDataSize() + size);
+}
+
+MessageBuilder& MessageBuilder::attachFile(const std::string& filename, uint64_t offset, uint64_t length)
+{
+	attachedFile = filename;
+	attachedOffset = offset;
+	attachedLength = length;
+	return *this;
+}
+
+const std::string& MessageBuilder::getAttachedFile() const
+{
+	return attachedFile;
+}
+
+uint64_t MessageBuilder::getAttachedFileOffset() const
+{
+	return attachedOffset;
+}
+
+uint64_t MessageBuilder::getAttachedFileLength() const
+{
+	return attachedLength;
+}
+
+void MessageBuilder::addAttachedFileSize(size_t fileSize)
+{
+	growAdditionalData(fileSize);
+}
+
+std::vector<iovec> MessageBuilder::getSegments() const
+{
+	std::vector<iovec> views;
+	views.reserve(segments.size());
+	for (auto &&segment : segments)
+	{
+		iovec view;
+		view.iov_base = segment.inArena ? (void*) (arena.data() + segment.arenaOffset) : (void*) segment.data;
+		view.iov_len = segment.size;
+		views.push_back(view);
+	}
+	return views;
+}
+
+size_t MessageBuilder::getSize() const
+{
+	size_t size = 0;
+	for (auto &&segment : segments)
+	{
+		size += segment.size;
+	}
+	return size;
+}
+
+bool MessageBuilder::isCompleteFrame() const
+{
+	// header is always at the beginning of the arena
+	if (arena.size() < sizeof(P2PMessage) || segments.empty() || !segments.front().inArena)
+	{
+		return false;
+	}
+	P2PMessage header;
+	memcpy(&header, arena.data(), sizeof header);
+	return getSize() == sizeof(P2PMessage) + header.getAdditionalDataSize();
+}
@@ -0,0 +1,146 @@
+#include <stdexcept>
+#include "NodeLoadTable.hpp"
+#include "Guard.hpp"
+
+void NodeLoadTable::addNode(in_addr_t node) {
+    Guard guard(mutex);
+    getEntry(node).registered = true;
+}
+
+void NodeLoadTable::removeNode(in_addr_t node) {
+    Guard guard(mutex);
+    auto entry = entries.find(node);
+    if (entry == entries.end()) {
+        return;
+    }
+    entry->second.registered = false;
+    removeIfUnused(node);
+}
+
+void NodeLoadTable::addFile(in_addr_t holder, uint64_t size) {
+    Guard guard(mutex);
+    Entry &entry = getEntry(holder);
+    ++entry.load.files;
+    changeBytes(holder, entry, size);
+}
+
+void NodeLoadTable::removeFile(in_addr_t holder, uint64_t size) {
+    Guard guard(mutex);
+    auto entry = entries.find(holder);
+    if (entry == entries.end()) {
+        return;
+    }
+    --entry->second.load.files;
+    changeBytes(holder, entry->second, -(int64_t) size);
+    removeIfUnused(holder);
+}
+
+void NodeLoadTable::reserve(in_addr_t node, uint64_t size) {
+    Guard guard(mutex);
+    changeBytes(node, getEntry(node), 0, size);
+}
+
+void NodeLoadTable::release(in_addr_t node, uint64_t size) {
+    Guard guard(mutex);
+    auto entry = entries.find(node);
+    if (entry == entries.end()) {
+        return;
+    }
+    changeBytes(node, entry->second, 0, -(int64_t) size);
+    removeIfUnused(node);
+}
+
+void NodeLoadTable::clear() {
+    Guard guard(mutex);
+    entries.clear();
+    byLoad.clear();
+    totalBytes = 0;
+}
+
+NodeLoadTable::NodeLoad NodeLoadTable::getLoad(in_addr_t node) const {
+    Guard guard(mutex);
+    auto entry = entries.find(node);
+    if (entry == entries.end()) {
+        return NodeLoad{0, 0, 0};
+    }
+    return entry->second.load;
+}
+
+bool NodeLoadTable::contains(in_addr_t node) const {
+    Guard guard(mutex);
+    return entries.count(node) != 0;
+}
+
+size_t NodeLoadTable::size() const {
+    Guard guard(mutex);
+    return entries.size();
+}
+
+bool NodeLoadTable::empty() const {
+    Guard guard(mutex);
+    return entries.empty();
+}
+
+uint64_t NodeLoadTable::getTotalBytes() const {
+    Guard guard(mutex);
+    return totalBytes;
+}
+
+uint64_t NodeLoadTable::getAverageLoad() const {
+    Guard guard(mutex);
+    return entries.empty() ? 0 : totalBytes / entries.size();
+}
+
+std::unordered_map<in_addr_t, NodeLoadTable::NodeLoad> NodeLoadTable::getLoads() const {
+    Guard guard(mutex);
+    std::unordered_map<in_addr_t, NodeLoad> loads;
+    for (auto &&entry : entries) {
+        loads.emplace(entry.first, entry.second.load);
+    }
+    return loads;
+}
+
+in_addr_t NodeLoadTable::findLeastLoaded() const {
+    Guard guard(mutex);
+    if (byLoad.empty()) {
+        throw std::logic_error("NodeLoadTable::findLeastLoaded(): no nodes");
+    }
+    return byLoad.begin()->second;
+}
+
+in_addr_t NodeLoadTable::findLeastLoadedExcept(in_addr_t excluded) const {
+    Guard guard(mutex);
+    // excluded node is skipped at most once
+    for (auto &&load : byLoad) {
+        if (load.second != excluded) {
+            return load.second;
+        }
+    }
+    throw std::logic_error("NodeLoadTable::findLeastLoadedExcept(): no other node");
+}
+
+NodeLoadTable::Entry &NodeLoadTable::getEntry(in_addr_t node) {
+    auto entry = entries.find(node);
+    if (entry == entries.end()) {
+        entry = entries.emplace(node, Entry{NodeLoad{0, 0, 0}, false}).first;
+        byLoad.emplace(0, node);
+    }
+    return entry->second;
+}
+
+void NodeLoadTable::changeBytes(in_addr_t node, Entry &entry, int64_t delta, int64_t reservedDelta) {
+    byLoad.erase(std::make_pair(entry.load.bytes + entry.load.reserved, node));
+    entry.load.bytes += delta;
+    entry.load.reserved += reservedDelta;
+    totalBytes += delta;
+    byLoad.emplace(entry.load.bytes + entry.load.reserved, node);
+}
+
+void NodeLoadTable::removeIfUnused(in_addr_t node) {
+    auto entry = entries.find(node);
+    if (entry->second.registered || entry->second.load.files > 0 || entry->second.load.reserved > 0) {
+        return;
+    }
+    byLoad.erase(std::make_pair(entry->second.load.bytes + entry->second.load.reserved, node));
+    entries.erase(entry);
+}
@@ -0,0 +1,105 @@
+#include "PendingOperations.hpp"
+#include "Guard.hpp"
+
+PendingOperations::PendingOperations(long timeoutMs, uint64_t minRate)
+        : timeout(std::chrono::milliseconds(timeoutMs)), minBytesPerSecond(minRate > 0 ? minRate : 1) {
+}
+
+PendingOperations::Future PendingOperations::add(MessageType request, const Md5Hash &hash, in_addr_t node,
+                                                 uint64_t size, const Callback &callback, Clock::time_point now) {
+    std::chrono::duration<double> transferTime((double) size / minBytesPerSecond);
+    Operation operation{node, now, now + timeout + std::chrono::duration_cast<Clock::duration>(transferTime),
+                        std::promise<Result>(), callback};
+    Future future = operation.done.get_future().share();
+
+    Guard guard(mutex);
+    operations.emplace(Key(request, hash), std::move(operation));
+    return future;
+}
+
+size_t PendingOperations::complete(MessageType request, const Md5Hash &hash, Status status,
+                                   const std::string &message) {
+    std::vector<Operation> completed;
+    {
+        Guard guard(mutex);
+        auto range = operations.equal_range(Key(request, hash));
+        for (auto operation = range.first; operation != range.second; ++operation) {
+            completed.push_back(std::move(operation->second));
+        }
+        operations.erase(range.first, range.second);
+    }
+    resolve(completed, status, message);
+    return completed.size();
+}
+
+size_t PendingOperations::failNode(in_addr_t node) {
+    std::vector<Operation> failed;
+    {
+        Guard guard(mutex);
+        for (auto operation = operations.begin(); operation != operations.end();) {
+            if (operation->second.node == node) {
+                failed.push_back(std::move(operation->second));
+                operation = operations.erase(operation);
+            } else {
+                ++operation;
+            }
+        }
+    }
+    resolve(failed, Status::NODE_LOST, "node has been lost");
+    return failed.size();
+}
+
+size_t PendingOperations::expire(Clock::time_point now) {
+    std::vector<Operation> expired;
+    {
+        Guard guard(mutex);
+        for (auto operation = operations.begin(); operation != operations.end();) {
+            if (operation->second.deadline <= now) {
+                expired.push_back(std::move(operation->second));
+                operation = operations.erase(operation);
+            } else {
+                ++operation;
+            }
+        }
+    }
+    resolve(expired, Status::TIMED_OUT, "no answer");
+    return expired.size();
+}
+
+void PendingOperations::cancelAll() {
+    std::vector<Operation> cancelled;
+    {
+        Guard guard(mutex);
+        for (auto &&operation : operations) {
+            cancelled.push_back(std::move(operation.second));
+        }
+        operations.clear();
+    }
+    resolve(cancelled, Status::CANCELLED, "session has ended");
+}
+
+size_t PendingOperations::size() const {
+    Guard guard(mutex);
+    return operations.size();
+}
+
+PendingOperations::Future PendingOperations::finished(Status status, const std::string &message,
+                                                      const Callback &callback) {
+    std::vector<Operation> operation(1);
+    operation.front().started = Clock::now();
+    operation.front().callback = callback;
+    Future future = operation.front().done.get_future().share();
+    resolve(operation, status, message);
+    return future;
+}
+
+void PendingOperations::resolve(std::vector<Operation> &operations, Status status, const std::string &message) {
+    Clock::time_point now = Clock::now();
+    for (auto &&operation : operations) {
+        Result result{status, message, operation.started, now - operation.started};
+        if (operation.callback) {
+            operation.callback(result);
+        }
+        operation.done.set_value(result);
+    }
+}
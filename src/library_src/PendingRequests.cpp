@@ -0,0 +1,118 @@
+#include "PendingRequests.hpp"
+#include "Guard.hpp"
+
+PendingRequests::PendingRequests(long timeoutMs) : timeout(std::chrono::milliseconds(timeoutMs)) {
+}
+
+uint32_t PendingRequests::add(const std::vector<in_addr_t> &nodes, Future &future, const Continuation &continuation,
+                              Clock::time_point now) {
+    std::vector<Request> completed;
+    uint32_t id;
+    {
+        Guard guard(mutex);
+        // ids wrap around skipping 0, which means no acknowledgement
+        do {
+            ++lastId;
+        } while (lastId == 0 || requests.count(lastId) != 0);
+        id = lastId;
+
+        Request &request = requests[id];
+        request.waitingFor.insert(nodes.begin(), nodes.end());
+        request.continuation = continuation;
+        request.deadline = now + timeout;
+        future = request.done.get_future().share();
+        if (request.waitingFor.empty()) {
+            completed.push_back(std::move(request));
+            requests.erase(id);
+        }
+    }
+    complete(completed, true);
+    return id;
+}
+
+bool PendingRequests::acknowledge(uint32_t id, in_addr_t node) {
+    std::vector<Request> completed;
+    {
+        Guard guard(mutex);
+        auto request = requests.find(id);
+        if (request == requests.end() || request->second.waitingFor.erase(node) == 0) {
+            return false;
+        }
+        if (request->second.waitingFor.empty()) {
+            completed.push_back(std::move(request->second));
+            requests.erase(request);
+        }
+    }
+    complete(completed, true);
+    return true;
+}
+
+void PendingRequests::failNode(in_addr_t node) {
+    std::vector<Request> failed;
+    {
+        Guard guard(mutex);
+        for (auto request = requests.begin(); request != requests.end();) {
+            if (request->second.waitingFor.count(node) != 0) {
+                failed.push_back(std::move(request->second));
+                request = requests.erase(request);
+            } else {
+                ++request;
+            }
+        }
+    }
+    complete(failed, false);
+}
+
+void PendingRequests::expire(Clock::time_point now) {
+    std::vector<Request> expired;
+    {
+        Guard guard(mutex);
+        for (auto request = requests.begin(); request != requests.end();) {
+            if (request->second.deadline <= now) {
+                expired.push_back(std::move(request->second));
+                request = requests.erase(request);
+            } else {
+                ++request;
+            }
+        }
+    }
+    complete(expired, false);
+}
+
+void PendingRequests::cancelAll() {
+    std::vector<Request> cancelled;
+    {
+        Guard guard(mutex);
+        for (auto &&request : requests) {
+            cancelled.push_back(std::move(request.second));
+        }
+        requests.clear();
+    }
+    complete(cancelled, false);
+}
+
+size_t PendingRequests::size() const {
+    Guard guard(mutex);
+    return requests.size();
+}
+
+bool PendingRequests::waitAll(const std::vector<Future> &futures, long timeoutMs) {
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    bool succeeded = true;
+    for (auto &&future : futures) {
+        if (future.wait_until(deadline) != std::future_status::ready) {
+            return false;
+        }
+        succeeded = future.get() && succeeded;
+    }
+    return succeeded;
+}
+
+void PendingRequests::complete(std::vector<Request> &requests, bool acknowledged) {
+    for (auto &&request : requests) {
+        request.done.set_value(acknowledged);
+        if (request.continuation) {
+            request.continuation(acknowledged);
+        }
+    }
+}
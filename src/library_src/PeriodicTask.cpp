@@ -0,0 +1,47 @@
+#include <chrono>
+#include "PeriodicTask.hpp"
+
+PeriodicTask::PeriodicTask(Task taskFunc, long period)
+        : task(std::move(taskFunc)), periodMs(period > 0 ? period : 1), stopping(false) {
+    thread = new Thread(&PeriodicTask::runHelper, (void *) this, NULL);
+}
+
+void *PeriodicTask::runHelper(void *periodicTask) {
+    ((PeriodicTask *) periodicTask)->run();
+    return NULL;
+}
+
+void PeriodicTask::run() {
+    typedef std::chrono::steady_clock Clock;
+
+    mutex.lock();
+    Clock::time_point next = Clock::now() + std::chrono::milliseconds(periodMs);
+    while (!stopping) {
+        long left = std::chrono::duration_cast<std::chrono::milliseconds>(next - Clock::now()).count();
+        if (left > 0) {
+            // woken up early only to stop
+            stopped.waitFor(mutex, left);
+            continue;
+        }
+        // period counts from the planned start, so slow tasks do not shift the schedule;
+        // runs missed meanwhile are skipped rather than caught up
+        next += std::chrono::milliseconds(periodMs);
+        if (next <= Clock::now()) {
+            next = Clock::now() + std::chrono::milliseconds(periodMs);
+        }
+        mutex.unlock();
+        task();
+        mutex.lock();
+    }
+    mutex.unlock();
+}
+
+PeriodicTask::~PeriodicTask() {
+    mutex.lock();
+    stopping = true;
+    stopped.notifyAll();
+    mutex.unlock();
+
+    thread->get();
+    delete thread;
+}
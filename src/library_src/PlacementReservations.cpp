@@ -0,0 +1,72 @@
+#include <iterator>
+#include "PlacementReservations.hpp"
+#include "Guard.hpp"
+
+PlacementReservations::PlacementReservations(NodeLoadTable &loadTable, long ttlMs)
+        : loads(loadTable), ttl(std::chrono::milliseconds(ttlMs)) {
+}
+
+void PlacementReservations::reserve(const Md5Hash &hash, in_addr_t node, uint64_t size, Clock::time_point now) {
+    Guard guard(mutex);
+    auto reservation = reservations.find(hash);
+    if (reservation != reservations.end()) {
+        remove(reservation);
+    }
+    Clock::time_point expires = now + ttl;
+    reservations.emplace(hash, Reservation{node, size, expires});
+    byExpiry.emplace(expires, hash);
+    loads.reserve(node, size);
+}
+
+bool PlacementReservations::release(const Md5Hash &hash) {
+    Guard guard(mutex);
+    auto reservation = reservations.find(hash);
+    if (reservation == reservations.end()) {
+        return false;
+    }
+    remove(reservation);
+    return true;
+}
+
+void PlacementReservations::releaseNode(in_addr_t node) {
+    Guard guard(mutex);
+    for (auto reservation = reservations.begin(); reservation != reservations.end();) {
+        auto next = std::next(reservation);
+        if (reservation->second.node == node) {
+            remove(reservation);
+        }
+        reservation = next;
+    }
+}
+
+void PlacementReservations::expire(Clock::time_point now) {
+    Guard guard(mutex);
+    while (!byExpiry.empty() && byExpiry.begin()->first <= now) {
+        remove(reservations.find(byExpiry.begin()->second));
+    }
+}
+
+void PlacementReservations::clear() {
+    Guard guard(mutex);
+    while (!reservations.empty()) {
+        remove(reservations.begin());
+    }
+}
+
+size_t PlacementReservations::size() const {
+    Guard guard(mutex);
+    return reservations.size();
+}
+
+void PlacementReservations::remove(std::unordered_map<Md5Hash, Reservation>::iterator reservation) {
+    // every reserved hash has exactly one entry among the ones expiring at the same time
+    auto range = byExpiry.equal_range(reservation->second.expires);
+    for (auto expiry = range.first; expiry != range.second; ++expiry) {
+        if (expiry->second == reservation->first) {
+            byExpiry.erase(expiry);
+            break;
+        }
+    }
+    loads.release(reservation->second.node, reservation->second.size);
+    reservations.erase(reservation);
+}
@@ -0,0 +1,73 @@
+#include <cmath>
+#include <stdexcept>
+#include "PlacementStrategy.hpp"
+#include "Guard.hpp"
+
+namespace {
+    uint64_t mix(uint64_t value) {
+        // splitmix64 finalizer
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ull;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebull;
+        return value ^ (value >> 31);
+    }
+}
+
+LeastLoadedPlacement::LeastLoadedPlacement(const NodeLoadTable &loadTable) : loads(loadTable) {
+}
+
+in_addr_t LeastLoadedPlacement::choose(const Md5Hash &/*hash*/, in_addr_t excluded) const {
+    return excluded == INADDR_NONE ? loads.findLeastLoaded() : loads.findLeastLoadedExcept(excluded);
+}
+
+bool LeastLoadedPlacement::isDeterministic() const {
+    return false;
+}
+
+void RendezvousPlacement::addNode(in_addr_t node, uint32_t weight) {
+    Guard guard(mutex);
+    weights[node] = weight > 0 ? weight : 1;
+}
+
+void RendezvousPlacement::removeNode(in_addr_t node) {
+    Guard guard(mutex);
+    weights.erase(node);
+}
+
+size_t RendezvousPlacement::size() const {
+    Guard guard(mutex);
+    return weights.size();
+}
+
+in_addr_t RendezvousPlacement::choose(const Md5Hash &hash, in_addr_t excluded) const {
+    Guard guard(mutex);
+    in_addr_t chosen = INADDR_NONE;
+    double bestScore = -1;
+    for (auto &&node : weights) {
+        if (node.first == excluded) {
+            continue;
+        }
+        double nodeScore = score(hash, node.first, node.second);
+        // ties broken by the address, so all the nodes choose the same one
+        if (nodeScore > bestScore || (nodeScore == bestScore && node.first < chosen)) {
+            bestScore = nodeScore;
+            chosen = node.first;
+        }
+    }
+    if (chosen == INADDR_NONE) {
+        throw std::logic_error("RendezvousPlacement::choose(): no nodes");
+    }
+    return chosen;
+}
+
+bool RendezvousPlacement::isDeterministic() const {
+    return true;
+}
+
+double RendezvousPlacement::score(const Md5Hash &hash, in_addr_t node, uint32_t weight) {
+    // uniform in (0, 1) for the pair; -weight / ln(u) makes the chance of winning proportional to the weight
+    uint64_t random = mix(hash.hashCode() ^ mix(node));
+    double uniform = ((random >> 11) + 0.5) / (double) (1ull << 53);
+    return -(double) weight / std::log(uniform);
+}
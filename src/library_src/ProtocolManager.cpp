@@ -5,13 +5,30 @@
 namespace p2p {
     namespace util {
         std::unordered_map<MessageType, std::function<void(const uint8_t *, uint32_t, in_addr_t)>> msgProcessors;
+        std::unordered_map<MessageType, FileReceiver::Completion> fileProcessors;
         std::shared_ptr<TcpServer> tcpServer;
         std::shared_ptr<UdpServer> udpServer;
+        std::shared_ptr<DescriptorBatcher> updatesBatcher;
+        std::shared_ptr<DescriptorBatcher> newFilesBatcher;
+        std::shared_ptr<DescriptorBatcher> revocationsBatcher;
+        std::shared_ptr<PeriodicTask> antiEntropy;
+        std::shared_ptr<Rebalancer> rebalancer;
+        std::shared_ptr<DescriptorBatcher> reservationsBatcher;
+        std::shared_ptr<DrainJob> drain;
+        std::shared_ptr<PlacementStrategy> placement;
+        uint32_t placementWeight = 1;
 
         std::vector<FileDescriptor> localDescriptors;
-        std::vector<FileDescriptor> networkDescriptors;
+        ShardedCatalog networkDescriptors;
+        PlacementReservations reservations(networkDescriptors.getLoads(), RESERVATION_TTL_MS);
         std::vector<in_addr_t> nodesAddresses;
+        CatalogLog localChanges;
+        std::unordered_map<in_addr_t, CatalogLog::Version> peerVersions;
+        std::unordered_map<in_addr_t, std::vector<FileDescriptor>> rememberedCatalogs;
         Mutex mutex;
+        PendingRequests pendingRequests(ACK_TIMEOUT_MS);
+        PendingOperations operations(OPERATION_TIMEOUT_MS, OPERATION_MIN_BYTES_PER_SECOND);
+        std::shared_ptr<PeriodicTask> expiry;
     }
 }
 
@@ -24,30 +41,77 @@ const char *p2p::getFormatedIp(in_addr_t addr) {
 }
 
 void p2p::endSession() {
+    // no more comparisons with the nodes we are leaving
+    util::antiEntropy.reset();
+    // remaining files are moved all at once below
+    util::rebalancer.reset();
+    // returns once the other nodes have acknowledged our SHUTDOWN
     util::quitFromNetwork();
-    usleep(100000);
     util::udpServer->stopListening();
     util::tcpServer->stopListening();
+    // publish updates which are still waiting for their batch
+    util::updatesBatcher.reset();
+    util::newFilesBatcher.reset();
+    util::revocationsBatcher.reset();
+    util::reservationsBatcher.reset();
+    util::reservations.clear();
+    // nobody will acknowledge anything now
+    util::expiry.reset();
+    util::pendingRequests.cancelAll();
+    util::operations.cancelAll();
 
-    // wait for performed actions
-    usleep(100000);
     Guard guard(util::mutex);
+    // the next session asks the nodes only for what has changed meanwhile
+    util::saveCatalogState();
     util::tcpServer.reset();
     util::tcpServer.reset();
 }
 
-void p2p::startSession() {
+void p2p::startSession(PlacementMode placementMode, uint32_t placementWeight) {
     // fire "new node state" timer
     // as long as the node is marked as "new" it collects all the HELLO_REPLY,
     // what is not what we want for older nodes
     using namespace util;
     initProcessingFunctions();
-    tcpServer = std::make_shared<TcpServer>(&processTcpMsg, &processTcpError);
+    tcpServer = std::make_shared<TcpServer>(&processTcpMsg, &processTcpError, TcpServer::Mode::EventLoop);
+    tcpServer->setStreamFactory(&createTcpStream);
+    tcpServer->setMissingFileCallback(&processMissingFile);
+    // this node is always a candidate for new files
+    networkDescriptors.getLoads().addNode(tcpServer->getLocalhostIp());
+    if (placementMode == PlacementMode::RENDEZVOUS) {
+        placement = std::make_shared<RendezvousPlacement>();
+    } else {
+        placement = std::make_shared<LeastLoadedPlacement>(networkDescriptors.getLoads());
+    }
+    util::placementWeight = placementWeight;
+    placement->addNode(tcpServer->getLocalhostIp(), placementWeight);
     udpServer = std::make_shared<UdpServer>(&processUdpMsg);
     udpServer->enableSelfBroadcasts();
+    updatesBatcher = std::make_shared<DescriptorBatcher>([](std::vector<FileDescriptor> &&descriptors) {
+        broadcastDescriptors(MessageType::UPDATE_DESCRIPTORS, descriptors);
+    }, DESCRIPTORS_BATCH_SIZE, DESCRIPTORS_LINGER_MS);
+    newFilesBatcher = std::make_shared<DescriptorBatcher>([](std::vector<FileDescriptor> &&descriptors) {
+        broadcastDescriptors(MessageType::NEW_FILES, descriptors);
+    }, DESCRIPTORS_BATCH_SIZE, DESCRIPTORS_LINGER_MS);
+    revocationsBatcher = std::make_shared<DescriptorBatcher>([](std::vector<FileDescriptor> &&descriptors) {
+        broadcastDescriptors(MessageType::REVOKE_FILES, descriptors);
+    }, DESCRIPTORS_BATCH_SIZE, DESCRIPTORS_LINGER_MS);
+    reservationsBatcher = std::make_shared<DescriptorBatcher>([](std::vector<FileDescriptor> &&descriptors) {
+        broadcastDescriptors(MessageType::RESERVE_PLACEMENTS, descriptors);
+    }, DESCRIPTORS_BATCH_SIZE, DESCRIPTORS_LINGER_MS);
+    rebalancer = std::make_shared<Rebalancer>(&moveLocalFile, REBALANCE_BYTES_PER_SECOND);
+    {
+        Guard guard(mutex);
+        loadCatalogState();
+    }
     tcpServer->startListening();
     udpServer->startListening();
     joinToNetwork();
+    antiEntropy = std::make_shared<PeriodicTask>(&syncWithRandomNode, ANTI_ENTROPY_PERIOD_MS);
+    expiry = std::make_shared<PeriodicTask>([]() {
+        pendingRequests.expire();
+        operations.expire();
+    }, EXPIRY_PERIOD_MS);
 }
 
 void p2p::util::processTcpError(SocketOperation operation) {
@@ -59,17 +123,53 @@ void p2p::util::processTcpError(SocketOperation operation) {
 }
 
 
+IncomingStream *p2p::util::createTcpStream(const P2PMessage &header, in_addr_t sourceAddress) {
+    // files are written to the disk as they arrive, other messages are processed whole
+    auto processor = fileProcessors.find(header.getMessageType());
+    if (processor == fileProcessors.end()) {
+        return nullptr;
+    }
+    return new FileReceiver(header.getMessageType(), sourceAddress, processor->second);
+}
+
+void p2p::util::processMissingFile(MessageType messageType, const std::string &filename, in_addr_t nodeAddress) {
+    if (messageType != MessageType::FILE_TRANSFER) {
+        // our own transfers; their files are only logged as missing
+        return;
+    }
+    // files are sent from the store, named by their hashes
+    sendCommandRefused(MessageType::GET_FILE, "file does not exist", nodeAddress, Md5Hash(filename));
+}
+
 void p2p::util::publishLostNode(in_addr_t nodeAddress) {
-    P2PMessage message{};
-    message.setMessageType(MessageType::CONNECTION_LOST);
-    message.setAdditionalDataSize(sizeof(in_addr_t));
-
-    // prepare buffer
-    std::vector<uint8_t> buffer(sizeof(P2PMessage) + message.getAdditionalDataSize());
-    memcpy(buffer.data(), (uint8_t *) &message, sizeof(P2PMessage));
-    memcpy(buffer.data() + sizeof(P2PMessage), (uint8_t *) &nodeAddress, sizeof(in_addr_t));
+    MessageBuilder message(MessageType::CONNECTION_LOST);
+    message.add(nodeAddress);
     // publish this information
-    udpServer->broadcast(buffer.data(), buffer.size());
+    udpServer->broadcast(message);
+}
+
+PendingRequests::Future p2p::util::requestAcks(MessageBuilder &message,
+                                               const PendingRequests::Continuation &continuation) {
+    std::vector<in_addr_t> nodes;
+    {
+        Guard guard(mutex);
+        nodes = nodesAddresses;
+    }
+    PendingRequests::Future acks;
+    message.setRequestId(pendingRequests.add(nodes, acks, continuation));
+    return acks;
+}
+
+void p2p::util::waitForAcks(const std::vector<PendingRequests::Future> &acks, const char *step) {
+    if (!PendingRequests::waitAll(acks, ACK_TIMEOUT_MS)) {
+        BOOST_LOG_TRIVIAL(debug) << "===> " << step << ": not acknowledged by all the nodes, going on";
+    }
+}
+
+void p2p::util::sendAck(uint32_t requestId, in_addr_t nodeAddress) {
+    MessageBuilder message(MessageType::ACK);
+    message.add(requestId);
+    tcpServer->sendMessage(std::move(message), nodeAddress);
 }
 
 void p2p::util::processTcpMsg(uint8_t *data, uint32_t size, SocketOperation operation) {
@@ -80,6 +180,10 @@ void p2p::util::processTcpMsg(uint8_t *data, uint32_t size, SocketOperation oper
     assert (additionalDataSize == p2pMessage.getAdditionalDataSize());
 
     msgProcessors.at(messageType)(additionalData, additionalDataSize, operation.connectionAddr);
+    if (p2pMessage.getRequestId() != 0 && operation.connectionAddr != tcpServer->getLocalhostIp()) {
+        // the message has been applied
+        sendAck(p2pMessage.getRequestId(), operation.connectionAddr);
+    }
 }
 
 void p2p::util::processUdpMsg(uint8_t *data, uint32_t size, SocketOperation operation) {
@@ -90,188 +194,365 @@ void p2p::util::processUdpMsg(uint8_t *data, uint32_t size, SocketOperation oper
     assert (additionalDataSize == p2pMessage.getAdditionalDataSize());
 
     msgProcessors.at(messageType)(additionalData, additionalDataSize, operation.connectionAddr);
+    if (p2pMessage.getRequestId() != 0 && operation.connectionAddr != tcpServer->getLocalhostIp()) {
+        // the message has been applied
+        sendAck(p2pMessage.getRequestId(), operation.connectionAddr);
+    }
 }
 
 void p2p::util::joinToNetwork() {
-    P2PMessage message{};
-    message.setMessageType(MessageType::HELLO);
-    message.setAdditionalDataSize(0u);
-    uint32_t messageSize = sizeof(P2PMessage);
+    // versions of the catalogs we still remember, so the nodes send only what has changed since
+    MessageBuilder message(MessageType::HELLO);
+    message.add(placementWeight);
+    size_t knownVersions;
+    {
+        Guard guard(mutex);
+        for (auto &&peerVersion : peerVersions) {
+            message.add(peerVersion.first).add(peerVersion.second.epoch).add(peerVersion.second.sequence);
+        }
+        knownVersions = peerVersions.size();
+    }
+    udpServer->broadcast(message);
+    BOOST_LOG_TRIVIAL(debug) << ">>> HELLO: joining to network; " << knownVersions << " catalog versions known";
+}
 
-    udpServer->broadcast((uint8_t *) &message, messageSize);
-    BOOST_LOG_TRIVIAL(debug) << ">>> HELLO: joining to network";
+MessageBuilder p2p::util::buildCatalogReply(const CatalogLog::Version &since) {
+    std::vector<FileDescriptor> put, removed;
+    uint8_t full;
+    CatalogLog::Version version;
+    uint64_t digest;
+    {
+        Guard guard(mutex);
+        full = !localChanges.getChangesSince(since, put, removed);
+        if (full) {
+            put = localDescriptors;
+        }
+        version = localChanges.getVersion();
+        digest = CatalogLog::digest(localDescriptors);
+    }
+
+    std::vector<uint8_t> putRecords = DescriptorCodec::encode(put);
+    std::vector<uint8_t> removedRecords = DescriptorCodec::encode(removed);
+    MessageBuilder message(MessageType::HELLO_REPLY);
+    message.add(placementWeight).add(full).add(version.epoch).add(version.sequence).add(digest).add((uint32_t) putRecords.size())
+           .addPayload(std::move(putRecords))
+           .addPayload(std::move(removedRecords));
+    BOOST_LOG_TRIVIAL(debug) << ">>> HELLO_REPLY: " << (full ? "all " : "changed ") << put.size()
+                             << " descriptors, " << removed.size() << " removed";
+    return message;
+}
+
+void p2p::util::requestCatalog(in_addr_t nodeAddress) {
+    // epoch 0 is never used, so the node sends all its descriptors
+    MessageBuilder message(MessageType::CATALOG_REQUEST);
+    message.add((uint64_t) 0).add((uint64_t) 0);
+    tcpServer->sendMessage(std::move(message), nodeAddress);
+    BOOST_LOG_TRIVIAL(debug) << ">>> CATALOG_REQUEST: to " << getFormatedIp(nodeAddress);
+}
+
+void p2p::util::forgetPeerVersion(in_addr_t nodeAddress) {
+    // mutex already acquired; descriptors of the node are gone, so the next join needs all of them
+    peerVersions.erase(nodeAddress);
+    rememberedCatalogs.erase(nodeAddress);
+}
+
+void p2p::util::saveCatalogState() {
+    CatalogState state;
+    state.log = localChanges;
+    state.peerVersions = peerVersions;
+    for (auto &&peerVersion : peerVersions) {
+        // catalogs of the nodes which have not replied this session are saved as they were remembered
+        auto remembered = rememberedCatalogs.find(peerVersion.first);
+        state.peerCatalogs[peerVersion.first] = remembered != rememberedCatalogs.end()
+                                                ? remembered->second
+                                                : networkDescriptors.findByHolder(peerVersion.first);
+    }
+    if (!state.save(CATALOG_STATE_FILE)) {
+        BOOST_LOG_TRIVIAL(warning) << "===> catalog state could not be saved, the next join gets all the catalogs";
+        return;
+    }
+    BOOST_LOG_TRIVIAL(debug) << "===> catalog state saved: version " << localChanges.getVersion().sequence
+                             << ", " << peerVersions.size() << " peer catalogs";
 }
 
-void p2p::util::quitFromNetwork() {
-    P2PMessage message{};
-    message.setMessageType(MessageType::DISCONNECTING);
-    message.setAdditionalDataSize(0u);
-    uint32_t messageSize = sizeof(P2PMessage);
+void p2p::util::loadCatalogState() {
+    CatalogState state;
+    if (!state.load(CATALOG_STATE_FILE)) {
+        // first start, or nothing worth keeping - the nodes send their whole catalogs
+        return;
+    }
+    localChanges = state.log;
+    for (auto &&peerVersion : state.peerVersions) {
+        if (peerVersions.count(peerVersion.first) == 0) {
+            // catalogs still known from the previous session in this process are more recent
+            peerVersions[peerVersion.first] = peerVersion.second;
+            rememberedCatalogs[peerVersion.first] = std::move(state.peerCatalogs[peerVersion.first]);
+        }
+    }
+    BOOST_LOG_TRIVIAL(debug) << "===> catalog state loaded: version " << localChanges.getVersion().sequence
+                             << ", " << rememberedCatalogs.size() << " peer catalogs";
+}
+
+std::vector<FileDescriptor> p2p::util::getHeldDescriptors(in_addr_t holder) {
+    if (holder == tcpServer->getLocalhostIp()) {
+        Guard guard(mutex);
+        return localDescriptors;
+    }
+    return networkDescriptors.findByHolder(holder);
+}
+
+void p2p::util::syncWithRandomNode() {
+    in_addr_t thisHostAddress = tcpServer->getLocalhostIp();
+    in_addr_t nodeAddress;
+    {
+        Guard guard(mutex);
+        std::vector<in_addr_t> otherNodes;
+        std::copy_if(nodesAddresses.begin(), nodesAddresses.end(), std::back_inserter(otherNodes),
+                     [thisHostAddress](in_addr_t address) { return address != thisHostAddress; });
+        if (otherNodes.empty()) {
+            return;
+        }
+        nodeAddress = otherNodes[rand() % otherNodes.size()];
+    }
+
+    // holder of the files is the authority on them, so its view is the one which is spread
+    for (in_addr_t holder : {nodeAddress, thisHostAddress}) {
+        MerkleTree tree(getHeldDescriptors(holder));
+        MessageBuilder message(MessageType::SYNC_HASHES);
+        message.add(holder).add((uint16_t) MerkleTree::ROOT).add(tree.getHash(MerkleTree::ROOT));
+        tcpServer->sendMessage(std::move(message), nodeAddress);
+    }
+    BOOST_LOG_TRIVIAL(debug) << ">>> SYNC_HASHES: comparing catalogs with " << getFormatedIp(nodeAddress);
+}
+
+void p2p::util::sendSyncLeaves(in_addr_t holder, const std::vector<uint16_t> &leaves, in_addr_t nodeAddress) {
+    MessageBuilder message(MessageType::SYNC_LEAVES);
+    message.add(holder).add((uint16_t) leaves.size());
+    for (uint16_t leaf : leaves) {
+        message.add(leaf);
+    }
 
-    udpServer->broadcast((uint8_t *) &message, messageSize);
+    size_t sentDescriptors = 0;
+    if (holder == tcpServer->getLocalhostIp()) {
+        std::unordered_set<size_t> requestedLeaves(leaves.begin(), leaves.end());
+        std::vector<FileDescriptor> descriptors;
+        for (auto &&descriptor : getHeldDescriptors(holder)) {
+            if (requestedLeaves.count(MerkleTree::getLeaf(descriptor.getMd5())) != 0) {
+                descriptors.push_back(descriptor);
+            }
+        }
+        sentDescriptors = descriptors.size();
+        message.addPayload(DescriptorCodec::encode(descriptors));
+    }
+    tcpServer->sendMessage(std::move(message), nodeAddress);
+    BOOST_LOG_TRIVIAL(debug) << ">>> SYNC_LEAVES: " << leaves.size() << " ranges differ, "
+                             << sentDescriptors << " descriptors sent to " << getFormatedIp(nodeAddress);
+}
+
+void p2p::util::quitFromNetwork() {
+    udpServer->broadcast(MessageBuilder(MessageType::DISCONNECTING));
     BOOST_LOG_TRIVIAL(debug) << ">>> DISCONNECTING: start node closing procedure";
     moveLocalDescriptorsIntoOtherNodes();
-    sendShutdown();
+    waitForAcks({sendShutdown()}, "SHUTDOWN");
 }
 
 
-void p2p::util::sendShutdown() {
-    P2PMessage message{};
-    message.setMessageType(MessageType::SHUTDOWN);
-    message.setAdditionalDataSize(0);
+PendingRequests::Future p2p::util::sendShutdown() {
     BOOST_LOG_TRIVIAL(debug) << ">>> SHUTDOWN: node is closing";
 
-    udpServer->broadcast((uint8_t *) &message, sizeof(P2PMessage));
+    MessageBuilder message(MessageType::SHUTDOWN);
+    PendingRequests::Future acks = requestAcks(message);
+    udpServer->broadcast(message);
+    return acks;
 }
 
 void p2p::util::moveLocalDescriptorsIntoOtherNodes() {
-    // we already have mutex taken in p2p::util::endSession()
-
-    for (auto &&localDescriptor : localDescriptors) {
-        discardDescriptor(localDescriptor);
+    std::vector<FileDescriptor> descriptors;
+    {
+        Guard guard(mutex);
+        for (auto &&localDescriptor : localDescriptors) {
+            localDescriptor.makeUnvalid();
+            localChanges.put(localDescriptor);
+        }
+        descriptors = localDescriptors;
     }
+    std::vector<PendingRequests::Future> discarded;
+    broadcastDescriptors(MessageType::DISCARD_DESCRIPTORS, descriptors, &discarded);
+    BOOST_LOG_TRIVIAL(debug) << ">>> DISCARD_DESCRIPTORS: " << descriptors.size() << " descriptors";
 
     // wait for our discards
-    usleep(100000);
-
-    for (auto &&localDescriptor : localDescriptors) {
+    waitForAcks(discarded, "DISCARD_DESCRIPTORS");
+
+    // largest files first, each to the node least loaded with the files planned so far;
+    // reservations keep the transfers in flight in the loads until their UPDATE_DESCRIPTOR
+    std::sort(descriptors.begin(), descriptors.end(), [](const FileDescriptor &first, const FileDescriptor &second) {
+        return first.getSize() > second.getSize();
+    });
+    std::unordered_map<Md5Hash, FileDescriptor> drained;
+    std::vector<RebalancePlanner::Move> moves;
+    for (auto &&descriptor : descriptors) {
         in_addr_t nodeToSend;
         try {
-            nodeToSend = findOtherLeastLoadedNode();
+            nodeToSend = findOtherHolderNode(descriptor.getMd5());
         } catch (std::logic_error &e) {
             BOOST_LOG_TRIVIAL(debug) << "===> endSession: no other node exists, current files will be lost";
             // no need to revoke file: noone is listening
-            localDescriptors.clear();
-            return;
+            break;
         }
-        changeHolderNode(localDescriptor, nodeToSend);
+        reservations.reserve(descriptor.getMd5(), nodeToSend, descriptor.getSize());
+        moves.push_back({descriptor.getMd5(), descriptor.getSize(), nodeToSend});
+        drained.emplace(descriptor.getMd5(), descriptor);
+    }
+
+    auto job = std::make_shared<DrainJob>(std::move(moves), DRAIN_CONCURRENCY, DRAIN_CONFIRM_TIMEOUT_MS,
+                                          DRAIN_MIN_BYTES_PER_SECOND);
+    std::atomic_store(&drain, job);
+    job->run([&drained](const RebalancePlanner::Move &move) {
+        FileDescriptor descriptor = drained.at(move.hash);
+        changeHolderNode(descriptor, move.target);
+    }, [](const RebalancePlanner::Move &move) {
+        in_addr_t nodeToSend;
+        try {
+            nodeToSend = findOtherHolderNode(move.hash);
+        } catch (std::logic_error &e) {
+            reservations.release(move.hash);
+            return (in_addr_t) INADDR_NONE;
+        }
+        reservations.reserve(move.hash, nodeToSend, move.size);
+        return nodeToSend;
+    }, [](const DrainJob::Progress &progress) {
+        BOOST_LOG_TRIVIAL(info) << "===> endSession: " << progress.confirmedFiles << "/" << progress.totalFiles
+                                << " files (" << progress.confirmedBytes << "/" << progress.totalBytes
+                                << " bytes) taken over by other nodes, " << progress.failedFiles << " lost";
+    }, DRAIN_REPORT_PERIOD_MS);
+    std::atomic_store(&drain, std::shared_ptr<DrainJob>());
+
+    Guard guard(mutex);
+    for (auto &&localDescriptor : localDescriptors) {
+        localChanges.remove(localDescriptor);
     }
     localDescriptors.clear();
 }
 
-void p2p::util::discardDescriptor(FileDescriptor &descriptor) {
-    descriptor.makeUnvalid();
+void p2p::util::failDrainTarget(in_addr_t nodeAddress) {
+    std::shared_ptr<DrainJob> job = std::atomic_load(&drain);
+    if (job) {
+        job->failNode(nodeAddress);
+    }
+}
 
-    P2PMessage message{};
-    message.setMessageType(MessageType::DISCARD_DESCRIPTOR);
-    message.setAdditionalDataSize(sizeof(FileDescriptor));
+PendingRequests::Future p2p::util::discardDescriptor(FileDescriptor &descriptor,
+                                                    const PendingRequests::Continuation &continuation) {
+    descriptor.makeUnvalid();
 
-    // build a message
-    std::vector<uint8_t> buffer(sizeof(P2PMessage) + sizeof(FileDescriptor));
-    memcpy(buffer.data(), (uint8_t *) &message, sizeof(P2PMessage));
-    memcpy(buffer.data() + sizeof(P2PMessage), (uint8_t *) &descriptor, sizeof(FileDescriptor));
-    udpServer->broadcast(buffer.data(), buffer.size());
+    MessageBuilder message(MessageType::DISCARD_DESCRIPTOR);
+    message.addPayload(DescriptorCodec::encode(descriptor));
+    PendingRequests::Future discarded = requestAcks(message, continuation);
+    udpServer->broadcast(message);
     BOOST_LOG_TRIVIAL(debug) << ">>> DISCARD_DESCRIPTOR: " << descriptor.getName()
                              << " md5: " << descriptor.getMd5().getHash();
+    return discarded;
 }
 
-in_addr_t p2p::util::findLeastLoadedNode() {
-    Guard guard(mutex);
-    if (networkDescriptors.empty() || nodesAddresses.empty()) {
-        return tcpServer->getLocalhostIp();
+in_addr_t p2p::util::reserveHolderNode(const FileDescriptor &descriptor) {
+    in_addr_t holder;
+    {
+        // choice and reservation have to be atomic for the uploads from many threads
+        Guard guard(mutex);
+        reservations.expire();
+        holder = nodesAddresses.empty() ? tcpServer->getLocalhostIp() : placement->choose(descriptor.getMd5());
+        reservations.reserve(descriptor.getMd5(), holder, descriptor.getSize());
     }
-
-    std::unordered_map<in_addr_t, int> nodesLoad;
-
-    nodesLoad[tcpServer->getLocalhostIp()] = 0;
-
-    // initialize loads
-    for (auto &&address : nodesAddresses) {
-        nodesLoad[address] = 0;
+    // loads are not consulted by the deterministic placement, so the other nodes do not need to know
+    if (!placement->isDeterministic()) {
+        FileDescriptor reservation = descriptor;
+        reservation.setHolderIp(holder);
+        reservation.makeValid();
+        reservationsBatcher->add(reservation);
     }
+    return holder;
+}
 
-    // count uses
-    for (auto &&descriptor : networkDescriptors) {
-        nodesLoad[descriptor.getHolderIp()] += descriptor.getSize();
+void p2p::util::releaseHolderNode(FileDescriptor descriptor) {
+    reservations.release(descriptor.getMd5());
+    if (!placement->isDeterministic()) {
+        descriptor.makeUnvalid();
+        reservationsBatcher->add(descriptor);
     }
-
-    // find min element
-    auto mapElement = std::min_element(nodesLoad.begin(), nodesLoad.end(),
-                                       [](const std::pair<in_addr_t, int> &p1,
-                                          const std::pair<in_addr_t, int> &p2) {
-                                           return p1.second < p2.second;
-                                       });
-    return mapElement->first;
 }
 
-in_addr_t p2p::util::findOtherLeastLoadedNode() {
+in_addr_t p2p::util::findOtherHolderNode(const Md5Hash &hash) {
     Guard guard(mutex);
-    if (networkDescriptors.empty() || nodesAddresses.empty()) {
-        throw std::logic_error("p2p::util::findOtherLeasLoadedNode(): other node not exist");
-    }
-
-    in_addr_t thisNodeAddress = tcpServer->getLocalhostIp();
-
-    // map for easier collection of data
-    std::unordered_map<in_addr_t, unsigned long> nodesLoad;
-
-    // initialize loads
-    for (auto &&address : nodesAddresses) {
-        nodesLoad[address] = 0;
-    }
-
-    // count load
-    for (auto &&descriptor : networkDescriptors) {
-        nodesLoad[descriptor.getHolderIp()] += descriptor.getSize();
+    if (nodesAddresses.empty() || (!placement->isDeterministic() && networkDescriptors.empty())) {
+        throw std::logic_error("p2p::util::findOtherHolderNode(): other node not exist");
     }
+    return placement->choose(hash, tcpServer->getLocalhostIp());
+}
 
-    in_addr_t leastLoadNode{};
-    unsigned long min = ULONG_MAX;
-    // find min element
-    for (auto &&nodeLoad : nodesLoad) {
-        if (nodeLoad.second < min && nodeLoad.first != thisNodeAddress) {
-            min = nodeLoad.second;
-            leastLoadNode = nodeLoad.first;
-        }
-    }
+void p2p::util::addNodeAddress(in_addr_t address, uint32_t weight) {
+    // mutex already acquired
+    nodesAddresses.push_back(address);
+    networkDescriptors.getLoads().addNode(address);
+    placement->addNode(address, weight);
+}
 
-    // if any other node is not found
-    if (min == ULONG_MAX) {
-        throw std::logic_error("p2p::util::findOtherLeasLoadedNode(): other node not exist");
+void p2p::util::removeNodeAddress(in_addr_t address) {
+    // mutex already acquired
+    nodesAddresses.erase(std::remove(nodesAddresses.begin(), nodesAddresses.end(), address), nodesAddresses.end());
+    if (address != tcpServer->getLocalhostIp()) {
+        networkDescriptors.getLoads().removeNode(address);
+        placement->removeNode(address);
+        reservations.releaseNode(address);
     }
-    return leastLoadNode;
 }
 
 void p2p::util::changeHolderNode(FileDescriptor &descriptor, in_addr_t newNodeAddress) {
-    P2PMessage message{};
-    message.setMessageType(MessageType::HOLDER_CHANGE);
-
     // preset new holder IP
     descriptor.setHolderIp(newNodeAddress);
 
-    // get file as array
-    auto fileContent = getFileContent(descriptor.getMd5().getHash());
-
-    message.setAdditionalDataSize(sizeof(FileDescriptor) + fileContent.size());
-
-    std::vector<uint8_t> buffer(sizeof(P2PMessage) + message.getAdditionalDataSize());
-
-    // prepare message
-    memcpy(buffer.data(), (uint8_t *) &message, sizeof(P2PMessage));
-    // put descriptor
-    memcpy(buffer.data() + sizeof(P2PMessage), (uint8_t *) &descriptor, sizeof(FileDescriptor));
-    // put file content
-    memcpy(buffer.data() + sizeof(P2PMessage) + sizeof(FileDescriptor), fileContent.data(), fileContent.size());
-
-    tcpServer->sendData(buffer.data(), buffer.size(), newNodeAddress);
+    // file stored by its hash goes after the descriptor
+    sendDescriptorWithFile(MessageType::HOLDER_CHANGE, descriptor, descriptor.getMd5().getHash(), newNodeAddress);
     BOOST_LOG_TRIVIAL(debug) << ">>> HOLDER_CHANGE: " << descriptor.getName() << " to "
                              << getFormatedIp(newNodeAddress);
 }
 
-std::vector<uint8_t> p2p::util::getFileContent(const std::string &name) {
-    FileLoader loader(name);
-    return loader.getContent();
+void p2p::util::sendDescriptorWithFile(MessageType messageType, const FileDescriptor &descriptor,
+                                       const std::string &filename, in_addr_t address) {
+    MessageBuilder message(messageType);
+    // file content is not loaded - kernel copies it from the page cache to the socket
+    message.addPayload(DescriptorCodec::encode(descriptor)).attachFile(filename);
+    tcpServer->sendMessage(std::move(message), address);
 }
 
-void p2p::util::storeFileContent(std::vector<uint8_t> &content, const std::string &name) {
-    FileStorer storer(name);
-    storer.storeFile(content);
+bool p2p::util::copyFile(const std::string &from, const std::string &to, uint64_t offset, uint64_t length) {
+    try {
+        // content goes straight from the mapped source into the target
+        auto content = FileLoader(from).map();
+        offset = std::min<uint64_t>(offset, content.size());
+        if (length == 0 || length > content.size() - offset) {
+            length = content.size() - offset;
+        }
+        return FileStorer(to).storeFile(content.data() + offset, length);
+    } catch (std::runtime_error &e) {
+        BOOST_LOG_TRIVIAL(error) << "===> copy " << from << " to " << to << " failed: " << e.what();
+        return false;
+    }
 }
 
 bool p2p::uploadFile(std::string name) {
+    return util::isStarted(async::uploadFile(name));
+}
+
+p2p::async::Operation p2p::async::uploadFile(const std::string &name, const PendingOperations::Callback &callback) {
     using namespace util;
     // create new descriptor (autofill MD5 and its size)
-    FileDescriptor newDescriptor(name);
+    FileDescriptor newDescriptor;
+    try {
+        newDescriptor = FileDescriptor(name);
+    } catch (std::invalid_argument &e) {
+        BOOST_LOG_TRIVIAL(info) << "===> UploadFile: " << e.what();
+        return PendingOperations::finished(PendingOperations::Status::FAILED, e.what(), callback);
+    }
 
     // set upload time
     newDescriptor.setUploadTime(std::time(nullptr));
@@ -280,8 +561,16 @@ bool p2p::uploadFile(std::string name) {
     // set owner id as this host
     newDescriptor.setOwnerIp(thisHostAddress);
 
-    // find least loaded node
-    in_addr_t leastLoadNodeAddress = util::findLeastLoadedNode();
+    // check if descriptor is unique
+    if (!isDescriptorUnique(newDescriptor)) {
+        BOOST_LOG_TRIVIAL(debug) << "===> UploadFile: hashes collision! " << newDescriptor.getName()
+                                 << " md5: " << newDescriptor.getMd5().getHash()
+                                 << "; choose another file!";
+        return PendingOperations::finished(PendingOperations::Status::FAILED, "hashes collision", callback);
+    }
+
+    // find node for the file; it counts as loaded with the file until NEW_FILE arrives
+    in_addr_t leastLoadNodeAddress = util::reserveHolderNode(newDescriptor);
 
     // set holder IP
     newDescriptor.setHolderIp(leastLoadNodeAddress);
@@ -289,21 +578,18 @@ bool p2p::uploadFile(std::string name) {
     // make descriptor valid
     newDescriptor.makeValid();
 
-    // check if descriptor is unique
-    {
-        Guard guard(mutex);
-        if (!isDescriptorUnique(newDescriptor)) {
-            BOOST_LOG_TRIVIAL(debug) << "===> UploadFile: hashes collision! " << newDescriptor.getName()
-                                     << " md5: " << newDescriptor.getMd5().getHash()
-                                     << "; choose another file!";
-            return false;
-        }
-    }
+    // completed by NEW_FILE of the holder
+    Operation operation = operations.add(MessageType::UPLOAD_FILE, newDescriptor.getMd5(), leastLoadNodeAddress,
+                                         newDescriptor.getSize(), callback);
 
     if (leastLoadNodeAddress == thisHostAddress) {
         // store file with name as its md5
-        auto fileContent = util::getFileContent(newDescriptor.getName());
-        util::storeFileContent(fileContent, newDescriptor.getMd5().getHash());
+        if (!util::copyFile(newDescriptor.getName(), newDescriptor.getMd5().getHash())) {
+            util::releaseHolderNode(newDescriptor);
+            operations.complete(MessageType::UPLOAD_FILE, newDescriptor.getMd5(),
+                                PendingOperations::Status::FAILED, "file not stored");
+            return operation;
+        }
 
         // we are the least load node - only publish the descriptor
         util::publishDescriptor(newDescriptor);
@@ -311,200 +597,250 @@ bool p2p::uploadFile(std::string name) {
 
         Guard guard(util::mutex);
         util::localDescriptors.push_back(newDescriptor);
-        return true;
+        util::localChanges.put(newDescriptor);
+        return operation;
     }
 
     util::uploadFile(newDescriptor);
     BOOST_LOG_TRIVIAL(debug) << "===> UploadFile: " << newDescriptor.getName()
                              << " saved in node " << getFormatedIp(leastLoadNodeAddress);
-    return true;
+    return operation;
 }
 
 void p2p::util::publishDescriptor(FileDescriptor &descriptor) {
-    P2PMessage message{};
-    message.setMessageType(MessageType::NEW_FILE);
-    message.setAdditionalDataSize(sizeof(FileDescriptor));
-
-    // prepare buffer
-    std::vector<uint8_t> buffer(sizeof(P2PMessage) + message.getAdditionalDataSize());
+    // NEW_FILES of the uploads finishing at the same time share their datagrams
+    newFilesBatcher->add(descriptor);
+}
+
+void p2p::util::broadcastDescriptors(MessageType batchType, const std::vector<FileDescriptor> &descriptors,
+                                     std::vector<PendingRequests::Future> *acks) {
+    // records have variable length - pack as many of them as fits into the datagram
+    const size_t datagramCapacity = UdpServer::MAX_DATAGRAM_SIZE - sizeof(P2PMessage);
+    std::vector<uint8_t> records;
+    auto broadcastRecords = [batchType, acks, &records]() {
+        MessageBuilder message(batchType);
+        message.addPayload(std::move(records));
+        if (acks != nullptr) {
+            acks->push_back(requestAcks(message));
+        }
+        udpServer->broadcast(message);
+        records.clear();
+    };
+    for (auto &&descriptor : descriptors) {
+        std::vector<uint8_t> record = DescriptorCodec::encode(descriptor);
+        if (!records.empty() && records.size() + record.size() > datagramCapacity) {
+            broadcastRecords();
+        }
+        records.insert(records.end(), record.begin(), record.end());
+    }
+    if (!records.empty()) {
+        broadcastRecords();
+    }
+}
 
-    // put into buffer P2Pmessage and new's file's descriptor
-    memcpy(buffer.data(), &message, sizeof(P2PMessage));
-    memcpy(buffer.data() + sizeof(P2PMessage), &descriptor, sizeof(FileDescriptor));
+void p2p::util::uploadFile(FileDescriptor &descriptor) {
+    // send file specified by user
+    in_addr_t holderNode = descriptor.getHolderIp();
+    sendDescriptorWithFile(MessageType::UPLOAD_FILE, descriptor, descriptor.getName(), holderNode);
+}
 
-    udpServer->broadcast(buffer.data(), buffer.size());
+bool p2p::getFile(std::string name) {
+    return util::isStarted(async::getFile(name));
 }
 
-void p2p::util::uploadFile(FileDescriptor &descriptor) {
-    P2PMessage message{};
-    message.setMessageType(MessageType::UPLOAD_FILE);
-    // load file specified by user
-    auto fileContent = getFileContent(descriptor.getName());
+bool p2p::getFile(std::string name, std::string hash) {
+    return util::isStarted(async::getFile(name, hash));
+}
 
-    // set additional data size to size of descritor + content
-    message.setAdditionalDataSize(sizeof(FileDescriptor) + fileContent.size());
+bool p2p::getFile(std::string name, uint64_t offset, uint64_t length) {
+    return util::isStarted(async::getFile(name, offset, length));
+}
 
-    // prepare buffer
-    std::vector<uint8_t> buffer(sizeof(P2PMessage) + message.getAdditionalDataSize());
+bool p2p::getFile(std::string name, std::string hash, uint64_t offset, uint64_t length) {
+    return util::isStarted(async::getFile(name, hash, offset, length));
+}
 
-    memcpy(buffer.data(), &message, sizeof(P2PMessage));
-    memcpy(buffer.data() + sizeof(P2PMessage), &descriptor, sizeof(FileDescriptor));
-    memcpy(buffer.data() + sizeof(P2PMessage) + sizeof(FileDescriptor), fileContent.data(), fileContent.size());
+p2p::async::Operation p2p::async::getFile(const std::string &name, const PendingOperations::Callback &callback) {
+    return getFile(name, 0, 0, callback);
+}
 
-    in_addr_t holderNode = descriptor.getHolderIp();
-    tcpServer->sendData(buffer.data(), buffer.size(), holderNode);
+p2p::async::Operation p2p::async::getFile(const std::string &name, const std::string &hash,
+                                          const PendingOperations::Callback &callback) {
+    return getFile(name, hash, 0, 0, callback);
 }
 
-bool p2p::getFile(std::string name) {
+p2p::async::Operation p2p::async::getFile(const std::string &name, uint64_t offset, uint64_t length,
+                                          const PendingOperations::Callback &callback) {
     using namespace util;
     FileDescriptor descriptor;
     {
-        Guard guard(mutex);
-
         // find repetitions
-        long filesWithSameName = std::count_if(networkDescriptors.begin(), networkDescriptors.end(),
-                                               [&name](const FileDescriptor &fd) {
-                                                   return fd.getName() == name;
-                                               });
+        std::vector<FileDescriptor> filesWithSameName = networkDescriptors.findByName(name);
 
-        if (filesWithSameName > 1) {
+        if (filesWithSameName.size() > 1) {
             BOOST_LOG_TRIVIAL(info) << "===> getFile: " << name
                                     << " hashes collision! Use command <filename> <md5>";
-            return false;
+            return PendingOperations::finished(PendingOperations::Status::FAILED, "hashes collision", callback);
         }
 
-        auto descriptorPointer = std::find_if(networkDescriptors.begin(), networkDescriptors.end(),
-                                              [&name](const FileDescriptor &fd) {
-                                                  return fd.getName() == name;
-                                              });
-        if (descriptorPointer == networkDescriptors.end()) {
+        if (filesWithSameName.empty()) {
             BOOST_LOG_TRIVIAL(info) << "===> getFile: " << name
                                     << " does not exists in the network, try again";
-            return false;
+            return PendingOperations::finished(PendingOperations::Status::FAILED, "file does not exist", callback);
         }
-        descriptor = *descriptorPointer;
+        descriptor = filesWithSameName.front();
     }
 
-    return getFile(descriptor);
+    return util::getFile(descriptor, offset, length, callback);
 }
 
-bool p2p::getFile(std::string name, std::string hash) {
+p2p::async::Operation p2p::async::getFile(const std::string &name, const std::string &hash, uint64_t offset,
+                                          uint64_t length, const PendingOperations::Callback &callback) {
     using namespace util;
     FileDescriptor descriptor;
     {
-        Guard guard(mutex);
-        auto descriptorPointer = std::find_if(networkDescriptors.begin(), networkDescriptors.end(),
-                                              [&hash](const FileDescriptor &fd) {
-                                                  return fd.getMd5().getHash() == hash;
-                                              });
-        if (descriptorPointer == networkDescriptors.end() || descriptorPointer->getName() != name) {
+        // hex form given by the user is converted once to look up the digest
+        Md5Hash requestedHash(hash);
+        if (!networkDescriptors.find(requestedHash, descriptor) || descriptor.getName() != name) {
             BOOST_LOG_TRIVIAL(info) << "===> getFile: " << name
                                     << " md5: " << hash
                                     << " does not exists in the network, try again";
-            return false;
+            return PendingOperations::finished(PendingOperations::Status::FAILED, "file does not exist", callback);
         }
-        descriptor = *descriptorPointer;
     }
 
-    return getFile(descriptor);
+    return util::getFile(descriptor, offset, length, callback);
 }
 
-bool p2p::util::getFile(FileDescriptor &descriptor) {
+PendingOperations::Future p2p::util::getFile(FileDescriptor &descriptor, uint64_t offset, uint64_t length,
+                                             const PendingOperations::Callback &callback) {
     using namespace util;
+    if (length != 0) {
+        return getFileRange(descriptor, offset, length, callback);
+    }
     // check if file is stored on our host
     if (descriptor.getHolderIp() == tcpServer->getLocalhostIp()) {
         BOOST_LOG_TRIVIAL(info) << "===> getFile: " << descriptor.getName()
                                 << " md5: " << descriptor.getMd5().getHash()
                                 << " is present on >>THIS HOST<<; rewrite the file";
         // we already have the file - just rewrite the file
-        FileLoader loader(descriptor.getMd5().getHash());
-        auto content = loader.getContent();
-        FileStorer storer(descriptor.getName());
-        storer.storeFile(content);
-
-        return true;
+        PendingOperations::Future operation = operations.add(MessageType::GET_FILE, descriptor.getMd5(),
+                                                             descriptor.getHolderIp(), descriptor.getSize(),
+                                                             callback);
+        bool copied = copyFile(descriptor.getMd5().getHash(), descriptor.getName());
+        operations.complete(MessageType::GET_FILE, descriptor.getMd5(),
+                            copied ? PendingOperations::Status::COMPLETED : PendingOperations::Status::FAILED,
+                            copied ? "" : "file not copied");
+        return operation;
     }
-    util::requestGetFile(descriptor);
-    return true;
+    // continue interrupted download; the whole file is verified once the rest arrives
+    FileStorer storer(descriptor.getName());
+    offset = storer.getPartialSize();
+    if (offset > descriptor.getSize()) {
+        // partial file of some other version
+        unlink(storer.getPartialFilename().c_str());
+        offset = 0;
+    }
+    // completed by FILE_TRANSFER
+    PendingOperations::Future operation = operations.add(MessageType::GET_FILE, descriptor.getMd5(),
+                                                         descriptor.getHolderIp(), descriptor.getSize() - offset,
+                                                         callback);
+    util::requestGetFile(descriptor, offset);
+    return operation;
+}
+
+PendingOperations::Future p2p::util::getFileRange(FileDescriptor &descriptor, uint64_t offset, uint64_t length,
+                                                  const PendingOperations::Callback &callback) {
+    if (offset >= descriptor.getSize()) {
+        return PendingOperations::finished(PendingOperations::Status::FAILED, "range outside the file", callback);
+    }
+    // the holder sends as much as the file has
+    length = std::min<uint64_t>(length, descriptor.getSize() - offset);
+    std::string rangeFilename = FileReceiver::getRangeFileName(descriptor.getName(), offset, length);
+    // completed by FILE_TRANSFER
+    PendingOperations::Future operation = operations.add(MessageType::GET_FILE, descriptor.getMd5(),
+                                                         descriptor.getHolderIp(), length, callback);
+    if (descriptor.getHolderIp() == tcpServer->getLocalhostIp()) {
+        bool copied = copyFile(descriptor.getMd5().getHash(), rangeFilename, offset, length);
+        operations.complete(MessageType::GET_FILE, descriptor.getMd5(),
+                            copied ? PendingOperations::Status::COMPLETED : PendingOperations::Status::FAILED,
+                            copied ? "" : "range not copied");
+        return operation;
+    }
+    requestGetFile(descriptor, offset, length);
+    return operation;
 }
 
-void p2p::util::requestGetFile(FileDescriptor &descriptor) {
-    P2PMessage message{};
-    message.setMessageType(MessageType::GET_FILE);
-    message.setAdditionalDataSize(sizeof(FileDescriptor));
-
-    // prepare buffer
-    std::vector<uint8_t> buffer(sizeof(P2PMessage) + message.getAdditionalDataSize());
-    memcpy(buffer.data(), &message, sizeof(P2PMessage));
-    memcpy(buffer.data() + sizeof(P2PMessage), &descriptor, sizeof(FileDescriptor));
+void p2p::util::requestGetFile(FileDescriptor &descriptor, uint64_t offset, uint64_t length) {
+    MessageBuilder message(MessageType::GET_FILE);
+    message.addPayload(DescriptorCodec::encode(descriptor)).add(offset).add(length);
 
     // send request
-    tcpServer->sendData(buffer.data(), buffer.size(), descriptor.getHolderIp());
+    tcpServer->sendMessage(std::move(message), descriptor.getHolderIp());
     BOOST_LOG_TRIVIAL(debug) << ">>> GET_FILE: " << descriptor.getName()
-                             << " md5: " << descriptor.getMd5().getHash();
+                             << " md5: " << descriptor.getMd5().getHash()
+                             << " from byte " << offset << ", " << length << " bytes";
+}
+
+bool p2p::deleteFile(std::string name) {
+    return util::isStarted(async::deleteFile(name));
 }
 
 bool p2p::deleteFile(std::string name, std::string hash) {
+    return util::isStarted(async::deleteFile(name, hash));
+}
+
+p2p::async::Operation p2p::async::deleteFile(const std::string &name, const std::string &hash,
+                                             const PendingOperations::Callback &callback) {
     using namespace util;
     FileDescriptor descriptor;
     {
-        Guard guard(mutex);
-        auto descriptorPointer = std::find_if(networkDescriptors.begin(), networkDescriptors.end(),
-                                              [&hash](const FileDescriptor &fd) {
-                                                  return fd.getMd5().getHash() == hash;
-                                              });
-        if (descriptorPointer == networkDescriptors.end() || descriptorPointer->getName() != name) {
+        // hex form given by the user is converted once to look up the digest
+        Md5Hash requestedHash(hash);
+        if (!networkDescriptors.find(requestedHash, descriptor) || descriptor.getName() != name) {
             BOOST_LOG_TRIVIAL(info) << "===> deleteFile: " << name
                                     << " md5: " << hash
                                     << " does not exists in the network, try again";
-            return false;
+            return PendingOperations::finished(PendingOperations::Status::FAILED, "file does not exist", callback);
         }
-        descriptor = *descriptorPointer;
     }
 
-    return deleteFile(descriptor);
+    return util::deleteFile(descriptor, callback);
 }
 
-bool p2p::deleteFile(std::string name) {
+p2p::async::Operation p2p::async::deleteFile(const std::string &name, const PendingOperations::Callback &callback) {
     using namespace util;
     FileDescriptor descriptor;
     {
-        Guard guard(mutex); // find repetitions
-        long filesWithSameName = std::count_if(networkDescriptors.begin(), networkDescriptors.end(),
-                                               [&name](const FileDescriptor &fd) {
-                                                   return fd.getName() == name;
-                                               });
+        // find repetitions
+        std::vector<FileDescriptor> filesWithSameName = networkDescriptors.findByName(name);
 
-        if (filesWithSameName > 1) {
+        if (filesWithSameName.size() > 1) {
             BOOST_LOG_TRIVIAL(info) << "===> deleteFile: " << name
                                     << " hashes collision! Use command <filename> <md5>";
-            return false;
+            return PendingOperations::finished(PendingOperations::Status::FAILED, "hashes collision", callback);
         }
 
-        auto descriptorPointer = std::find_if(networkDescriptors.begin(), networkDescriptors.end(),
-                                              [&name](const FileDescriptor &fd) {
-                                                  return fd.getName() == name;
-                                              });
-
-        if (descriptorPointer == networkDescriptors.end()) {
+        if (filesWithSameName.empty()) {
             BOOST_LOG_TRIVIAL(info) << "===> deleteFile: " << name
                                     << " does not exists in the network, try again";
-            return false;
+            return PendingOperations::finished(PendingOperations::Status::FAILED, "file does not exist", callback);
         }
-        descriptor = *descriptorPointer;
+        descriptor = filesWithSameName.front();
     }
 
     if (!descriptor.isValid()) {
         BOOST_LOG_TRIVIAL(info) << "===> deleteFile: " << name
                                 << " is already being proceed (it's invalid now). Try again for a while.";
-        return false;
+        return PendingOperations::finished(PendingOperations::Status::FAILED, "file is being processed", callback);
     }
 
-    return deleteFile(descriptor);
+    return util::deleteFile(descriptor, callback);
 }
 
 
-bool p2p::util::deleteFile(FileDescriptor &descriptor) {
+PendingOperations::Future p2p::util::deleteFile(FileDescriptor &descriptor,
+                                                const PendingOperations::Callback &callback) {
     using namespace util;
 
     // check unauthorized access
@@ -513,81 +849,57 @@ bool p2p::util::deleteFile(FileDescriptor &descriptor) {
                                 << " md5: " << descriptor.getMd5().getHash()
                                 << " you are not the owner! Owner ip: "
                                 << getFormatedIp(descriptor.getOwnerIp());
-        return false;
+        return PendingOperations::finished(PendingOperations::Status::FAILED, "not the owner", callback);
     }
 
-    // discard descriptor
-    util::discardDescriptor(descriptor);
-    usleep(10000);
-    util::requestDeleteFile(descriptor);
-    return true;
+    // completed by REVOKE_FILE of the holder
+    PendingOperations::Future operation = operations.add(MessageType::DELETE_FILE, descriptor.getMd5(),
+                                                         descriptor.getHolderIp(), 0, callback);
+    // file is deleted once no other node hands it out; the caller does not wait for that
+    util::discardDescriptor(descriptor, [descriptor](bool acknowledged) mutable {
+        if (!acknowledged) {
+            BOOST_LOG_TRIVIAL(debug) << "===> DISCARD_DESCRIPTOR: not acknowledged by all the nodes, going on";
+        }
+        util::requestDeleteFile(descriptor);
+    });
+    return operation;
 }
 
-void p2p::util::requestDeleteFile(FileDescriptor &descriptor) {
-    P2PMessage message{};
-    message.setMessageType(MessageType::DELETE_FILE);
-    message.setAdditionalDataSize(sizeof(FileDescriptor));
+bool p2p::util::isStarted(const PendingOperations::Future &operation) {
+    if (operation.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return true;
+    }
+    return operation.get().succeeded();
+}
 
-    // prepare buffer
-    std::vector<uint8_t> buffer(sizeof(P2PMessage) + message.getAdditionalDataSize());
-    memcpy(buffer.data(), (uint8_t *) &message, sizeof(P2PMessage));
-    memcpy(buffer.data() + sizeof(P2PMessage), (uint8_t *) &descriptor, sizeof(FileDescriptor));
+void p2p::util::requestDeleteFile(FileDescriptor &descriptor) {
+    MessageBuilder message(MessageType::DELETE_FILE);
+    message.addPayload(DescriptorCodec::encode(descriptor));
 
     // send request
-    tcpServer->sendData(buffer.data(), buffer.size(), descriptor.getHolderIp());
+    tcpServer->sendMessage(std::move(message), descriptor.getHolderIp());
     BOOST_LOG_TRIVIAL(debug) << ">>> DELETE_FILE: " << descriptor.getName()
                              << " md5: " << descriptor.getMd5().getHash();
 }
 
 void p2p::util::removeDuplicatesFromLists() {
-    // mutex already acquired
-    auto descriptorSorter = [](const FileDescriptor &fd1, const FileDescriptor &fd2) {
-        return fd1.getMd5().getHash() > fd2.getMd5().getHash();
-    };
-    auto descriptorComparator = [](const FileDescriptor &fd1, const FileDescriptor &fd2) {
-        return fd1.getMd5() == fd2.getMd5();
-    };
-    // remove duplicates from descriptors
-    std::sort(networkDescriptors.begin(), networkDescriptors.end(), descriptorSorter);
-    networkDescriptors.erase(std::unique(networkDescriptors.begin(), networkDescriptors.end(), descriptorComparator),
-                             networkDescriptors.end());
-
+    // mutex already acquired; network descriptors are unique by their digests already
     // remove duplicates from adresses
     std::sort(nodesAddresses.begin(), nodesAddresses.end());
     nodesAddresses.erase(std::unique(nodesAddresses.begin(), nodesAddresses.end()), nodesAddresses.end());
 }
 
-void p2p::util::sendCommandRefused(MessageType messageType, const char *msg, in_addr_t sourceAddress) {
-    P2PMessage message{};
-    uint32_t stringSize = strlen(msg) + 1;
-    // prepare cmd_refused
-    message.setMessageType(MessageType::CMD_REFUSED);
-    message.setAdditionalDataSize(sizeof(MessageType) + stringSize);
+void p2p::util::sendCommandRefused(MessageType messageType, const char *msg, in_addr_t sourceAddress,
+                                   const Md5Hash &hash) {
+    // refused message type followed by the description of the problem and the digest of the file
+    MessageBuilder message(MessageType::CMD_REFUSED);
+    message.add(messageType).add(msg, strlen(msg) + 1).add(hash.getDigest(), MD5_DIGEST_SIZE);
 
-    // prepareBuffer
-    std::vector<uint8_t> buffer(sizeof(P2PMessage) + message.getAdditionalDataSize());
-    memcpy(buffer.data(), &message, sizeof(P2PMessage));
-    memcpy(buffer.data() + sizeof(P2PMessage), &messageType, sizeof(MessageType));
-    memcpy(buffer.data() + sizeof(P2PMessage) + sizeof(MessageType), msg, stringSize);
-
-    tcpServer->sendData(buffer.data(), buffer.size(), sourceAddress);
+    tcpServer->sendMessage(std::move(message), sourceAddress);
 }
 
-bool p2p::util::isDescriptorUnique(FileDescriptor &descriptor) {
-    for (auto &&networkDescriptor : networkDescriptors) {
-        if (networkDescriptor.getMd5() == descriptor.getMd5()) {
-            return false;
-        }
-    }
-    return true;
-}
-
-FileDescriptor &p2p::util::getRepetedDescriptor(FileDescriptor &descriptor) {
-    for (auto &&networkDescriptor : networkDescriptors) {
-        if (networkDescriptor.getMd5() == descriptor.getMd5()) {
-            return networkDescriptor;
-        }
-    }
+bool p2p::util::isDescriptorUnique(const FileDescriptor &descriptor) {
+    return !networkDescriptors.contains(descriptor.getMd5());
 }
 
 std::vector<FileDescriptor> p2p::getLocalFileDescriptors() {
@@ -597,60 +909,58 @@ std::vector<FileDescriptor> p2p::getLocalFileDescriptors() {
 }
 
 std::vector<FileDescriptor> p2p::getNetworkFileDescriptors() {
-    using namespace util;
-    Guard guard(mutex);
-    return util::networkDescriptors;
+    // published snapshots are read without any lock; flattening them copies the descriptors once more
+    return util::networkDescriptors.getSnapshot().toVector();
 }
 
-uint32_t p2p::util::getAverageNodesLoad() {
-    Guard guard(mutex);
-
-    // map for easier collection of data
-    std::unordered_map<in_addr_t, uint32_t> nodesLoad;
-
-    nodesLoad[tcpServer->getLocalhostIp()] = 0;
-
-    // initialize loads
-    for (auto &&address : nodesAddresses) {
-        nodesLoad[address] = 0;
+void p2p::util::planRebalancing() {
+    if (!rebalancer) {
+        // leaving - all our files are moved anyway
+        return;
     }
-
-    // count uses
-    for (auto &&descriptor : networkDescriptors) {
-        nodesLoad[descriptor.getHolderIp()] += descriptor.getSize();
+    std::vector<RebalancePlanner::Move> moves;
+    in_addr_t thisHostAddress = tcpServer->getLocalhostIp();
+    {
+        Guard guard(mutex);
+        if (placement->isDeterministic()) {
+            for (auto &&localDescriptor : localDescriptors) {
+                in_addr_t holder = placement->choose(localDescriptor.getMd5());
+                if (holder != thisHostAddress) {
+                    moves.push_back({localDescriptor.getMd5(), localDescriptor.getSize(), holder});
+                }
+            }
+        } else {
+            moves = RebalancePlanner::plan(thisHostAddress, localDescriptors, networkDescriptors.getLoads().getLoads());
+        }
     }
 
-    uint32_t sum = 0;
-    for (auto &&nodeLoad : nodesLoad) {
-        sum += nodeLoad.second;
+    uint64_t bytesToMove = 0;
+    for (auto &&move : moves) {
+        bytesToMove += move.size;
     }
-
-    return sum / (uint32_t) nodesLoad.size();
+    BOOST_LOG_TRIVIAL(debug) << "===> rebalancing: " << moves.size() << " files, " << bytesToMove << " bytes to move";
+    rebalancer->schedule(std::move(moves));
 }
 
-uint32_t p2p::util::getThisNodeLoad() {
+bool p2p::util::moveLocalFile(const RebalancePlanner::Move &move) {
     Guard guard(mutex);
-
-    uint32_t sum = 0;
-    for (auto &&localDescriptor : localDescriptors) {
-        sum += localDescriptor.getSize();
+    // plan may be outdated by now
+    if (std::find(nodesAddresses.begin(), nodesAddresses.end(), move.target) == nodesAddresses.end()) {
+        return false;
     }
-
-    return sum;
-}
-
-void p2p::util::moveFilesWithSumaricSizeToNode(int64_t sizeToMove, in_addr_t sourceAddress) {
-    Guard guard(mutex);
-
-    // iterate over local descriptor
-    for (auto it = localDescriptors.begin(); it != localDescriptors.end() && sizeToMove > 0;) {
-        if (it->getSize() <= sizeToMove) {
-            sizeToMove -= it->getSize();
-            // do "HOLDER_CHANGE"
-            changeHolderNode(*it, sourceAddress);
-            it = localDescriptors.erase(it);
-        } else {
-            ++it;
-        }
+    if (placement->isDeterministic() && placement->choose(move.hash) != move.target) {
+        return false;
+    }
+    auto it = std::find_if(localDescriptors.begin(), localDescriptors.end(), [&move](const FileDescriptor &descriptor) {
+        return descriptor.getMd5() == move.hash;
+    });
+    if (it == localDescriptors.end()) {
+        return false;
     }
+
+    // do "HOLDER_CHANGE"
+    changeHolderNode(*it, move.target);
+    localChanges.remove(*it);
+    localDescriptors.erase(it);
+    return true;
 }
\ No newline at end of file
@@ -1,5 +1,298 @@
 #include "ProtocolManager.hpp"
 
+namespace p2p {
+    namespace util {
+        // descriptors of a message by their digests; the last one of a digest wins
+        typedef std::unordered_map<Md5Hash, FileDescriptor> DescriptorsByHash;
+
+        // descriptor messages come alone or in batches. The network catalog is changed descriptor by descriptor,
+        // each under its shard; then our own files are changed for the whole message at once, under the mutex
+        struct DescriptorApplier {
+            void (*applyToNetwork)(FileDescriptor &descriptor, in_addr_t sourceAddress);
+            // mutex is held; nullptr if our files are not affected
+            void (*applyToLocal)(const DescriptorsByHash &descriptors);
+        };
+
+        static void applyNewFile(FileDescriptor &newFileDescriptor, in_addr_t sourceAddress) {
+            // upload is over - the file counts into the load of its holder from now on
+            reservations.release(newFileDescriptor.getMd5());
+
+            // collision check and insert have to be atomic; kept if the network keeps this version of the file
+            bool kept = false;
+            bool inserted = networkDescriptors.withShard(newFileDescriptor.getMd5(), [&](DescriptorCatalog &catalog) {
+                // check collisions
+                const FileDescriptor *repetedDescriptor = catalog.find(newFileDescriptor.getMd5());
+                if (repetedDescriptor == nullptr) {
+                    // normal insert
+                    catalog.insert(newFileDescriptor);
+                    kept = true;
+                    return true;
+                }
+
+                BOOST_LOG_TRIVIAL(debug) << "<<< NEW_FILE: hashes collision! "
+                                         << repetedDescriptor->getName() << " and " << newFileDescriptor.getName()
+                                         << " md5: " << repetedDescriptor->getMd5().getHash()
+                                         << " upload times (old, new): "
+                                         << repetedDescriptor->getUploadTime() << " vs "
+                                         << newFileDescriptor.getUploadTime()
+                                         << "; earlier file choosen (or with < filename)";
+
+                // if system_clock can't distinguish version between collisions based on time
+                if (repetedDescriptor->getUploadTime() == newFileDescriptor.getUploadTime()) {
+                    // same descriptor announced again
+                    kept = newFileDescriptor.getName() == repetedDescriptor->getName();
+                    // if new file has "lower" name
+                    if (newFileDescriptor.getName() < repetedDescriptor->getName()) {
+                        // replace old descriptor
+                        catalog.upsert(newFileDescriptor);
+                        kept = true;
+                    }
+                    // if already present file has lower name - do nothing
+                    return false;
+                }
+
+                // if new desriptor is earlier version - choose it
+                if (repetedDescriptor->getUploadTime() > newFileDescriptor.getUploadTime()) {
+                    catalog.upsert(newFileDescriptor);
+                    kept = true;
+                }
+                return false;
+            });
+
+            // our upload has been published by its holder, unless the network keeps a colliding file
+            if (newFileDescriptor.getOwnerIp() == udpServer->getLocalhostIp()) {
+                if (kept) {
+                    operations.complete(MessageType::UPLOAD_FILE, newFileDescriptor.getMd5(),
+                                        PendingOperations::Status::COMPLETED);
+                } else {
+                    operations.complete(MessageType::UPLOAD_FILE, newFileDescriptor.getMd5(),
+                                        PendingOperations::Status::COLLISION, "other file with the same md5 is kept");
+                }
+            }
+
+            if (inserted) {
+                BOOST_LOG_TRIVIAL(debug) << "<<< NEW_FILE: " << newFileDescriptor.getName()
+                                         << " md5: " << newFileDescriptor.getMd5().getHash()
+                                         << " in node: " << getFormatedIp(sourceAddress);
+            }
+        }
+
+        static void applyReservation(FileDescriptor &descriptor, in_addr_t sourceAddress) {
+            if (sourceAddress == udpServer->getLocalhostIp()) {
+                // our own reservations are made and released as they happen
+                return;
+            }
+            if (!descriptor.isValid()) {
+                reservations.release(descriptor.getMd5());
+                return;
+            }
+            // NEW_FILE may have overtaken the lingering reservation
+            if (!networkDescriptors.contains(descriptor.getMd5())) {
+                reservations.reserve(descriptor.getMd5(), descriptor.getHolderIp(), descriptor.getSize());
+            }
+        }
+
+        static void applyRevokeFile(FileDescriptor &revokedFileDescriptor, in_addr_t /*sourceAddress*/) {
+            BOOST_LOG_TRIVIAL(debug) << "<<< REVOKE_FILE: " << revokedFileDescriptor.getName() << " "
+                                     << " md5: " << revokedFileDescriptor.getMd5().getHash();
+
+            Md5Hash revokedFileHash = revokedFileDescriptor.getMd5();
+
+            networkDescriptors.erase(revokedFileHash);
+            operations.complete(MessageType::DELETE_FILE, revokedFileHash, PendingOperations::Status::COMPLETED);
+        }
+
+        static void applyRevokeFilesToLocal(const DescriptorsByHash &revokedDescriptors) {
+            for (auto &&localDescriptor : localDescriptors) {
+                if (revokedDescriptors.count(localDescriptor.getMd5()) != 0) {
+                    localChanges.remove(localDescriptor);
+                }
+            }
+            localDescriptors.erase(std::remove_if(localDescriptors.begin(), localDescriptors.end(),
+                                                  [&revokedDescriptors](const FileDescriptor &fileDescriptor) {
+                                                      return revokedDescriptors.count(fileDescriptor.getMd5()) != 0;
+                                                  }), localDescriptors.end());
+        }
+
+        static void applyDiscardDescriptor(FileDescriptor &descriptor, in_addr_t sourceAddress) {
+            BOOST_LOG_TRIVIAL(debug) << "<<< DISCARD_DESCRIPTOR: " << descriptor.getName()
+                                     << " md5: " << descriptor.getMd5().getHash()
+                                     << " from " << getFormatedIp(sourceAddress);
+            descriptor.makeUnvalid();
+
+            // make this descriptor no longer valid
+            networkDescriptors.withShard(descriptor.getMd5(), [&descriptor](DescriptorCatalog &catalog) {
+                if (!catalog.setValid(descriptor.getMd5(), false)) {
+                    // that's mean this descriptor has been lost in some broadcast
+                    catalog.insert(descriptor);
+                }
+            });
+        }
+
+        static void applyDiscardDescriptorsToLocal(const DescriptorsByHash &discardedDescriptors) {
+            for (auto &&localDescriptor : localDescriptors) {
+                if (discardedDescriptors.count(localDescriptor.getMd5()) != 0) {
+                    localDescriptor.makeUnvalid();
+                    localChanges.put(localDescriptor);
+                }
+            }
+        }
+
+        static void applyUpdateDescriptor(FileDescriptor &updatedDescriptor, in_addr_t sourceAddress) {
+            BOOST_LOG_TRIVIAL(debug) << "<<< UPDATE_DESCRIPTOR: " << updatedDescriptor.getName()
+                                     << " md5: " << updatedDescriptor.getMd5().getHash()
+                                     << " from " << getFormatedIp(sourceAddress);
+
+            // update particular descriptor; it is inserted if it has been lost in some broadcast
+            networkDescriptors.upsert(updatedDescriptor);
+            if (updatedDescriptor.isValid() && updatedDescriptor.getHolderIp() != udpServer->getLocalhostIp()) {
+                // taken over - possibly one of the files we are leaving
+                reservations.release(updatedDescriptor.getMd5());
+                std::shared_ptr<DrainJob> job = std::atomic_load(&drain);
+                if (job) {
+                    job->confirm(updatedDescriptor.getMd5());
+                }
+            }
+        }
+
+        static void applyUpdateDescriptorsToLocal(const DescriptorsByHash &updatedDescriptors) {
+            // update particular descriptors
+            for (auto &&localDescriptor : localDescriptors) {
+                auto updated = updatedDescriptors.find(localDescriptor.getMd5());
+                if (updated != updatedDescriptors.end()) {
+                    localDescriptor = updated->second;
+                    localChanges.put(localDescriptor);
+                }
+            }
+        }
+
+        static void applyCatalogReply(const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
+            if (size < CATALOG_REPLY_HEADER_SIZE) {
+                BOOST_LOG_TRIVIAL(debug) << "<<< HELLO_REPLY: malformed catalog from " << getFormatedIp(sourceAddress);
+                return;
+            }
+            uint8_t full;
+            CatalogLog::Version version;
+            uint64_t digest;
+            uint32_t putSize;
+            // placement weight has been taken by the caller already
+            const uint8_t *field = data + sizeof(uint32_t);
+            memcpy(&full, field, sizeof full);
+            memcpy(&version.epoch, field += sizeof full, sizeof version.epoch);
+            memcpy(&version.sequence, field += sizeof version.epoch, sizeof version.sequence);
+            memcpy(&digest, field += sizeof version.sequence, sizeof digest);
+            memcpy(&putSize, field += sizeof digest, sizeof putSize);
+            const uint8_t *records = data + CATALOG_REPLY_HEADER_SIZE;
+            size_t recordsSize = size - CATALOG_REPLY_HEADER_SIZE;
+            if (putSize > recordsSize) {
+                BOOST_LOG_TRIVIAL(debug) << "<<< HELLO_REPLY: malformed catalog from " << getFormatedIp(sourceAddress);
+                return;
+            }
+
+            std::vector<FileDescriptor> put, removed;
+            bool wellFormed = DescriptorCodec::decode(records, putSize, put);
+            wellFormed = DescriptorCodec::decode(records + putSize, recordsSize - putSize, removed) && wellFormed;
+            if (!wellFormed) {
+                BOOST_LOG_TRIVIAL(debug) << "<<< HELLO_REPLY: malformed descriptors list";
+            }
+            BOOST_LOG_TRIVIAL(debug) << "<<< HELLO_REPLY from: " << getFormatedIp(sourceAddress) << " "
+                                     << (full ? "all " : "changed ") << put.size() << " descriptors, "
+                                     << removed.size() << " removed";
+
+            // catalog saved by our previous session is the base of the changes
+            std::vector<FileDescriptor> remembered;
+            {
+                Guard guard(mutex);
+                auto catalog = rememberedCatalogs.find(sourceAddress);
+                if (catalog != rememberedCatalogs.end()) {
+                    remembered.swap(catalog->second);
+                    rememberedCatalogs.erase(catalog);
+                }
+            }
+            if (full) {
+                // whatever we remember from the previous session may be stale
+                networkDescriptors.eraseHolder(sourceAddress);
+            } else {
+                for (auto &&descriptor : remembered) {
+                    networkDescriptors.upsert(descriptor);
+                }
+            }
+            // the node is the authority on the files it holds
+            for (auto &&descriptor : put) {
+                networkDescriptors.upsert(descriptor);
+            }
+            for (auto &&descriptor : removed) {
+                // file may have been moved to some other node meanwhile
+                networkDescriptors.withShard(descriptor.getMd5(), [&descriptor, sourceAddress](DescriptorCatalog &catalog) {
+                    const FileDescriptor *known = catalog.find(descriptor.getMd5());
+                    if (known != nullptr && known->getHolderIp() == sourceAddress) {
+                        catalog.erase(descriptor.getMd5());
+                    }
+                });
+            }
+
+            if (!wellFormed || CatalogLog::digest(networkDescriptors.findByHolder(sourceAddress)) != digest) {
+                // some change has been missed (or broadcasts came in meanwhile) - only the full catalog is certain
+                {
+                    Guard guard(mutex);
+                    forgetPeerVersion(sourceAddress);
+                }
+                if (!full) {
+                    requestCatalog(sourceAddress);
+                }
+                return;
+            }
+            Guard guard(mutex);
+            peerVersions[sourceAddress] = version;
+        }
+
+        static void applyDescriptors(const DescriptorApplier &apply, std::vector<FileDescriptor> &descriptors,
+                                     in_addr_t sourceAddress) {
+            // descriptors of other shards stay available to the other handlers meanwhile
+            for (auto &&descriptor : descriptors) {
+                apply.applyToNetwork(descriptor, sourceAddress);
+            }
+            if (apply.applyToLocal == nullptr || descriptors.empty()) {
+                return;
+            }
+
+            DescriptorsByHash byHash;
+            for (auto &&descriptor : descriptors) {
+                byHash[descriptor.getMd5()] = descriptor;
+            }
+            // one pass over our files for the whole message
+            Guard guard(mutex);
+            apply.applyToLocal(byHash);
+        }
+
+        static std::function<void(const uint8_t *, uint32_t, in_addr_t)>
+        singleDescriptorProcessor(DescriptorApplier apply) {
+            return [apply](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
+                std::vector<FileDescriptor> descriptors(1);
+                if (DescriptorCodec::decode(data, size, descriptors.front()) == 0) {
+                    BOOST_LOG_TRIVIAL(debug) << "<<< malformed descriptor from " << getFormatedIp(sourceAddress);
+                    return;
+                }
+
+                applyDescriptors(apply, descriptors, sourceAddress);
+            };
+        }
+
+        static std::function<void(const uint8_t *, uint32_t, in_addr_t)>
+        descriptorsBatchProcessor(DescriptorApplier apply) {
+            return [apply](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
+                std::vector<FileDescriptor> descriptors;
+                if (!DescriptorCodec::decode(data, size, descriptors)) {
+                    // records decoded before the malformed one are still applied
+                    BOOST_LOG_TRIVIAL(debug) << "<<< malformed descriptors batch from " << getFormatedIp(sourceAddress);
+                }
+
+                applyDescriptors(apply, descriptors, sourceAddress);
+            };
+        }
+    }
+}
+
 void p2p::util::initProcessingFunctions() {
     // =================================================================================================================
     // first message sent by new node; in reply we pass our local descriptors
@@ -9,382 +302,361 @@ void p2p::util::initProcessingFunctions() {
             return;
         }
         BOOST_LOG_TRIVIAL(debug) << "<<< HELLO from: " << getFormatedIp(sourceAddress);
+        uint32_t weight = 1;
+        if (size >= sizeof weight) {
+            memcpy(&weight, data, sizeof weight);
+        }
         {
             Guard guard(mutex);
             // save node address for later
-            nodesAddresses.push_back(sourceAddress);
+            addNodeAddress(sourceAddress, weight);
         }
 
-        // construct p2pmessage
-        P2PMessage message = {};
-        message.setMessageType(MessageType::HELLO_REPLY);
-        unsigned long additionalDataSize = localDescriptors.size() * sizeof(FileDescriptor);
-        message.setAdditionalDataSize
-                (additionalDataSize);
-
-        // create a vector with size of the whole message (empty)
-        std::vector<uint8_t> buffer(additionalDataSize + sizeof(P2PMessage));
+        // reply with the changes since the version of our catalog known to the node, if any
+        CatalogLog::Version since{0, 0};
+        const size_t versionSize = sizeof(in_addr_t) + 2 * sizeof(uint64_t);
+        in_addr_t thisHostAddress = tcpServer->getLocalhostIp();
+        for (const uint8_t *version = data + sizeof weight; version + versionSize <= data + size; version += versionSize) {
+            in_addr_t holder;
+            memcpy(&holder, version, sizeof holder);
+            if (holder == thisHostAddress) {
+                memcpy(&since.epoch, version + sizeof holder, sizeof since.epoch);
+                memcpy(&since.sequence, version + sizeof holder + sizeof since.epoch, sizeof since.sequence);
+            }
+        }
 
-        // write into underlying array P2Pmessage
-        memcpy(buffer.data(), &message, sizeof(P2PMessage));
+        // send message
+        util::tcpServer->sendMessage(buildCatalogReply(since), sourceAddress);
 
-        // write descriptors
-        memcpy(buffer.data() + sizeof(P2PMessage),
-               (uint8_t *) localDescriptors.data(),
-               localDescriptors.size() * sizeof(FileDescriptor));
+        // NETWORK BALANCING: files go to the node in the background, at a limited rate
+        planRebalancing();
+    };
 
-        // send message
-        util::tcpServer->sendData(buffer.data(), buffer.size(), sourceAddress);
+    // =================================================================================================================
+    // replay for other nodes
+    msgProcessors[MessageType::HELLO_REPLY] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
+        uint32_t weight = 1;
+        if (size >= sizeof weight) {
+            memcpy(&weight, data, sizeof weight);
+        }
+        {
+            Guard guard(mutex);
+            // preserve source address
+            addNodeAddress(sourceAddress, weight);
+            removeDuplicatesFromLists();
+        }
 
-        // NETWORK BALANCING
-        // estimate new average node load
-        uint32_t averageNodesLoad = getAverageNodesLoad();
-        uint32_t thisNodeLoad = getThisNodeLoad();
-        // if this node is storing more than average - move excess number of bytes (rounding to file sizes)
-        int64_t sizeToMoveFromThisNode = thisNodeLoad - averageNodesLoad;
+        // gather descriptors
+        applyCatalogReply(data, size, sourceAddress);
+    };
 
-        BOOST_LOG_TRIVIAL(debug) << "size to move from this node: " << sizeToMoveFromThisNode;
+    // =================================================================================================================
+    // node which got our changes wrong asks for all of them
+    msgProcessors[MessageType::CATALOG_REQUEST] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
+        CatalogLog::Version since{0, 0};
+        if (size >= sizeof since.epoch + sizeof since.sequence) {
+            memcpy(&since.epoch, data, sizeof since.epoch);
+            memcpy(&since.sequence, data + sizeof since.epoch, sizeof since.sequence);
+        }
+        BOOST_LOG_TRIVIAL(debug) << "<<< CATALOG_REQUEST from: " << getFormatedIp(sourceAddress);
+        tcpServer->sendMessage(buildCatalogReply(since), sourceAddress);
+    };
 
-        if (sizeToMoveFromThisNode < 0) {
-            // nothing to send from this node
+    // =================================================================================================================
+    // anti-entropy: hashes of some nodes of the other side's tree; we answer with the subtrees which differ
+    msgProcessors[MessageType::SYNC_HASHES] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
+        in_addr_t holder;
+        if (size < sizeof holder) {
             return;
         }
+        memcpy(&holder, data, sizeof holder);
+        if (holder != sourceAddress && holder != tcpServer->getLocalhostIp()) {
+            // only the holder of the files can tell how they look like
+            return;
+        }
+
+        MerkleTree tree(getHeldDescriptors(holder));
+        MessageBuilder reply(MessageType::SYNC_HASHES);
+        reply.add(holder);
+        size_t repliedHashes = 0;
+        std::vector<uint16_t> differentLeaves;
+        const size_t entrySize = sizeof(uint16_t) + sizeof(uint64_t);
+        for (const uint8_t *entry = data + sizeof holder; entry + entrySize <= data + size; entry += entrySize) {
+            uint16_t node;
+            uint64_t hash;
+            memcpy(&node, entry, sizeof node);
+            memcpy(&hash, entry + sizeof node, sizeof hash);
+            if (!MerkleTree::isNode(node) || tree.getHash(node) == hash) {
+                continue;
+            }
+            if (MerkleTree::isLeaf(node)) {
+                differentLeaves.push_back(node);
+                continue;
+            }
+            for (size_t descendant : MerkleTree::getDescendants(node, SYNC_LEVELS_PER_ROUND)) {
+                reply.add((uint16_t) descendant).add(tree.getHash(descendant));
+                ++repliedHashes;
+            }
+        }
 
-        moveFilesWithSumaricSizeToNode(sizeToMoveFromThisNode, sourceAddress);
+        if (repliedHashes > 0) {
+            tcpServer->sendMessage(std::move(reply), sourceAddress);
+        }
+        if (!differentLeaves.empty()) {
+            sendSyncLeaves(holder, differentLeaves, sourceAddress);
+        }
     };
 
     // =================================================================================================================
-    // replay for other nodes
-    msgProcessors[MessageType::HELLO_REPLY] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
-        removeDuplicatesFromLists();
-        BOOST_LOG_TRIVIAL(debug) << "<<< HELLO_REPLY from: " << getFormatedIp(sourceAddress) << " "
-                                 << size / sizeof(FileDescriptor) << " descriptors received";
+    // anti-entropy: descriptors from the ranges which differ - the holder's view replaces ours
+    msgProcessors[MessageType::SYNC_LEAVES] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
+        in_addr_t holder;
+        uint16_t leavesCount;
+        if (size < sizeof holder + sizeof leavesCount) {
+            return;
+        }
+        memcpy(&holder, data, sizeof holder);
+        memcpy(&leavesCount, data + sizeof holder, sizeof leavesCount);
+        const uint8_t *records = data + sizeof holder + sizeof leavesCount + leavesCount * sizeof(uint16_t);
+        if (records > data + size) {
+            return;
+        }
+        std::vector<uint16_t> leaves(leavesCount);
+        memcpy(leaves.data(), data + sizeof holder + sizeof leavesCount, leavesCount * sizeof(uint16_t));
 
-        std::vector<FileDescriptor> buffer(size / sizeof(FileDescriptor));
+        if (holder == tcpServer->getLocalhostIp()) {
+            // the other side needs our descriptors
+            sendSyncLeaves(holder, leaves, sourceAddress);
+            return;
+        }
+        if (holder != sourceAddress) {
+            return;
+        }
 
-        // put descriptors
-        memcpy((uint8_t *) buffer.data(), data, size);
+        std::vector<FileDescriptor> descriptors;
+        if (!DescriptorCodec::decode(records, data + size - records, descriptors)) {
+            // without all of them the missing ones cannot be told from the removed ones
+            BOOST_LOG_TRIVIAL(debug) << "<<< SYNC_LEAVES: malformed descriptors from " << getFormatedIp(sourceAddress);
+            return;
+        }
 
-        // gather descriptors
-        {
-            Guard guard(mutex);
-            // preserve source address
-            nodesAddresses.push_back(sourceAddress);
-            networkDescriptors.insert(networkDescriptors.end(), buffer.begin(), buffer.end());
+        std::unordered_set<size_t> differentLeaves(leaves.begin(), leaves.end());
+        std::unordered_set<Md5Hash> held;
+        for (auto &&descriptor : descriptors) {
+            if (descriptor.getHolderIp() == holder && differentLeaves.count(MerkleTree::getLeaf(descriptor.getMd5())) != 0) {
+                networkDescriptors.upsert(descriptor);
+                held.insert(descriptor.getMd5());
+            }
         }
+        size_t removedDescriptors = 0;
+        for (auto &&descriptor : networkDescriptors.findByHolder(holder)) {
+            if (held.count(descriptor.getMd5()) != 0
+                || differentLeaves.count(MerkleTree::getLeaf(descriptor.getMd5())) == 0) {
+                continue;
+            }
+            // revoked or moved away in some lost broadcast
+            networkDescriptors.withShard(descriptor.getMd5(), [&descriptor, holder](DescriptorCatalog &catalog) {
+                const FileDescriptor *known = catalog.find(descriptor.getMd5());
+                if (known != nullptr && known->getHolderIp() == holder) {
+                    catalog.erase(descriptor.getMd5());
+                }
+            });
+            ++removedDescriptors;
+        }
+        BOOST_LOG_TRIVIAL(debug) << "<<< SYNC_LEAVES: " << leaves.size() << " ranges of " << getFormatedIp(holder)
+                                 << " repaired; " << held.size() << " descriptors updated, "
+                                 << removedDescriptors << " removed";
     };
 
     // =================================================================================================================
     // message sent by node, which starts shutdown; discards every his descriptor
     // discarding is not neccessary (quiting node should do it even before this message)
     // but it ensures, that no one will interrupt the collapsing node
-    msgProcessors[MessageType::DISCONNECTING] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
+    msgProcessors[MessageType::DISCONNECTING] = [](const uint8_t * /*data*/, uint32_t /*size*/,
+                                                   in_addr_t sourceAddress) {
         if (sourceAddress == udpServer->getLocalhostIp()) {
             // our broadcast, skip
             return;
         }
 
-        Guard guard(mutex);
         // mark descriptors of disconnecting node as discarded
-        for (auto &&descriptor : networkDescriptors) {
-            if (descriptor.getHolderIp() == sourceAddress) {
-                descriptor.makeUnvalid();
-            }
-        }
+        networkDescriptors.invalidateHolder(sourceAddress);
+        failDrainTarget(sourceAddress);
 
         // prevent choosing disconnecting node from being choosed as holder for new file
-        nodesAddresses.erase(std::remove_if(nodesAddresses.begin(), nodesAddresses.end(),
-                                            [sourceAddress](const in_addr_t &addr) {
-                                                return sourceAddress == addr;
-                                            }), nodesAddresses.end());
+        Guard guard(mutex);
+        removeNodeAddress(sourceAddress);
+        forgetPeerVersion(sourceAddress);
         BOOST_LOG_TRIVIAL(debug) << "<<< DISCONNECTING: node " << sourceAddress << " start disconnecting";
     };
 
     // =================================================================================================================
     // if someone signals that some node quit "definitely not gently"
-    msgProcessors[MessageType::CONNECTION_LOST] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
+    msgProcessors[MessageType::CONNECTION_LOST] = [](const uint8_t *data, uint32_t size,
+                                                     in_addr_t /*sourceAddress*/) {
         // only additional information is lostNode IP
-        in_addr_t lostNodeAddress = *(in_addr_t *) data;
+        in_addr_t lostNodeAddress;
+        if (size < sizeof lostNodeAddress) {
+            return;
+        }
+        memcpy(&lostNodeAddress, data, sizeof lostNodeAddress);
 
-        int lostDescriptorsNumber = 0;
-        Guard guard(mutex);
         // revoke descriptors from lost node
-        networkDescriptors.erase(std::remove_if(networkDescriptors.begin(), networkDescriptors.end(),
-                                                [lostNodeAddress, &lostDescriptorsNumber](
-                                                        const FileDescriptor &fileDescriptor) {
-                                                    ++lostDescriptorsNumber;
-                                                    return fileDescriptor.getHolderIp() == lostNodeAddress;
-                                                }));
-        // remove node address from space
-        nodesAddresses.erase(std::remove_if(nodesAddresses.begin(), nodesAddresses.end(),
-                                            [sourceAddress](const in_addr_t &addr) {
-                                                return sourceAddress == addr;
-                                            }), nodesAddresses.end());
+        size_t lostDescriptorsNumber = networkDescriptors.eraseHolder(lostNodeAddress);
+        failDrainTarget(lostNodeAddress);
+        pendingRequests.failNode(lostNodeAddress);
+        operations.failNode(lostNodeAddress);
+        // remove node address from space; the reporting node stays
+        Guard guard(mutex);
+        removeNodeAddress(lostNodeAddress);
+        forgetPeerVersion(lostNodeAddress);
         BOOST_LOG_TRIVIAL(debug) << "<<< CONNECTION_LOST: with node " << lostNodeAddress
                                  << "; lost " << lostDescriptorsNumber << " descriptors";
     };
 
+    // =================================================================================================================
+    // node has processed our message
+    msgProcessors[MessageType::ACK] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
+        uint32_t requestId;
+        if (size < sizeof requestId) {
+            return;
+        }
+        memcpy(&requestId, data, sizeof requestId);
+        pendingRequests.acknowledge(requestId, sourceAddress);
+    };
+
     // =================================================================================================================
     // node refused to perform operation, which we requested for
     msgProcessors[MessageType::CMD_REFUSED] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
-        MessageType messageType = *(MessageType *) data;
+        MessageType messageType;
+        if (size < sizeof messageType) {
+            return;
+        }
+        memcpy(&messageType, data, sizeof messageType);
 
         // get description of the problem
-        const char *errorDescription = (const char *) (data + sizeof(MessageType));
+        const char *errorDescription = (const char *) (data + sizeof messageType);
+        const uint8_t *end = (const uint8_t *) memchr(errorDescription, '\0', size - sizeof messageType);
+        if (end == nullptr) {
+            return;
+        }
 
         BOOST_LOG_TRIVIAL(info) << "<<< CMD_REFUSED: node " << getFormatedIp(sourceAddress)
                                 << " refused command, message: " << errorDescription;
+
+        // digest of the file tells which of our operations has been refused
+        if (end + 1 + MD5_DIGEST_SIZE <= data + size) {
+            operations.complete(messageType, Md5Hash::fromDigest(end + 1), PendingOperations::Status::REFUSED,
+                                errorDescription);
+        }
     };
 
     // =================================================================================================================
     // last message sent by collapsing node - nothing will be valid, so ensure that everything is deleted
-    msgProcessors[MessageType::SHUTDOWN] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) -> void {
+    msgProcessors[MessageType::SHUTDOWN] = [](const uint8_t * /*data*/, uint32_t /*size*/,
+                                              in_addr_t sourceAddress) -> void {
         if (sourceAddress == udpServer->getLocalhostIp()) {
             // its our broadcast, skip
             return;
         }
 
-        Guard guard(mutex);
         // remove all associated data
-        nodesAddresses.erase(std::remove_if(nodesAddresses.begin(), nodesAddresses.end(),
-                                            [sourceAddress](const in_addr_t &addr) {
-                                                return sourceAddress == addr;
-                                            }), nodesAddresses.end());
-        int lostDescriptors = 0;
-        networkDescriptors.erase(std::remove_if(networkDescriptors.begin(), networkDescriptors.end(),
-                                                [sourceAddress, &lostDescriptors](const FileDescriptor &fileDescriptor) {
-                                                    ++lostDescriptors;
-                                                    return fileDescriptor.getHolderIp() == sourceAddress;
-                                                }));
+        size_t lostDescriptors = networkDescriptors.eraseHolder(sourceAddress);
+        failDrainTarget(sourceAddress);
+        pendingRequests.failNode(sourceAddress);
+        operations.failNode(sourceAddress);
+        Guard guard(mutex);
+        removeNodeAddress(sourceAddress);
+        forgetPeerVersion(sourceAddress);
         BOOST_LOG_TRIVIAL(debug) << "<<< SHUTDOWN: node " << getFormatedIp(sourceAddress) << " have been closed"
                                  << "; lost " << lostDescriptors << " descriptors";
     };
 
     // =================================================================================================================
     // new file descriptor received - put it into network descriptors list
-    msgProcessors[MessageType::NEW_FILE] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
-        FileDescriptor newFileDescriptor = *(FileDescriptor *) data;
-
-        // check collisions
-        Guard guard(mutex);
-        if (!isDescriptorUnique(newFileDescriptor)) {
-            // get descriptor with the same md5
-            FileDescriptor repetedDescriptor = getRepetedDescriptor(newFileDescriptor);
-
-            BOOST_LOG_TRIVIAL(debug) << "<<< NEW_FILE: hashes collision! "
-                                     << repetedDescriptor.getName() << " and " << newFileDescriptor.getName()
-                                     << " md5: " << repetedDescriptor.getMd5().getHash()
-                                     << " upload times (old, new): "
-                                     << repetedDescriptor.getUploadTime() << " vs "
-                                     << newFileDescriptor.getUploadTime()
-                                     << "; earlier file choosen (or with < filename)";
-
-            // if system_clock can't distinguish version between collisions based on time
-            if (repetedDescriptor.getUploadTime() == newFileDescriptor.getUploadTime()) {
-                // if new file has "lower" name
-                if (newFileDescriptor.getName() < repetedDescriptor.getName()) {
-                    // remove old descriptor
-                    networkDescriptors.erase(std::remove_if(networkDescriptors.begin(), networkDescriptors.end(),
-                                                            [&repetedDescriptor](const FileDescriptor &fd) {
-                                                                return fd.getMd5() == repetedDescriptor.getMd5();
-                                                            }));
-                    networkDescriptors.push_back(newFileDescriptor);
-                }
-                // if already present file has lower name - do nothing
-                return;
-            }
-
-            // if new desriptor is earlier version - choose it
-            if (repetedDescriptor.getUploadTime() > newFileDescriptor.getUploadTime()) {
-                networkDescriptors.erase(std::remove_if(networkDescriptors.begin(), networkDescriptors.end(),
-                                                        [&repetedDescriptor](const FileDescriptor &fd) {
-                                                            return fd.getMd5() == repetedDescriptor.getMd5();
-                                                        }));
-                networkDescriptors.push_back(newFileDescriptor);
-            }
-            return;
-        }
-
-        // normal insert
-        networkDescriptors.push_back(newFileDescriptor);
-        removeDuplicatesFromLists();
-
-        BOOST_LOG_TRIVIAL(debug) << "<<< NEW_FILE: " << newFileDescriptor.getName()
-                                 << " md5: " << newFileDescriptor.getMd5().getHash()
-                                 << " in node: " << getFormatedIp(sourceAddress);
-
-    };
+    msgProcessors[MessageType::NEW_FILE] = singleDescriptorProcessor({&applyNewFile, nullptr});
+    msgProcessors[MessageType::NEW_FILES] = descriptorsBatchProcessor({&applyNewFile, nullptr});
 
     // =================================================================================================================
-    msgProcessors[MessageType::REVOKE_FILE] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
-        FileDescriptor revokedFileDescriptor = *(FileDescriptor *) data;
+    // uploads in progress elsewhere - their nodes count as loaded with the files already
+    msgProcessors[MessageType::RESERVE_PLACEMENTS] = descriptorsBatchProcessor({&applyReservation, nullptr});
 
-        BOOST_LOG_TRIVIAL(debug) << "<<< REVOKE_FILE: " << revokedFileDescriptor.getName() << " "
-                                 << " md5: " << revokedFileDescriptor.getMd5().getHash();
-
-        Md5Hash revokedFileHash = revokedFileDescriptor.getMd5();
-
-        Guard guard(mutex);
-        networkDescriptors.erase(std::remove_if(networkDescriptors.begin(), networkDescriptors.end(),
-                                                [&revokedFileHash](const FileDescriptor &fileDescriptor) {
-                                                    return fileDescriptor.getMd5() == revokedFileHash;
-                                                }));
-        localDescriptors.erase(std::remove_if(localDescriptors.begin(), localDescriptors.end(),
-                                                [&revokedFileHash](const FileDescriptor &fileDescriptor) {
-                                                    return fileDescriptor.getMd5() == revokedFileHash;
-                                                }));
-    };
+    // =================================================================================================================
+    msgProcessors[MessageType::REVOKE_FILE] = singleDescriptorProcessor({&applyRevokeFile, &applyRevokeFilesToLocal});
+    msgProcessors[MessageType::REVOKE_FILES] = descriptorsBatchProcessor({&applyRevokeFile, &applyRevokeFilesToLocal});
 
     // =================================================================================================================
     // discard descriptor request - file is present in network, but cannot be accessed nor deleted
-    msgProcessors[MessageType::DISCARD_DESCRIPTOR] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
-        FileDescriptor descriptor = *(FileDescriptor *) data;
-        BOOST_LOG_TRIVIAL(debug) << "<<< DISCARD_DESCRIPTOR: " << descriptor.getName()
-                                 << " md5: " << descriptor.getMd5().getHash()
-                                 << " from " << getFormatedIp(sourceAddress);
-        descriptor.makeUnvalid();
-
-        Guard guard(mutex);
-        bool descriptorPresence = false;
-        // make this descriptor no longer valid
-        for (auto &&networkDescriptor : networkDescriptors) {
-            if (networkDescriptor.getMd5() == descriptor.getMd5()) {
-                networkDescriptor.makeUnvalid();
-                descriptorPresence = true;
-            }
-        }
-        // check if this descriptor has been lost in some broadcast
-        if (!descriptorPresence) {
-            // that's mean this descriptor has not been received
-            networkDescriptors.push_back(descriptor);
-        }
-        for (auto &&localDescriptor : localDescriptors) {
-            if (localDescriptor.getMd5() == descriptor.getMd5()) {
-                localDescriptor.makeUnvalid();
-            }
-        }
-    };
+    msgProcessors[MessageType::DISCARD_DESCRIPTOR] =
+            singleDescriptorProcessor({&applyDiscardDescriptor, &applyDiscardDescriptorsToLocal});
+    msgProcessors[MessageType::DISCARD_DESCRIPTORS] =
+            descriptorsBatchProcessor({&applyDiscardDescriptor, &applyDiscardDescriptorsToLocal});
 
     // =================================================================================================================
     // update descriptor request - something changed (holderNode)
-    msgProcessors[MessageType::UPDATE_DESCRIPTOR] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
-        FileDescriptor updatedDescriptor = *(FileDescriptor *) data;
-
-        BOOST_LOG_TRIVIAL(debug) << "<<< UPDATE_DESCRIPTOR: " << updatedDescriptor.getName()
-                                 << " md5: " << updatedDescriptor.getMd5().getHash()
-                                 << " from " << getFormatedIp(sourceAddress);
-
-        Guard guard(mutex);
-        bool descriptorPresence = false;
-        // update particular descriptor
-        for (auto &&networkDescriptor : networkDescriptors) {
-            if (networkDescriptor.getMd5() == updatedDescriptor.getMd5()) {
-                networkDescriptor = updatedDescriptor;
-                descriptorPresence = true;
-            }
-        }
-        // check if this descriptor has been lost in some broadcast
-        if (!descriptorPresence) {
-            // that's mean this descriptor has not been received
-            networkDescriptors.push_back(updatedDescriptor);
-        }
-        // update particular descriptor
-        for (auto &&localDescriptor : localDescriptors) {
-            if (localDescriptor.getMd5() == updatedDescriptor.getMd5()) {
-                localDescriptor = updatedDescriptor;
-            }
-        }
-
-        removeDuplicatesFromLists();
-    };
+    msgProcessors[MessageType::UPDATE_DESCRIPTOR] =
+            singleDescriptorProcessor({&applyUpdateDescriptor, &applyUpdateDescriptorsToLocal});
+    msgProcessors[MessageType::UPDATE_DESCRIPTORS] =
+            descriptorsBatchProcessor({&applyUpdateDescriptor, &applyUpdateDescriptorsToLocal});
 
     // =================================================================================================================
-    // received file to store locally. Store it and publish updated descriptor
-    msgProcessors[MessageType::HOLDER_CHANGE] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
-        FileDescriptor updatedDescriptor = *(FileDescriptor *) data;
+    // received file to store locally. Publish updated descriptor
+    fileProcessors[MessageType::HOLDER_CHANGE] = [](FileDescriptor &updatedDescriptor, bool stored,
+                                                    in_addr_t sourceAddress) {
         BOOST_LOG_TRIVIAL(debug) << "<<< HOLDER_CHANGE: store here " << updatedDescriptor.getName()
                                  << " md5: " << updatedDescriptor.getMd5().getHash()
                                  << " from " << getFormatedIp(sourceAddress);
+        if (!stored) {
+            sendCommandRefused(MessageType::HOLDER_CHANGE, "file not stored! Try again.", sourceAddress,
+                               updatedDescriptor.getMd5());
+            return;
+        }
         // this descriptor will be valid now
         updatedDescriptor.makeValid();
 
-        // get file content
-        std::vector<uint8_t> fileContent(size - sizeof(FileDescriptor));
-        memcpy(fileContent.data(), data + sizeof(FileDescriptor), size - sizeof(FileDescriptor));
-
-        // store this file by its md5 hash
-        storeFileContent(fileContent, updatedDescriptor.getMd5().getHash());
-
         // update local descriptors table
         {
             Guard guard(mutex);
             localDescriptors.push_back(updatedDescriptor);
+            localChanges.put(updatedDescriptor);
         }
 
-        // publish new descriptor
-        P2PMessage message{};
-        message.setMessageType(MessageType::UPDATE_DESCRIPTOR);
-        message.setAdditionalDataSize(sizeof(FileDescriptor));
-
-        // prepare message
-        std::vector<uint8_t> buffer(sizeof(P2PMessage) + message.getAdditionalDataSize());
-        memcpy(buffer.data(), (uint8_t *) &message, sizeof(P2PMessage));
-        memcpy(buffer.data() + sizeof(P2PMessage), (uint8_t *) &updatedDescriptor, sizeof(FileDescriptor));
-
-        udpServer->broadcast(buffer.data(), buffer.size());
+        // publish new descriptor, together with the other files moved here at the same time
+        updatesBatcher->add(updatedDescriptor);
         BOOST_LOG_TRIVIAL(debug) << ">>> UPDATE_DESCRIPTOR: " << updatedDescriptor.getName()
                                  << " md5: " << updatedDescriptor.getMd5().getHash();
     };
 
     // =================================================================================================================
     // reply for our request for file
-    msgProcessors[MessageType::FILE_TRANSFER] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
-        FileDescriptor descriptor = *(FileDescriptor *) data;
-
-        // at the beginning was the descriptor present
-        std::vector<uint8_t> buffer(size - sizeof(FileDescriptor));
-
-        // copy the file content to our buffer
-        memcpy(buffer.data(), data + sizeof(FileDescriptor), size - sizeof(FileDescriptor));
-
-        // store received file into FS
-        storeFileContent(buffer, descriptor.getName());
-        auto storedFileHash = Md5sum(descriptor.getName()).getMd5Hash();
-
-        // check hash
-        if (storedFileHash != descriptor.getMd5()) {
-            BOOST_LOG_TRIVIAL(debug) << "<<< FILE_TRANSFER: md5 differs!!! is: "
-                                     << storedFileHash.getHash()
-                                     << " should be: " << descriptor.getMd5().getHash();
+    fileProcessors[MessageType::FILE_TRANSFER] = [](FileDescriptor &descriptor, bool stored,
+                                                    in_addr_t sourceAddress) {
+        if (!stored) {
+            BOOST_LOG_TRIVIAL(debug) << "<<< FILE_TRANSFER: " << descriptor.getName()
+                                     << " not stored, md5 should be: " << descriptor.getMd5().getHash();
+            // interrupted transfer leaves its part to be continued by the next request
+            bool interrupted = FileStorer(descriptor.getName()).getPartialSize() > 0;
+            operations.complete(MessageType::GET_FILE, descriptor.getMd5(), PendingOperations::Status::FAILED,
+                                interrupted ? "transfer interrupted, part of the file kept" : "file's hash differ");
             return;
         }
 
         BOOST_LOG_TRIVIAL(debug) << "<<< FILE_TRANSFER: received " << descriptor.getName()
                                  << " md5: " << descriptor.getMd5().getHash()
                                  << " from " << getFormatedIp(sourceAddress);
+        operations.complete(MessageType::GET_FILE, descriptor.getMd5(), PendingOperations::Status::COMPLETED);
     };
 
     // =================================================================================================================
-    // request for upload a file: other node send us a file via TCP and we have to publish it in the network
-    msgProcessors[MessageType::UPLOAD_FILE] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
-        FileDescriptor descriptor = *(FileDescriptor *) data;
-
-        // prepare buffer
-        std::vector<uint8_t> buffer(size - sizeof(FileDescriptor));
-        // copy file content
-        memcpy(buffer.data(), data + sizeof(FileDescriptor), size - sizeof(FileDescriptor));
-        // store file as its hash
-        auto newFileName = descriptor.getMd5().getHash();
-        storeFileContent(buffer, newFileName);
-        // check hash
-        auto newFileHash = Md5sum(newFileName).getMd5Hash();
-
-        if (newFileHash != descriptor.getMd5()) {
-            BOOST_LOG_TRIVIAL(debug) << "<<< UPLOAD_FILE: hashes differ!!! is: " << newFileHash.getHash()
-                                     << " should be: " << descriptor.getMd5().getHash()
-                                     << "; file not published into networ";
-            sendCommandRefused(MessageType::UPLOAD_FILE, "file's hash differ! Try again.", sourceAddress);
-            // does nothing more, network does not now about the file
+    // request for upload a file: other node sent us a file via TCP and we have to publish it in the network
+    fileProcessors[MessageType::UPLOAD_FILE] = [](FileDescriptor &descriptor, bool stored, in_addr_t sourceAddress) {
+        if (!stored) {
+            BOOST_LOG_TRIVIAL(debug) << "<<< UPLOAD_FILE: " << descriptor.getName()
+                                     << " not stored; file not published into network";
+            sendCommandRefused(MessageType::UPLOAD_FILE, "file's hash differ! Try again.", sourceAddress,
+                               descriptor.getMd5());
+            // network does not know about the file, only about the space reserved for it
+            releaseHolderNode(descriptor);
             return;
         }
 
@@ -396,28 +668,40 @@ void p2p::util::initProcessingFunctions() {
             // append to our local descriptors
             Guard guard(mutex);
             localDescriptors.push_back(descriptor);
+            localChanges.put(descriptor);
         }
 
         // notify the network about new file
-        P2PMessage message{};
-        message.setMessageType(MessageType::NEW_FILE);
-        message.setAdditionalDataSize(sizeof(FileDescriptor));
-
-        buffer.resize(sizeof(P2PMessage) + message.getAdditionalDataSize());
-
-        memcpy(buffer.data(), &message, sizeof(P2PMessage));
-        memcpy(buffer.data() + sizeof(P2PMessage), (uint8_t *) &descriptor, sizeof(FileDescriptor));
-
-        udpServer->broadcast(buffer.data(), buffer.size());
+        publishDescriptor(descriptor);
     };
 
     // =================================================================================================================
     // other node want to access a file stored in our node
     msgProcessors[MessageType::GET_FILE] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
-        FileDescriptor descriptor = *(FileDescriptor *) data;
+        FileDescriptor descriptor;
+        size_t descriptorSize = DescriptorCodec::decode(data, size, descriptor);
+        if (descriptorSize == 0 || size < descriptorSize + 2 * sizeof(uint64_t)) {
+            sendCommandRefused(MessageType::GET_FILE, "malformed request", sourceAddress);
+            return;
+        }
+        // requested range of the file; length 0 means up to the end
+        uint64_t offset, length;
+        memcpy(&offset, data + descriptorSize, sizeof offset);
+        memcpy(&length, data + descriptorSize + sizeof offset, sizeof length);
+
         BOOST_LOG_TRIVIAL(debug) << "<<< GET_FILE: request for " << descriptor.getName()
                                  << " md5: " << descriptor.getMd5().getHash()
+                                 << " from byte " << offset << ", " << length << " bytes"
                                  << " from " << getFormatedIp(sourceAddress);
+        if (length != 0) {
+            // the requester learns from FILE_TRANSFER how much of the range it gets
+            if (offset >= descriptor.getSize()) {
+                sendCommandRefused(MessageType::GET_FILE, "range outside the file", sourceAddress,
+                                   descriptor.getMd5());
+                return;
+            }
+            length = std::min<uint64_t>(length, descriptor.getSize() - offset);
+        }
         {
             Guard guard(mutex);
             // check validity of requested file
@@ -426,61 +710,56 @@ void p2p::util::initProcessingFunctions() {
                     // request for discarded file
                     sendCommandRefused(MessageType::GET_FILE,
                                        "request for discarded file! try again for a while",
-                                       sourceAddress);
+                                       sourceAddress, descriptor.getMd5());
                     // do not send the file
                     return;
                 }
             }
         }
 
-        P2PMessage message{};
-        // set message type as file transfer
-        message.setMessageType(MessageType::FILE_TRANSFER);
-        // get file content
-        auto fileContent = getFileContent(descriptor.getMd5().getHash());
-        // set msg additional size to size of the descriptor and file content length
-        message.setAdditionalDataSize(sizeof(FileDescriptor) + fileContent.size());
-        // prepare buffer
-        std::vector<uint8_t> buffer(sizeof(P2PMessage) + message.getAdditionalDataSize());
-
-        // prepare message
-        memcpy(buffer.data(), &message, sizeof(P2PMessage));
-        memcpy(buffer.data() + sizeof(P2PMessage), &descriptor, sizeof(FileDescriptor));
-        memcpy(buffer.data() + sizeof(P2PMessage) + sizeof(FileDescriptor), fileContent.data(), fileContent.size());
-
-        tcpServer->sendData(buffer.data(), buffer.size(), sourceAddress);
+        // reply with the descriptor followed by the range of the file stored by its hash
+        MessageBuilder message(MessageType::FILE_TRANSFER);
+        message.addPayload(DescriptorCodec::encode(descriptor))
+               .add(offset)
+               .add(length)
+               .attachFile(descriptor.getMd5().getHash(), offset, length);
+        tcpServer->sendMessage(std::move(message), sourceAddress);
     };
 
     // =================================================================================================================
     // someone requested to delete file sored in our machine
     msgProcessors[MessageType::DELETE_FILE] = [](const uint8_t *data, uint32_t size, in_addr_t sourceAddress) {
         // file was discarded already by request node - we have to delete it and publish REVOKE
-        FileDescriptor descriptor = *(FileDescriptor *) data;
+        FileDescriptor descriptor;
+        if (DescriptorCodec::decode(data, size, descriptor) == 0) {
+            sendCommandRefused(MessageType::DELETE_FILE, "malformed descriptor", sourceAddress);
+            return;
+        }
 
         FileDeleter deleter(descriptor.getMd5().getHash());
         if (!deleter.deleteFile()) {
             // error - file should exsist
-            sendCommandRefused(MessageType::DELETE_FILE, "file does not exist", sourceAddress);
+            sendCommandRefused(MessageType::DELETE_FILE, "file does not exist", sourceAddress, descriptor.getMd5());
             return;
         }
 
         auto removedFileHash = descriptor.getMd5();
         // file successfully deleted!
         // remove descriptor from localDescriptors
-        localDescriptors.erase(std::remove_if(localDescriptors.begin(), localDescriptors.end(),
-                                              [&removedFileHash](const FileDescriptor &fd) {
-                                                  return fd.getMd5() == removedFileHash;
-                                              }));
-
-        // publish revoke
-        P2PMessage message{};
-        message.setMessageType(MessageType::REVOKE_FILE);
-        message.setAdditionalDataSize(sizeof(FileDescriptor));
-
-        std::vector<uint8_t> buffer(sizeof(P2PMessage) + message.getAdditionalDataSize());
-        memcpy(buffer.data(), &message, sizeof(P2PMessage));
-        memcpy(buffer.data() + sizeof(P2PMessage), &descriptor, sizeof(FileDescriptor));
+        {
+            Guard guard(mutex);
+            for (auto &&localDescriptor : localDescriptors) {
+                if (localDescriptor.getMd5() == removedFileHash) {
+                    localChanges.remove(localDescriptor);
+                }
+            }
+            localDescriptors.erase(std::remove_if(localDescriptors.begin(), localDescriptors.end(),
+                                                  [&removedFileHash](const FileDescriptor &fd) {
+                                                      return fd.getMd5() == removedFileHash;
+                                                  }), localDescriptors.end());
+        }
 
-        udpServer->broadcast(buffer.data(), buffer.size());
+        // publish revoke, together with the other deletions of the moment (REVOKE_FILES)
+        revocationsBatcher->add(descriptor);
     };
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "RebalancePlanner.hpp"
+
+constexpr double RebalancePlanner::MAX_BYTES_PER_REDUCTION;
+
+int64_t RebalancePlanner::getReduction(int64_t excess, int64_t deficit, uint64_t size) {
+    int64_t moved = (int64_t) size;
+    return excess + deficit - std::llabs(excess - moved) - std::llabs(deficit - moved);
+}
+
+std::vector<RebalancePlanner::Move> RebalancePlanner::plan(
+        in_addr_t source, const std::vector<FileDescriptor> &files,
+        const std::unordered_map<in_addr_t, NodeLoadTable::NodeLoad> &loads) {
+    std::vector<Move> moves;
+    auto sourceLoad = loads.find(source);
+    if (sourceLoad == loads.end() || loads.size() < 2) {
+        return moves;
+    }
+
+    uint64_t totalBytes = 0;
+    for (auto &&load : loads) {
+        totalBytes += load.second.bytes;
+    }
+    const int64_t target = (int64_t) (totalBytes / loads.size());
+    int64_t excess = (int64_t) sourceLoad->second.bytes - target;
+    if (excess <= 0) {
+        return moves;
+    }
+
+    // share of every underloaded node in our excess, ordered by the address for equal plans on all the nodes
+    std::vector<std::pair<in_addr_t, int64_t>> quotas;
+    double totalDeficit = 0;
+    for (auto &&load : loads) {
+        if ((int64_t) load.second.bytes < target) {
+            quotas.emplace_back(load.first, target - (int64_t) load.second.bytes);
+            totalDeficit += quotas.back().second;
+        }
+    }
+    std::sort(quotas.begin(), quotas.end());
+    for (auto &&quota : quotas) {
+        quota.second = std::llround(excess * (quota.second / totalDeficit));
+    }
+
+    std::vector<const FileDescriptor *> candidates;
+    for (auto &&file : files) {
+        if (file.getSize() > 0) {
+            candidates.push_back(&file);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const FileDescriptor *first, const FileDescriptor *second) {
+        if (first->getSize() != second->getSize()) {
+            return first->getSize() > second->getSize();
+        }
+        return first->getMd5() < second->getMd5();
+    });
+
+    // moves which fit both the excess and a quota remove twice their size - the best possible rank;
+    // decreasing sizes into the most starving node pack the quotas closely
+    std::vector<const FileDescriptor *> left;
+    for (auto &&file : candidates) {
+        int64_t size = (int64_t) file->getSize();
+        auto quota = std::max_element(quotas.begin(), quotas.end(),
+                                      [](const std::pair<in_addr_t, int64_t> &first,
+                                         const std::pair<in_addr_t, int64_t> &second) {
+                                          return first.second < second.second;
+                                      });
+        if (size > excess || quota == quotas.end() || size > quota->second) {
+            left.push_back(file);
+            continue;
+        }
+        moves.push_back({file->getMd5(), file->getSize(), quota->first});
+        excess -= size;
+        quota->second -= size;
+    }
+
+    // files overshooting the excess or the quota: the best ranked one at a time;
+    // each of them closes either the excess or a quota, so there are only a few rounds
+    while (excess > 0 && !left.empty()) {
+        double bestRank = MAX_BYTES_PER_REDUCTION;
+        auto bestFile = left.end();
+        std::pair<in_addr_t, int64_t> *bestQuota = nullptr;
+        for (auto file = left.begin(); file != left.end(); ++file) {
+            for (auto &&quota : quotas) {
+                int64_t reduction = getReduction(excess, quota.second, (*file)->getSize());
+                if (reduction <= 0) {
+                    continue;
+                }
+                double rank = (double) (*file)->getSize() / reduction;
+                // on equal ranks the larger file, which comes first, wins
+                if (bestFile == left.end() ? rank <= bestRank : rank < bestRank) {
+                    bestRank = rank;
+                    bestFile = file;
+                    bestQuota = &quota;
+                }
+            }
+        }
+        if (bestFile == left.end()) {
+            break;
+        }
+        moves.push_back({(*bestFile)->getMd5(), (*bestFile)->getSize(), bestQuota->first});
+        excess -= (int64_t) (*bestFile)->getSize();
+        bestQuota->second -= (int64_t) (*bestFile)->getSize();
+        left.erase(bestFile);
+    }
+    return moves;
+}
@@ -0,0 +1,60 @@
+#include "Rebalancer.hpp"
+
+Rebalancer::Rebalancer(Mover moverFunc, uint64_t bytesPerSecond)
+        : mover(std::move(moverFunc)), bucket(bytesPerSecond, bytesPerSecond), stopping(false) {
+    thread = new Thread(&Rebalancer::runHelper, (void *) this, NULL);
+}
+
+void *Rebalancer::runHelper(void *rebalancer) {
+    ((Rebalancer *) rebalancer)->run();
+    return NULL;
+}
+
+void Rebalancer::run() {
+    typedef TokenBucket::Clock Clock;
+
+    mutex.lock();
+    Clock::time_point next = Clock::now();
+    while (!stopping) {
+        if (pending.empty()) {
+            changed.wait(mutex);
+            continue;
+        }
+        long left = std::chrono::duration_cast<std::chrono::milliseconds>(next - Clock::now()).count();
+        if (left > 0) {
+            // woken up early to stop or by a new plan
+            changed.waitFor(mutex, left);
+            continue;
+        }
+        RebalancePlanner::Move move = pending.front();
+        pending.pop_front();
+        mutex.unlock();
+        bool moved = mover(move);
+        mutex.lock();
+        if (moved) {
+            next = Clock::now() + bucket.take(move.size);
+        }
+    }
+    mutex.unlock();
+}
+
+void Rebalancer::schedule(std::vector<RebalancePlanner::Move> moves) {
+    Guard guard(mutex);
+    pending.assign(moves.begin(), moves.end());
+    changed.notifyAll();
+}
+
+size_t Rebalancer::getPendingMoves() const {
+    Guard guard(mutex);
+    return pending.size();
+}
+
+Rebalancer::~Rebalancer() {
+    mutex.lock();
+    stopping = true;
+    changed.notifyAll();
+    mutex.unlock();
+
+    thread->get();
+    delete thread;
+}
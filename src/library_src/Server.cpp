@@ -7,81 +7,172 @@
 #include <netdb.h>
 #include <ifaddrs.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 #include <iostream>
 #include <stdexcept>
 
-void Server::finishThread()
+void Server::stopListening()
 {
-    stopMutex.lock();
-    if (stop.load())
-    {
-        stopMutex.unlock();
-        return;
-    }
-	threadsVecMutex.lock();
-	stopMutex.unlock();
-
-	for (auto i = connectionThreads.begin(); i != connectionThreads.end(); ++i)
-	{
-		if ( i->isCurrentThread() )
-		{
-			connectionThreads.erase(i);
-            threadsVecMutex.unlock();
-			pthread_detach(pthread_self());
-			Thread::exit();
-		}
-	}
+    // datagrams already queued in the socket are still received before the shutdown is noticed
+    stopListener();
+    stopExecutor();
 }
 
-void Server::stopListening()
+void Server::stopListener()
 {
-    usleep(50000);
-    stopMutex.lock();
     stop = true;
+    if (listenSocket == -1)
+    {
+        return;
+    }
     shutdown(listenSocket, SHUT_RDWR);
-    threadsVecMutex.lock();
-    stopMutex.unlock();
-
-	waitForThreadsToFinish();
-	close(listenSocket);
-	threadsVecMutex.unlock();
 
 	if (listenerThread != nullptr)
     {
         listenerThread->get();
         delete listenerThread;
+        listenerThread = nullptr;
     }
+	close(listenSocket);
+    listenSocket = -1;
+}
+
+void Server::stopExecutor()
+{
+    executor.shutdown();
 }
 
 bool Server::addDispatcherThread(void * function_pointer(void *), void * arg, void ** retval)
 {
-    stopMutex.lock();
     if (stop)
     {
-        stopMutex.unlock();
         return false;
     }
-    threadsVecMutex.lock();
-    stopMutex.unlock();
-    connectionThreads.emplace_back(function_pointer, arg , retval);
-    threadsVecMutex.unlock();
-    return true;
+    return executor.submit(function_pointer, arg);
 }
 
-void Server::waitForThreadsToFinish()
+std::atomic<in_addr_t> Server::localhostIp(INADDR_NONE);
+
+namespace
 {
-	for (auto i = connectionThreads.begin(); i != connectionThreads.end(); ++i)
-	{
-		i->get();
-	}
+    pthread_once_t localhostIpOnce = PTHREAD_ONCE_INIT;
 }
 
 in_addr_t Server::getLocalhostIp()
+{
+    pthread_once(&localhostIpOnce, &Server::initLocalhostIp);
+    in_addr_t address = localhostIp.load(std::memory_order_relaxed);
+    if (address == INADDR_NONE)
+    {
+        // no address at startup - keep trying until the interface comes up
+        refreshLocalhostIp();
+        address = localhostIp.load(std::memory_order_relaxed);
+    }
+    return address;
+}
+
+void Server::refreshLocalhostIp()
+{
+    in_addr_t address;
+    try
+    {
+        address = resolveLocalhostIp();
+    }
+    catch (const std::runtime_error&)
+    {
+        // interfaces are being reconfigured - keep the previous address until the next event
+        return;
+    }
+    if (address != INADDR_NONE)
+    {
+        localhostIp.store(address, std::memory_order_relaxed);
+    }
+}
+
+void Server::initLocalhostIp()
+{
+    refreshLocalhostIp();
+
+    // watcher lives as long as the process
+    Thread watcher(&Server::watchAddressChanges, nullptr, nullptr);
+    watcher.detach();
+}
+
+void* Server::watchAddressChanges(void* arg)
+{
+    int netlinkSocket = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (netlinkSocket == -1)
+    {
+        return nullptr;
+    }
+
+    struct sockaddr_nl address;
+    memset(&address, 0, sizeof address);
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_IPV4_IFADDR | RTMGRP_IPV4_ROUTE;
+    if (bind(netlinkSocket, (struct sockaddr*) &address, sizeof address) == -1)
+    {
+        close(netlinkSocket);
+        return nullptr;
+    }
+
+    char buffer[8192];
+    while (true)
+    {
+        ssize_t received = recv(netlinkSocket, buffer, sizeof buffer, 0);
+        if (received == -1)
+        {
+            if (errno == ENOBUFS)
+            {
+                // some events have been dropped - one of them might have been ours
+                refreshLocalhostIp();
+                continue;
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        bool addressChanged = false;
+        int length = (int) received;
+        for (struct nlmsghdr* header = (struct nlmsghdr*) buffer; NLMSG_OK(header, length);
+                header = NLMSG_NEXT(header, length))
+        {
+            switch (header->nlmsg_type)
+            {
+                case RTM_NEWADDR:
+                case RTM_DELADDR:
+                case RTM_NEWROUTE:
+                case RTM_DELROUTE:
+                    addressChanged = true;
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (addressChanged)
+        {
+            refreshLocalhostIp();
+        }
+    }
+    close(netlinkSocket);
+    return nullptr;
+}
+
+in_addr_t Server::resolveLocalhostIp()
 {
     FILE *f;
-    char line[100] , *p , *c;
+    char line[100] , *p = NULL , *c;
 
     f = fopen("/proc/net/route" , "r");
+    if (f == NULL)
+    {
+        throw std::runtime_error("Could not get local ip address");
+    }
 
     while(fgets(line , 100 , f))
     {
@@ -101,10 +192,11 @@ in_addr_t Server::getLocalhostIp()
     int fm = AF_INET;
     struct ifaddrs *ifaddr, *ifa;
     int family , s;
-    char host[NI_MAXHOST];
+    char host[NI_MAXHOST] = "";
 
-    if (getifaddrs(&ifaddr) == -1)
+    if (p == NULL || getifaddrs(&ifaddr) == -1)
     {
+        fclose(f);
         throw std::runtime_error("Could not get local ip address");
     }
 
@@ -126,6 +218,8 @@ in_addr_t Server::getLocalhostIp()
 
                 if (s != 0)
                 {
+                    fclose(f);
+                    freeifaddrs(ifaddr);
                     throw std::runtime_error("Could not get local ip address");
                 }
             }
@@ -138,11 +232,13 @@ in_addr_t Server::getLocalhostIp()
     return inet_addr(host);
 }
 
-Server::Server() : stop(false)
+Server::Server(unsigned workerThreads, size_t taskQueueCapacity)
+    : executor(workerThreads, taskQueueCapacity), listenSocket(-1), stop(false)
 {
     listenerThread = nullptr;
 }
 
 Server::~Server()
 {
+    stopExecutor();
 }
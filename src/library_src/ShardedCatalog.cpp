@@ -0,0 +1,158 @@
+#include "ShardedCatalog.hpp"
+
+const size_t ShardedCatalog::SHARDS_COUNT;
+
+ShardedCatalog::Snapshot::Snapshot(std::vector<DescriptorCatalog::Snapshot> &&shardSnapshots)
+        : shards(std::move(shardSnapshots)) {
+}
+
+size_t ShardedCatalog::Snapshot::size() const {
+    size_t size = 0;
+    for (auto &&shard : shards) {
+        size += shard->size();
+    }
+    return size;
+}
+
+std::vector<FileDescriptor> ShardedCatalog::Snapshot::toVector() const {
+    std::vector<FileDescriptor> descriptors;
+    descriptors.reserve(size());
+    for (auto &&shard : shards) {
+        descriptors.insert(descriptors.end(), shard->begin(), shard->end());
+    }
+    return descriptors;
+}
+
+ShardedCatalog::ShardedCatalog() {
+    for (size_t i = 0; i < SHARDS_COUNT; ++i) {
+        shards.emplace_back(new Shard(&loads));
+    }
+}
+
+bool ShardedCatalog::insert(const FileDescriptor &descriptor) {
+    return withShard(descriptor.getMd5(), [&descriptor](DescriptorCatalog &catalog) {
+        return catalog.insert(descriptor);
+    });
+}
+
+void ShardedCatalog::upsert(const FileDescriptor &descriptor) {
+    withShard(descriptor.getMd5(), [&descriptor](DescriptorCatalog &catalog) {
+        catalog.upsert(descriptor);
+    });
+}
+
+bool ShardedCatalog::erase(const Md5Hash &hash) {
+    return withShard(hash, [&hash](DescriptorCatalog &catalog) {
+        return catalog.erase(hash);
+    });
+}
+
+bool ShardedCatalog::setValid(const Md5Hash &hash, bool valid) {
+    return withShard(hash, [&hash, valid](DescriptorCatalog &catalog) {
+        return catalog.setValid(hash, valid);
+    });
+}
+
+size_t ShardedCatalog::invalidateHolder(in_addr_t holder) {
+    size_t invalidated = 0;
+    for (auto &&shard : shards) {
+        Guard guard(shard->mutex);
+        invalidated += shard->catalog.invalidateHolder(holder);
+        shard->catalog.publish();
+    }
+    return invalidated;
+}
+
+size_t ShardedCatalog::eraseHolder(in_addr_t holder) {
+    size_t erased = 0;
+    for (auto &&shard : shards) {
+        Guard guard(shard->mutex);
+        erased += shard->catalog.eraseHolder(holder);
+        shard->catalog.publish();
+    }
+    return erased;
+}
+
+bool ShardedCatalog::find(const Md5Hash &hash, FileDescriptor &found) const {
+    const Shard &shard = getShard(hash);
+    Guard guard(shard.mutex);
+    const FileDescriptor *descriptor = shard.catalog.find(hash);
+    if (descriptor == nullptr) {
+        return false;
+    }
+    found = *descriptor;
+    return true;
+}
+
+bool ShardedCatalog::contains(const Md5Hash &hash) const {
+    const Shard &shard = getShard(hash);
+    Guard guard(shard.mutex);
+    return shard.catalog.find(hash) != nullptr;
+}
+
+std::vector<FileDescriptor> ShardedCatalog::findByName(const std::string &name) const {
+    // files with the same name may have any digests
+    std::vector<FileDescriptor> found;
+    for (auto &&shard : shards) {
+        Guard guard(shard->mutex);
+        auto inShard = shard->catalog.findByName(name);
+        found.insert(found.end(), inShard.begin(), inShard.end());
+    }
+    return found;
+}
+
+std::vector<FileDescriptor> ShardedCatalog::findByHolder(in_addr_t holder) const {
+    std::vector<FileDescriptor> found;
+    for (auto &&shard : shards) {
+        Guard guard(shard->mutex);
+        auto inShard = shard->catalog.findByHolder(holder);
+        found.insert(found.end(), inShard.begin(), inShard.end());
+    }
+    return found;
+}
+
+size_t ShardedCatalog::size() const {
+    size_t size = 0;
+    for (auto &&shard : shards) {
+        Guard guard(shard->mutex);
+        size += shard->catalog.size();
+    }
+    return size;
+}
+
+bool ShardedCatalog::empty() const {
+    for (auto &&shard : shards) {
+        Guard guard(shard->mutex);
+        if (!shard->catalog.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ShardedCatalog::Snapshot ShardedCatalog::getSnapshot() const {
+    std::vector<DescriptorCatalog::Snapshot> shardSnapshots;
+    shardSnapshots.reserve(shards.size());
+    for (auto &&shard : shards) {
+        shardSnapshots.push_back(shard->catalog.getSnapshot());
+    }
+    return Snapshot(std::move(shardSnapshots));
+}
+
+NodeLoadTable &ShardedCatalog::getLoads() {
+    return loads;
+}
+
+ShardedCatalog::Shard &ShardedCatalog::getShard(const Md5Hash &hash) {
+    return *shards[shardIndex(hash)];
+}
+
+const ShardedCatalog::Shard &ShardedCatalog::getShard(const Md5Hash &hash) const {
+    return *shards[shardIndex(hash)];
+}
+
+size_t ShardedCatalog::shardIndex(const Md5Hash &hash) {
+    // shards use the last bytes of the digest, the hash maps inside them - the first ones
+    const unsigned char *digest = hash.getDigest();
+    return (digest[MD5_DIGEST_SIZE - 2] << 8 | digest[MD5_DIGEST_SIZE - 1]) % SHARDS_COUNT;
+}
@@ -0,0 +1,293 @@
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/sendfile.h>
+#include <limits.h>
+#include <algorithm>
+
+#include "TcpConnectionPool.hpp"
+
+TcpConnectionPool::TcpConnectionPool(int p) : port(p)
+{
+}
+
+static iovec singleSegment(const uint8_t* data, size_t size)
+{
+	iovec segment;
+	segment.iov_base = (void*) data;
+	segment.iov_len = size;
+	return segment;
+}
+
+SocketOperation::Status TcpConnectionPool::send(const uint8_t* data, size_t size, in_addr_t toWhom)
+{
+	iovec segment = singleSegment(data, size);
+	return send(&segment, 1, toWhom);
+}
+
+SocketOperation::Status TcpConnectionPool::send(const iovec* segments, int segmentsCount, in_addr_t toWhom)
+{
+	return sendPooled(Payload(segments, segmentsCount), toWhom);
+}
+
+SocketOperation::Status TcpConnectionPool::sendFile(const iovec* segments, int segmentsCount, int fileFd,
+		off_t offset, size_t fileSize, in_addr_t toWhom)
+{
+	return sendPooled(Payload(segments, segmentsCount, fileFd, offset, fileSize), toWhom);
+}
+
+SocketOperation::Status TcpConnectionPool::sendFile(const uint8_t* head, size_t headSize, int fileFd,
+		off_t offset, size_t fileSize, in_addr_t toWhom)
+{
+	iovec segment = singleSegment(head, headSize);
+	return sendFile(&segment, 1, fileFd, offset, fileSize, toWhom);
+}
+
+SocketOperation::Status TcpConnectionPool::sendPooled(const Payload &payload, in_addr_t toWhom)
+{
+	int sendSocket = acquire(toWhom);
+	bool reused = sendSocket != -1;
+
+	while(1)
+	{
+		if (sendSocket == -1)
+		{
+			SocketOperation::Status failure;
+			sendSocket = connectTo(toWhom, failure);
+			if (sendSocket == -1)
+			{
+				return failure;
+			}
+		}
+
+		size_t written = 0;
+		if (writePayload(sendSocket, payload, written))
+		{
+			release(toWhom, sendSocket);
+			return SocketOperation::Status::Success;
+		}
+		int error = errno;
+		close(sendSocket);
+
+		// resending after a partial write would put a truncated frame before the whole one
+		if (!reused || written > 0 || (error != EPIPE && error != ECONNRESET))
+		{
+			return SocketOperation::Status::SendFailed;
+		}
+		// pooled connection went down while it was idle - try once more on a fresh one
+		reused = false;
+		sendSocket = -1;
+	}
+}
+
+SocketOperation::Status TcpConnectionPool::sendOnce(const uint8_t* data, size_t size, in_addr_t toWhom)
+{
+	iovec segment = singleSegment(data, size);
+	return sendOnce(&segment, 1, toWhom);
+}
+
+SocketOperation::Status TcpConnectionPool::sendOnce(const iovec* segments, int segmentsCount, in_addr_t toWhom)
+{
+	SocketOperation::Status status;
+	int sendSocket = connectTo(toWhom, status);
+	if (sendSocket == -1)
+	{
+		return status;
+	}
+
+	size_t written = 0;
+	status = sendAll(sendSocket, segments, segmentsCount, written) ? SocketOperation::Status::Success
+			: SocketOperation::Status::SendFailed;
+	close(sendSocket);
+	return status;
+}
+
+int TcpConnectionPool::acquire(in_addr_t toWhom)
+{
+	Guard guard(poolMutex);
+	closeExpired(Clock::now());
+
+	auto peer = idleConnections.find(toWhom);
+	if (peer == idleConnections.end())
+	{
+		return -1;
+	}
+
+	// most recently used connections are at the back
+	while (!peer->second.empty())
+	{
+		int socket = peer->second.back().socket;
+		peer->second.pop_back();
+		if (isAlive(socket))
+		{
+			return socket;
+		}
+		close(socket);
+	}
+	return -1;
+}
+
+void TcpConnectionPool::release(in_addr_t toWhom, int socket)
+{
+	Guard guard(poolMutex);
+	std::vector<IdleConnection> &connections = idleConnections[toWhom];
+	if (connections.size() >= MAX_IDLE_PER_PEER)
+	{
+		close(socket);
+		return;
+	}
+	connections.emplace_back(socket, Clock::now());
+}
+
+void TcpConnectionPool::closeExpired(Clock::time_point now)
+{
+	for (auto peer = idleConnections.begin(); peer != idleConnections.end();)
+	{
+		std::vector<IdleConnection> &connections = peer->second;
+		auto firstValid = connections.begin();
+		while (firstValid != connections.end() && now - firstValid->lastUsed > IDLE_TIMEOUT)
+		{
+			close(firstValid->socket);
+			++firstValid;
+		}
+		connections.erase(connections.begin(), firstValid);
+
+		if (connections.empty())
+		{
+			peer = idleConnections.erase(peer);
+		}
+		else
+		{
+			++peer;
+		}
+	}
+}
+
+int TcpConnectionPool::connectTo(in_addr_t toWhom, SocketOperation::Status &failure)
+{
+	sockaddr_in sendAddr;
+	sendAddr.sin_family = AF_INET;
+	sendAddr.sin_port = htons(port);
+	sendAddr.sin_addr.s_addr = toWhom;
+
+	int sendSocket = socket(AF_INET, SOCK_STREAM, 0);
+	if (sendSocket == -1)
+	{
+		failure = SocketOperation::Status::CantOpenSocket;
+		return -1;
+	}
+
+	struct timeval timeout;
+	timeout.tv_sec = SEND_TIMEOUT_SEC;
+	timeout.tv_usec = 0;
+	setsockopt(sendSocket, SOL_SOCKET, SO_SNDTIMEO, (char *)&timeout,
+			sizeof(timeout));
+
+	if (connect(sendSocket, (sockaddr*) &sendAddr, sizeof(sendAddr)) == -1)
+	{
+		close(sendSocket);
+		failure = SocketOperation::Status::CantConnect;
+		return -1;
+	}
+	return sendSocket;
+}
+
+bool TcpConnectionPool::isAlive(int socket)
+{
+	// receiving side never writes to us, so anything readable means EOF or error
+	uint8_t byte;
+	int readLength = recv(socket, &byte, sizeof byte, MSG_PEEK | MSG_DONTWAIT);
+	return readLength < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+bool TcpConnectionPool::writePayload(int socket, const Payload &payload, size_t &written)
+{
+	bool fileFollows = payload.fileFd != -1 && payload.fileSize > 0;
+	// head is held back until the file body joins it, instead of going out as a small segment
+	if (!sendAll(socket, payload.segments, payload.segmentsCount, written, fileFollows ? MSG_MORE : 0))
+	{
+		return false;
+	}
+	return !fileFollows || sendFileAll(socket, payload.fileFd, payload.fileOffset, payload.fileSize, written);
+}
+
+bool TcpConnectionPool::sendAll(int socket, const iovec* segments, int segmentsCount, size_t &written, int flags)
+{
+	// partially sent segments are trimmed on a copy
+	std::vector<iovec> remaining(segments, segments + segmentsCount);
+	size_t first = 0;
+
+	while (1)
+	{
+		while (first < remaining.size() && remaining[first].iov_len == 0)
+		{
+			++first;
+		}
+		if (first == remaining.size())
+		{
+			return true;
+		}
+
+		msghdr message{};
+		message.msg_iov = remaining.data() + first;
+		message.msg_iovlen = std::min<size_t>(remaining.size() - first, IOV_MAX);
+
+		ssize_t sent = sendmsg(socket, &message, MSG_NOSIGNAL | flags);
+		if (sent < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (sent <= 0)
+		{
+			return false;
+		}
+		written += sent;
+
+		for (size_t i = first; sent > 0; ++i)
+		{
+			size_t part = std::min<size_t>(sent, remaining[i].iov_len);
+			remaining[i].iov_base = (uint8_t*) remaining[i].iov_base + part;
+			remaining[i].iov_len -= part;
+			sent -= part;
+		}
+	}
+}
+
+bool TcpConnectionPool::sendFileAll(int socket, int fileFd, off_t offset, size_t size, size_t &written)
+{
+	while (size > 0)
+	{
+		ssize_t sent = sendfile(socket, fileFd, &offset, size);
+		if (sent < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		// zero means the file has been truncated in the meantime
+		if (sent <= 0)
+		{
+			return false;
+		}
+		written += sent;
+		size -= sent;
+	}
+	return true;
+}
+
+void TcpConnectionPool::closeAll()
+{
+	Guard guard(poolMutex);
+	for (auto &&peer : idleConnections)
+	{
+		for (auto &&connection : peer.second)
+		{
+			close(connection.socket);
+		}
+	}
+	idleConnections.clear();
+}
+
+TcpConnectionPool::~TcpConnectionPool()
+{
+	closeAll();
+}
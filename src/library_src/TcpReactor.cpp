@@ -0,0 +1,382 @@
+#include <unistd.h>
+#include <string.h>
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+#include "TcpReactor.hpp"
+#include "SocketExceptions.hpp"
+
+TcpReactor::TcpReactor(void (*reactFunc)(uint8_t*, uint32_t, SocketOperation),
+		void (*errorCallbackFunc)(SocketOperation), ThreadPool* executorPool,
+		StreamFactory streamFactoryFunc)
+	: react(reactFunc), errorCallback(errorCallbackFunc), streamFactory(streamFactoryFunc),
+	  executor(executorPool),
+	  reactorThread(nullptr), stopping(false)
+{
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	if (epollFd == -1)
+	{
+		std::string err = "Could not create epoll instance. Additional"
+				"info: ";
+		err += strerror(errno);
+		throw SocketException(err.c_str());
+	}
+
+	wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (wakeupFd == -1)
+	{
+		close(epollFd);
+		std::string err = "Could not create reactor wakeup descriptor. Additional"
+				"info: ";
+		err += strerror(errno);
+		throw SocketException(err.c_str());
+	}
+
+	// wakeup descriptor is recognized by the null data pointer
+	epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.ptr = nullptr;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeupFd, &event);
+}
+
+void TcpReactor::start()
+{
+	reactorThread = new Thread(&TcpReactor::runHelper, (void*) this, NULL);
+}
+
+void TcpReactor::addConnection(int socket, in_addr_t senderAddr)
+{
+	int flags = fcntl(socket, F_GETFL, 0);
+	fcntl(socket, F_SETFL, flags | O_NONBLOCK);
+
+	pendingMutex.lock();
+	pendingConnections.emplace_back(socket, senderAddr);
+	pendingMutex.unlock();
+	wakeup();
+}
+
+void TcpReactor::stop()
+{
+	if (reactorThread == nullptr)
+	{
+		return;
+	}
+	stopping = true;
+	wakeup();
+	reactorThread->get();
+	delete reactorThread;
+	reactorThread = nullptr;
+}
+
+void TcpReactor::wakeup()
+{
+	uint64_t one = 1;
+	write(wakeupFd, &one, sizeof one);
+}
+
+void* TcpReactor::runHelper(void* reactor)
+{
+	((TcpReactor*) reactor)->run();
+	return NULL;
+}
+
+void TcpReactor::run()
+{
+	epoll_event events[MAX_EVENTS];
+
+	while(1)
+	{
+		registerPendingConnections();
+
+		// once stopping, only frames which are already started keep the loop alive
+		bool drained = stopping.load() && !hasConnectionsInsideFrame();
+		int ready = epoll_wait(epollFd, events, MAX_EVENTS, drained ? 0 : EPOLL_WAIT_MS);
+
+		for (int i = 0; i < ready; ++i)
+		{
+			Connection* connection = (Connection*) events[i].data.ptr;
+			if (connection == nullptr)
+			{
+				uint64_t counter;
+				read(wakeupFd, &counter, sizeof counter);
+				continue;
+			}
+			handleReadable(connection);
+		}
+
+		checkTimeouts();
+
+		if (drained && ready <= 0)
+		{
+			break;
+		}
+	}
+
+	while (!connections.empty())
+	{
+		closeConnection(connections.begin()->second);
+	}
+}
+
+void TcpReactor::registerPendingConnections()
+{
+	std::vector<std::pair<int, in_addr_t> > accepted;
+	pendingMutex.lock();
+	accepted.swap(pendingConnections);
+	pendingMutex.unlock();
+
+	for (auto &&socketAndAddr : accepted)
+	{
+		Connection* connection = new Connection(socketAndAddr.first, socketAndAddr.second);
+
+		epoll_event event{};
+		event.events = EPOLLIN | EPOLLRDHUP;
+		event.data.ptr = connection;
+		if (epoll_ctl(epollFd, EPOLL_CTL_ADD, connection->socket, &event) == -1)
+		{
+			close(connection->socket);
+			delete connection;
+			continue;
+		}
+		connections[connection->socket] = connection;
+	}
+}
+
+bool TcpReactor::handleReadable(Connection* connection)
+{
+	while(1)
+	{
+		int readLength;
+		if (connection->headerRead < sizeof(P2PMessage))
+		{
+			readLength = recv(connection->socket, (uint8_t*) &connection->header + connection->headerRead,
+					sizeof(P2PMessage) - connection->headerRead, 0);
+		}
+		else if (connection->stream != nullptr)
+		{
+			readLength = recv(connection->socket, connection->buffer,
+					std::min(connection->header.getAdditionalDataSize() - connection->bodyRead,
+							STREAM_CHUNK_SIZE), 0);
+		}
+		else
+		{
+			readLength = recv(connection->socket, connection->buffer + sizeof(P2PMessage) + connection->bodyRead,
+					connection->header.getAdditionalDataSize() - connection->bodyRead, 0);
+		}
+
+		if (readLength == 0)
+		{
+			// peer closed the connection; it is an error only in the middle of the frame
+			if (connection->isInsideFrame())
+			{
+				failConnection(connection);
+			}
+			else
+			{
+				closeConnection(connection);
+			}
+			return false;
+		}
+
+		if (readLength < 0)
+		{
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				return true;
+			}
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			failConnection(connection);
+			return false;
+		}
+
+		connection->lastActivity = Clock::now();
+
+		if (connection->headerRead < sizeof(P2PMessage))
+		{
+			connection->headerRead += readLength;
+			if (!prepareFrameBuffer(connection))
+			{
+				continue;
+			}
+		}
+		else
+		{
+			if (connection->stream != nullptr)
+			{
+				connection->stream->consume(connection->buffer, readLength);
+			}
+			connection->bodyRead += readLength;
+		}
+
+		if (connection->bodyRead == connection->header.getAdditionalDataSize())
+		{
+			deliverFrame(connection);
+		}
+	}
+}
+
+bool TcpReactor::prepareFrameBuffer(Connection* connection)
+{
+	if (connection->headerRead < sizeof(P2PMessage))
+	{
+		return false;
+	}
+
+	if (streamFactory != nullptr)
+	{
+		connection->stream = streamFactory(connection->header, connection->addr);
+	}
+	if (connection->stream != nullptr)
+	{
+		connection->buffer = new uint8_t[std::min(connection->header.getAdditionalDataSize(), STREAM_CHUNK_SIZE)];
+		return true;
+	}
+
+	uint32_t bufSize = sizeof(P2PMessage) + connection->header.getAdditionalDataSize();
+	connection->buffer = new uint8_t[bufSize];
+	memcpy(connection->buffer, &connection->header, sizeof(P2PMessage));
+	return true;
+}
+
+void TcpReactor::deliverFrame(Connection* connection)
+{
+	if (connection->stream != nullptr)
+	{
+		IncomingStream* stream = connection->stream;
+		delete[] connection->buffer;
+		connection->buffer = nullptr;
+		connection->stream = nullptr;
+		connection->headerRead = 0;
+		connection->bodyRead = 0;
+		connection->frameDelivered = true;
+
+		dispatchStreamEnd(executor, stream);
+		return;
+	}
+
+	uint32_t bufSize = sizeof(P2PMessage) + connection->header.getAdditionalDataSize();
+	uint8_t* buf = connection->buffer;
+
+	connection->buffer = nullptr;
+	connection->headerRead = 0;
+	connection->bodyRead = 0;
+	connection->frameDelivered = true;
+
+	SocketOperation op(SocketOperation::Type::TcpReceive,
+			SocketOperation::Status::Success, connection->addr);
+	dispatchFrame(executor, react, buf, bufSize, op);
+}
+
+void TcpReactor::dispatchFrame(ThreadPool* executor, void (*react)(uint8_t*, uint32_t, SocketOperation),
+		uint8_t* buffer, uint32_t size, SocketOperation op)
+{
+	FrameTask* task = new FrameTask(react, buffer, size, op);
+	if (executor == nullptr || !executor->submit(&TcpReactor::reactHelper, (void*) task))
+	{
+		reactHelper(task);
+	}
+}
+
+void* TcpReactor::reactHelper(void* frameTask)
+{
+	FrameTask* task = (FrameTask*) frameTask;
+	task->react(task->buffer, task->size, task->op);
+	delete[] task->buffer;
+	delete task;
+	return NULL;
+}
+
+void TcpReactor::dispatchStreamEnd(ThreadPool* executor, IncomingStream* stream)
+{
+	if (executor == nullptr || !executor->submit(&TcpReactor::finishStreamHelper, (void*) stream))
+	{
+		finishStreamHelper(stream);
+	}
+}
+
+void* TcpReactor::finishStreamHelper(void* incomingStream)
+{
+	IncomingStream* stream = (IncomingStream*) incomingStream;
+	stream->finish(true);
+	delete stream;
+	return NULL;
+}
+
+void TcpReactor::failConnection(Connection* connection)
+{
+	SocketOperation op(SocketOperation::Type::TcpReceive,
+			SocketOperation::Status::ReceiveFailed, connection->addr);
+	closeConnection(connection);
+	errorCallback(op);
+}
+
+void TcpReactor::closeConnection(Connection* connection)
+{
+	epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->socket, NULL);
+	close(connection->socket);
+	connections.erase(connection->socket);
+	if (connection->stream != nullptr)
+	{
+		// connection closed in the middle of the streamed payload
+		connection->stream->finish(false);
+		delete connection->stream;
+	}
+	delete[] connection->buffer;
+	delete connection;
+}
+
+void TcpReactor::checkTimeouts()
+{
+	Clock::time_point now = Clock::now();
+	std::vector<Connection*> failed, idle;
+
+	for (auto &&socketAndConnection : connections)
+	{
+		Connection* connection = socketAndConnection.second;
+		if (connection->isInsideFrame() && now - connection->lastActivity > RECEIVE_TIMEOUT)
+		{
+			failed.push_back(connection);
+		}
+		else if (!connection->isInsideFrame() && now - connection->lastActivity > IDLE_TIMEOUT)
+		{
+			idle.push_back(connection);
+		}
+	}
+
+	for (auto &&connection : failed)
+	{
+		failConnection(connection);
+	}
+	for (auto &&connection : idle)
+	{
+		closeConnection(connection);
+	}
+}
+
+bool TcpReactor::hasConnectionsInsideFrame() const
+{
+	for (auto &&socketAndConnection : connections)
+	{
+		if (socketAndConnection.second->isInsideFrame())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+TcpReactor::~TcpReactor()
+{
+	stop();
+	close(wakeupFd);
+	close(epollFd);
+}
@@ -4,8 +4,11 @@
 
 #include <string.h>
 #include <iostream>
+#include <algorithm>
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
 
 #include <boost/log/core.hpp>
 #include <boost/log/trivial.hpp>
@@ -15,10 +18,26 @@
 #include "P2PMessage.hpp"
 
 TcpServer::TcpServer(void (*reactFunc)(uint8_t* data, uint32_t size, SocketOperation),
-		void (*errorCallbackFunc)(SocketOperation) )
+		void (*errorCallbackFunc)(SocketOperation), Mode serverMode, unsigned reactorThreads,
+		unsigned workerThreads)
+	: Server(workerThreads), activeConnectionThreads(0), pendingSends(0), connectionPool(LISTEN_PORT)
 {
 	react = reactFunc;
 	errorCallback = errorCallbackFunc;
+	streamFactory = nullptr;
+	missingFileCallback = nullptr;
+	mode = serverMode;
+	reactorThreadsNumber = reactorThreads > 0 ? reactorThreads : 1;
+}
+
+void TcpServer::setStreamFactory(StreamFactory factory)
+{
+	streamFactory = factory;
+}
+
+void TcpServer::setMissingFileCallback(MissingFileCallback callback)
+{
+	missingFileCallback = callback;
 }
 
 void TcpServer::startListening()
@@ -51,20 +70,30 @@ void TcpServer::startListening()
 		throw SocketException(err.c_str());
 	}
 
+	if (mode == Mode::EventLoop)
+	{
+		for (unsigned i = 0; i < reactorThreadsNumber; ++i)
+		{
+			reactors.push_back(new TcpReactor(react, errorCallback, &executor, streamFactory));
+			reactors.back()->start();
+		}
+	}
+
+	// connections are queued from now on, so the server is ready once this returns
+	listen(listenSocket, 2500);
+	this->listenSocket = listenSocket;
 	SocketContext* ctx = new SocketContext(this, listenSocket, 0);
 	listenerThread = new Thread(&TcpServer::actualStartListening, (void*) ctx, NULL);
-	usleep(50000);
 }
 
 void* TcpServer::actualStartListening(void* args)
 {
 		TcpServer* serverInstance = (TcpServer*)((SocketContext*)args)->serverInstance;
-		serverInstance->listenSocket = ((SocketContext*)args)->connSocket;
-		listen(serverInstance->listenSocket, 2500);
 		delete (SocketContext*)args;
 
 		sockaddr_in senderAddr;
 		unsigned int senderAddrSize = sizeof senderAddr;
+		unsigned nextReactor = 0;
 
 		while(1)
 		{
@@ -80,10 +109,18 @@ void* TcpServer::actualStartListening(void* args)
                 else continue;
             }
 
+            if (serverInstance->mode == Mode::EventLoop)
+            {
+                // round robin over reactors
+                TcpReactor* reactor = serverInstance->reactors[nextReactor++ % serverInstance->reactors.size()];
+                reactor->addConnection(connSock, senderAddr.sin_addr.s_addr);
+                continue;
+            }
+
             SocketContext* ctx = new SocketContext(serverInstance, connSock, senderAddr.sin_addr.s_addr);
-            if (!serverInstance->addDispatcherThread(&TcpServer::handleConnectionHelper,
-					(void*) ctx, NULL))
+            if (!serverInstance->startConnectionThread(ctx))
             {
+                close(connSock);
                 delete ctx;
                 return NULL;
             }
@@ -96,31 +133,83 @@ void* TcpServer::handleConnectionHelper(void* args)
 	TcpServer* server = (TcpServer*) ctx->serverInstance;
 	server->handleConnection(ctx->connSocket, ctx->connAddr);
 	delete ctx;
-	server->finishThread();
+	server->finishConnectionThread();
 	return NULL;
 }
 
-void TcpServer::handleConnection(int sock, in_addr_t senderAddr)
+bool TcpServer::startConnectionThread(SocketContext* ctx)
 {
-    //++debugThrCount;
-	int readLength;
-	uint8_t* buf;
-	P2PMessage msg;
+	Guard guard(connectionThreadsMutex);
+	if (stop)
+	{
+		return false;
+	}
+	++activeConnectionThreads;
+	Thread(&TcpServer::handleConnectionHelper, (void*) ctx, NULL).detach();
+	return true;
+}
+
+void TcpServer::finishConnectionThread()
+{
+	Guard guard(connectionThreadsMutex);
+	if (--activeConnectionThreads == 0)
+	{
+		connectionThreadsFinished.notifyAll();
+	}
+}
+
+void TcpServer::waitForConnectionThreads()
+{
+	Guard guard(connectionThreadsMutex);
+	while (activeConnectionThreads > 0)
+	{
+		connectionThreadsFinished.wait(connectionThreadsMutex);
+	}
+}
 
+void TcpServer::handleConnection(int sock, in_addr_t senderAddr)
+{
 	struct timeval timeout;
     timeout.tv_sec = 10;
     timeout.tv_usec = 0;
     setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char *)&timeout,
                 sizeof(timeout));
 
-	readLength = recv(sock, (void*)&msg, sizeof(msg), 0);
+    // pooled senders keep the connection open and put next frames back to back
+    bool frameDelivered = false;
+    while (!frameDelivered || waitForNextFrame(sock))
+    {
+        if (!receiveFrame(sock, senderAddr, frameDelivered))
+        {
+            break;
+        }
+        frameDelivered = true;
+    }
+    close(sock);
+}
+
+bool TcpServer::receiveFrame(int sock, in_addr_t senderAddr, bool quietEof)
+{
+	P2PMessage msg;
+	int readLength = recv(sock, (void*)&msg, sizeof(msg), MSG_WAITALL);
+    if (quietEof && readLength == 0)
+    {
+        // connection closed by peer between frames
+        return false;
+    }
     if(checkReceiveIssues(readLength, senderAddr, sizeof(msg)))
     {
-        return;
+        return false;
+    }
+
+    IncomingStream* stream = streamFactory != nullptr ? streamFactory(msg, senderAddr) : nullptr;
+    if (stream != nullptr)
+    {
+        return receiveStream(sock, senderAddr, msg.getAdditionalDataSize(), stream);
     }
 
 	uint32_t bufSize = sizeof(msg) + msg.getAdditionalDataSize();
-	buf = new uint8_t[bufSize];
+	uint8_t* buf = new uint8_t[bufSize];
 	memcpy((void*)buf, &msg, sizeof(msg));
 
 	uint32_t remainingSize = msg.getAdditionalDataSize();
@@ -132,27 +221,66 @@ void TcpServer::handleConnection(int sock, in_addr_t senderAddr)
         if(checkReceiveIssues(readLength, senderAddr))
         {
             delete[] buf;
-            return;
+            return false;
         }
         remainingSize -= readLength;
         streamPointer += readLength;
     }
 
-	SocketOperation op = { SocketOperation::Type::TcpReceive,
-	SocketOperation::Status::Success, senderAddr };
+    // frames of one connection are processed in parallel, like the ones from separate connections
+    SocketOperation op = { SocketOperation::Type::TcpReceive,
+    SocketOperation::Status::Success, senderAddr };
+    TcpReactor::dispatchFrame(&executor, react, buf, bufSize, op);
+    return true;
+}
 
-	close(sock);
-	if (readLength == -1)
-		errorCallback(op);
-	else
-		react(buf, bufSize, op);
+bool TcpServer::receiveStream(int sock, in_addr_t senderAddr, uint32_t size, IncomingStream* stream)
+{
+    // only one chunk of the payload is kept in memory
+    std::vector<uint8_t> chunk(std::min(size, STREAM_CHUNK_SIZE));
+
+    while (size > 0)
+    {
+        int readLength = recv(sock, chunk.data(), std::min(size, STREAM_CHUNK_SIZE), 0);
+        if (checkReceiveIssues(readLength, senderAddr))
+        {
+            stream->finish(false);
+            delete stream;
+            return false;
+        }
+        stream->consume(chunk.data(), readLength);
+        size -= readLength;
+    }
+
+    TcpReactor::dispatchStreamEnd(&executor, stream);
+    return true;
+}
+
+bool TcpServer::waitForNextFrame(int sock)
+{
+    pollfd pollSocket;
+    pollSocket.fd = sock;
+    pollSocket.events = POLLIN;
 
-	delete[] buf;
+    for (int waited = 0; waited < IDLE_CONNECTION_TIMEOUT_MS; waited += STOP_CHECK_INTERVAL_MS)
+    {
+        int ready = poll(&pollSocket, 1, STOP_CHECK_INTERVAL_MS);
+        if (ready != 0)
+        {
+            // data, EOF or error - receiving the frame sorts it out
+            return ready > 0;
+        }
+        if (stop.load())
+        {
+            return false;
+        }
+    }
+    return false;
 }
 
 bool TcpServer::checkReceiveIssues(int readLength, in_addr_t sender, int expectedSize)
 {
-    if ( (readLength <= 0 || errno == EAGAIN || errno == EWOULDBLOCK)
+    if ( readLength <= 0
         || (expectedSize != -1 && expectedSize != readLength) )
     {
         SocketOperation op(SocketOperation::Type::TcpReceive,
@@ -167,16 +295,21 @@ bool TcpServer::checkReceiveIssues(int readLength, in_addr_t sender, int expecte
 
 void TcpServer::sendData(uint8_t* data, size_t n, in_addr_t toWhom)
 {
-    uint8_t* copiedData = new uint8_t[n];
-    memcpy(copiedData, data, n);
-	SendArgs* args = new SendArgs(copiedData, n, toWhom);
+	sendMessage(MessageBuilder::fromBytes(data, n), toWhom);
+}
+
+void TcpServer::sendMessage(MessageBuilder&& message, in_addr_t toWhom)
+{
+	SendArgs* args = new SendArgs(std::move(message), toWhom);
 	ActualSendDataContext* ctx = new ActualSendDataContext(this, args);
+	pendingSendsMutex.lock();
+	++pendingSends;
+	pendingSendsMutex.unlock();
 	if(!addDispatcherThread(actualSendDataHelper, (void*)ctx, NULL))
     {
-        delete[] copiedData;
+        finishPendingSend();
         delete args;
         delete ctx;
-        return;
     }
 }
 
@@ -185,59 +318,124 @@ void* TcpServer::actualSendDataHelper(void* args)
 	ActualSendDataContext* ctx =(ActualSendDataContext*)args;
 	SendArgs* s = ctx->args;
 	TcpServer* server = (TcpServer*) ctx->serverInstance;
-	server->actualSendData(s->data, s->size, s->toWhom);
-	delete[] ctx->args->data;
+	if (s->message.getAttachedFile().empty())
+	{
+		server->actualSendData(s->message, s->toWhom);
+	}
+	else
+	{
+		server->actualSendFile(s->message, s->toWhom);
+	}
 	delete ctx->args;
 	delete ctx;
-	server->finishThread();
+	server->finishPendingSend();
 	return NULL;
 }
 
-void TcpServer::actualSendData(uint8_t* data, uint32_t size, in_addr_t toWhom)
+void TcpServer::finishPendingSend()
+{
+	Guard guard(pendingSendsMutex);
+	if (--pendingSends == 0)
+	{
+		pendingSendsFinished.notifyAll();
+	}
+}
+
+void TcpServer::waitForPendingSends()
+{
+	Guard guard(pendingSendsMutex);
+	while (pendingSends > 0)
+	{
+		pendingSendsFinished.wait(pendingSendsMutex);
+	}
+}
+
+void TcpServer::actualSendData(MessageBuilder &message, in_addr_t toWhom)
 {
-    Mutex debugMutex;
-	sockaddr_in sendAddr;
-	sendAddr.sin_family = AF_INET;
-	sendAddr.sin_port = htons(LISTEN_PORT);
-	sendAddr.sin_addr.s_addr = toWhom;
+	std::vector<iovec> segments = message.getSegments();
 
-	int sendSocket = socket(AF_INET, SOCK_STREAM, 0);
+	// only complete frames can share a pooled connection, anything else
+	// would break the framing of messages sent after it
+	SocketOperation::Status status = message.isCompleteFrame()
+			? connectionPool.send(segments.data(), segments.size(), toWhom)
+			: connectionPool.sendOnce(segments.data(), segments.size(), toWhom);
 
-	if (sendSocket == -1)
+	if (status != SocketOperation::Status::Success)
 	{
-		SocketOperation op(SocketOperation::Type::TcpSend,
-				SocketOperation::Status::CantOpenSocket, toWhom);
+		SocketOperation op(SocketOperation::Type::TcpSend, status, toWhom);
 		errorCallback(op);
+	}
+}
+
+void TcpServer::actualSendFile(MessageBuilder &message, in_addr_t toWhom)
+{
+	const std::string &filename = message.getAttachedFile();
+	int fileFd = open(filename.c_str(), O_RDONLY);
+	struct stat fileStat;
+	if (fileFd == -1 || fstat(fileFd, &fileStat) == -1)
+	{
+		BOOST_LOG_TRIVIAL(error) << "Could not send file " << filename << ": " << strerror(errno);
+		if (fileFd != -1)
+		{
+			close(fileFd);
+		}
+		if (missingFileCallback != nullptr)
+		{
+			missingFileCallback(message.getMessageType(), filename, toWhom);
+		}
 		return;
 	}
 
-	struct timeval timeout;
-    timeout.tv_sec = 5;
-    timeout.tv_usec = 0;
+	// requested range is clipped to the current size of the file
+	uint64_t fileSize = fileStat.st_size;
+	uint64_t offset = std::min<uint64_t>(message.getAttachedFileOffset(), fileSize);
+	uint64_t length = fileSize - offset;
+	if (message.getAttachedFileLength() != 0)
+	{
+		length = std::min<uint64_t>(length, message.getAttachedFileLength());
+	}
 
-    setsockopt(sendSocket, SOL_SOCKET, SO_SNDTIMEO, (char *)&timeout,
-                sizeof(timeout));
+	message.addAttachedFileSize(length);
+	std::vector<iovec> segments = message.getSegments();
+	SocketOperation::Status status = connectionPool.sendFile(segments.data(), segments.size(), fileFd, offset,
+			length, toWhom);
+	close(fileFd);
 
-	int status = connect(sendSocket, (sockaddr*) &sendAddr, sizeof(sendAddr));
-	if (status == -1)
+	if (status != SocketOperation::Status::Success)
 	{
-		close(sendSocket);
-		SocketOperation op(SocketOperation::Type::TcpSend,
-						SocketOperation::Status::CantConnect, toWhom);
+		SocketOperation op(SocketOperation::Type::TcpSend, status, toWhom);
 		errorCallback(op);
-		return;
 	}
+}
 
-	if(send(sendSocket, data, size, 0) != size)
-    {
-        SocketOperation op(SocketOperation::Type::TcpSend,
-						SocketOperation::Status::SendFailed, toWhom);
-        errorCallback(op);
-    }
-	close(sendSocket);
-	return;
+void TcpServer::stopListening()
+{
+	// messages already queued for sending may be addressed to this node
+	waitForPendingSends();
+	stopListener();
+
+	// listener is joined, so no more connections are accepted;
+	// connections pass their last frames to the executor before it is drained
+	waitForConnectionThreads();
+	for (auto &&reactor : reactors)
+	{
+		reactor->stop();
+	}
+	stopExecutor();
+	connectionPool.closeAll();
 }
 
 TcpServer::~TcpServer()
 {
+	stopListener();
+	waitForConnectionThreads();
+	for (auto &&reactor : reactors)
+	{
+		reactor->stop();
+	}
+	stopExecutor();
+	for (auto &&reactor : reactors)
+	{
+		delete reactor;
+	}
 }
@@ -13,6 +13,10 @@ void * Thread::get() {
     return rv == NULL ? NULL : *rv;
 }
 
+void Thread::detach() {
+    pthread_detach(thread_id);
+}
+
 void Thread::exit() {
     pthread_exit(NULL);
 }
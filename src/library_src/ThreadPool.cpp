@@ -0,0 +1,112 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(unsigned workersNumber, size_t capacity)
+	: queueCapacity(capacity > 0 ? capacity : 1), stopping(false)
+{
+	if (workersNumber == 0)
+	{
+		workersNumber = 1;
+	}
+	for (unsigned i = 0; i < workersNumber; ++i)
+	{
+		workers.push_back(new Thread(&ThreadPool::workerLoop, (void*) this, NULL));
+	}
+}
+
+bool ThreadPool::submit(void* function(void*), void* arg)
+{
+	bool fromWorker = isWorkerThread();
+
+	queueMutex.lock();
+	while (tasks.size() >= queueCapacity && (!stopping || fromWorker))
+	{
+		if (fromWorker)
+		{
+			queueMutex.unlock();
+			function(arg);
+			return true;
+		}
+		spaceAvailable.wait(queueMutex);
+	}
+
+	// running tasks may still queue their continuations while the pool is drained
+	if (stopping && !fromWorker)
+	{
+		queueMutex.unlock();
+		return false;
+	}
+
+	tasks.emplace_back(function, arg);
+	queueMutex.unlock();
+	taskAvailable.notifyOne();
+	return true;
+}
+
+void* ThreadPool::workerLoop(void* arg)
+{
+	ThreadPool* pool = (ThreadPool*) arg;
+
+	while(1)
+	{
+		pool->queueMutex.lock();
+		while (pool->tasks.empty() && !pool->stopping)
+		{
+			pool->taskAvailable.wait(pool->queueMutex);
+		}
+
+		// queue is drained before workers quit
+		if (pool->tasks.empty())
+		{
+			pool->queueMutex.unlock();
+			return NULL;
+		}
+
+		Task task = pool->tasks.front();
+		pool->tasks.pop_front();
+		pool->queueMutex.unlock();
+		pool->spaceAvailable.notifyOne();
+
+		task.function(task.arg);
+	}
+}
+
+bool ThreadPool::isWorkerThread()
+{
+	for (auto &&worker : workers)
+	{
+		if (worker->isCurrentThread())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::shutdown()
+{
+	queueMutex.lock();
+	if (stopping)
+	{
+		queueMutex.unlock();
+		return;
+	}
+	stopping = true;
+	queueMutex.unlock();
+	taskAvailable.notifyAll();
+	spaceAvailable.notifyAll();
+
+	// worker threads are kept until destruction, because isWorkerThread() reads them without the lock
+	for (auto &&worker : workers)
+	{
+		worker->get();
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	shutdown();
+	for (auto &&worker : workers)
+	{
+		delete worker;
+	}
+}
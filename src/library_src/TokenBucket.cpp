@@ -0,0 +1,20 @@
+#include <algorithm>
+#include "TokenBucket.hpp"
+
+TokenBucket::TokenBucket(uint64_t bytesPerSecond, uint64_t burstBytes)
+        : rate(bytesPerSecond > 0 ? bytesPerSecond : 1), burst(burstBytes), tokens(burstBytes),
+          refilled(Clock::now()) {
+}
+
+TokenBucket::Clock::duration TokenBucket::take(uint64_t bytes, Clock::time_point now) {
+    if (now > refilled) {
+        std::chrono::duration<double> elapsed = now - refilled;
+        tokens = std::min(burst, tokens + elapsed.count() * rate);
+        refilled = now;
+    }
+    tokens -= bytes;
+    if (tokens >= 0) {
+        return Clock::duration::zero();
+    }
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(-tokens / rate));
+}
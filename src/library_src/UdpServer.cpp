@@ -7,9 +7,9 @@
 
 #include "SocketExceptions.hpp"
 
-#define BUF_SIZE 1024
-
-UdpServer::UdpServer(void (*receiveBroadcastCallback)(uint8_t*, uint32_t, SocketOperation op))
+UdpServer::UdpServer(void (*receiveBroadcastCallback)(uint8_t*, uint32_t, SocketOperation op),
+		unsigned workerThreads)
+	: Server(workerThreads)
 {
 	broadcastAddr.sin_family = AF_INET;
 	broadcastAddr.sin_port = htons(PORT);
@@ -18,6 +18,20 @@ UdpServer::UdpServer(void (*receiveBroadcastCallback)(uint8_t*, uint32_t, Socket
 }
 
 void UdpServer::broadcast(uint8_t* bytes, uint32_t size)
+{
+	iovec segment;
+	segment.iov_base = bytes;
+	segment.iov_len = size;
+	broadcastSegments(&segment, 1);
+}
+
+void UdpServer::broadcast(const MessageBuilder& message)
+{
+	std::vector<iovec> segments = message.getSegments();
+	broadcastSegments(segments.data(), segments.size());
+}
+
+void UdpServer::broadcastSegments(const iovec* segments, int segmentsCount)
 {
 	int mySocket = socket(AF_INET, SOCK_DGRAM, 0);
 
@@ -39,8 +53,12 @@ void UdpServer::broadcast(uint8_t* bytes, uint32_t size)
 	}
 	else
 	{
-		sendto(mySocket, bytes, size, 0,
-							(struct sockaddr *)&broadcastAddr, sizeof broadcastAddr);
+		msghdr datagram{};
+		datagram.msg_name = &broadcastAddr;
+		datagram.msg_namelen = sizeof broadcastAddr;
+		datagram.msg_iov = (iovec*) segments;
+		datagram.msg_iovlen = segmentsCount;
+		sendmsg(mySocket, &datagram, 0);
 		close(mySocket);
 	}
 }
@@ -65,8 +83,8 @@ void UdpServer::startListening()
 
 	SocketContext* ctx = new SocketContext((Server*)this, listenSocket, 0);
 
+	// socket is bound, so datagrams wait for the listener in its buffer
 	listenerThread = new Thread(&UdpServer::actualStartListening, (void*)ctx, NULL);
-	usleep(50000);
 }
 
 void* UdpServer::actualStartListening(void* ctx)
@@ -81,9 +99,9 @@ void* UdpServer::actualStartListening(void* ctx)
 
 	while(1)
 	{
-		buf = new uint8_t[BUF_SIZE];
+		buf = new uint8_t[MAX_DATAGRAM_SIZE];
 		sockaddr_in sender;
-        rcvlen = recvfrom(mySocket, buf, BUF_SIZE, 0, (sockaddr*)&sender, &slen);
+        rcvlen = recvfrom(mySocket, buf, MAX_DATAGRAM_SIZE, 0, (sockaddr*)&sender, &slen);
         if (rcvlen == 0)
         {
             if (server->stop.load())
@@ -96,6 +114,7 @@ void* UdpServer::actualStartListening(void* ctx)
 
         if (sender.sin_addr.s_addr == Server::getLocalhostIp() && server->isSelfBroadcastDisable)
         {
+            delete[] buf;
             continue;
         }
 
@@ -119,7 +138,6 @@ void* UdpServer::handleBroadcastReceive(void* handleArgs)
 	server->react(args->data, args->dataSize, op);
 	delete[] args->data;
 	delete args;
-	server->finishThread();
 	return NULL;
 }
 
@@ -130,6 +148,8 @@ void UdpServer::enableSelfBroadcasts()
 
 UdpServer::~UdpServer()
 {
+	stopListener();
+	stopExecutor();
 }
 
 void UdpServer::disableSelfBroadcasts() {
@@ -31,7 +31,22 @@ int UserInterface::checkInput(const std::string &inputString) {
             return 2;
         }
 
-        p2p::startSession();
+        // all the nodes of the network have to use the same placement
+        PlacementMode placementMode = PlacementMode::LEAST_LOADED;
+        uint32_t placementWeight = 1;
+        if (tokens.size() > 1 && tokens[1] == "rendezvous") {
+            placementMode = PlacementMode::RENDEZVOUS;
+            if (tokens.size() > 2) {
+                try {
+                    placementWeight = (uint32_t) std::stoul(tokens[2]);
+                } catch (std::logic_error &e) {
+                    std::cout << "Invalid weight" << std::endl;
+                    return 2;
+                }
+            }
+        }
+
+        p2p::startSession(placementMode, placementWeight);
         isConnected = true;
         return 1;
     }
@@ -177,7 +192,7 @@ void UserInterface::help() {
     int i = 0;
     std::cout << std::endl;
     std::cout << "Available commands:" << std::endl;
-    std::cout << ++i << ". " << "connect" << std::endl;
+    std::cout << ++i << ". " << "connect [rendezvous [weight]]" << std::endl;
     std::cout << ++i << ". " << "disconnect" << std::endl;
     std::cout << ++i << ". " << "upload <filenames>" << std::endl;
     std::cout << ++i << ". " << "delete <filenames>" << std::endl;
@@ -0,0 +1,39 @@
+#ifndef TIN_P2P_TESTFACTORIES_HPP
+#define TIN_P2P_TESTFACTORIES_HPP
+
+#include <cstdio>
+#include <string>
+#include <netinet/in.h>
+#include "FileDescriptor.hpp"
+#include "Md5hash.hpp"
+
+/// Values shared by the tests: digests of numbered files and valid descriptors.
+namespace testFactories {
+    // different for every number, spread over the whole digest; the seed gives another set, e.g. per node
+    inline Md5Hash makeHash(unsigned i, unsigned seed = 0) {
+        char hex[33];
+        snprintf(hex, sizeof hex, "%08x%08x%08x%08x", i * 2654435761u + seed, i * 40503u, i, i * 7919u);
+        return Md5Hash(hex);
+    }
+
+    inline FileDescriptor makeDescriptor(const std::string &name, const Md5Hash &hash, in_addr_t holder = 1,
+                                         uint32_t size = 100) {
+        FileDescriptor descriptor(name, hash, size);
+        descriptor.setHolderIp(holder);
+        descriptor.makeValid();
+        return descriptor;
+    }
+
+    inline FileDescriptor makeDescriptor(const std::string &name, const std::string &hash, in_addr_t holder = 1,
+                                         uint32_t size = 100) {
+        return makeDescriptor(name, Md5Hash(hash), holder, size);
+    }
+
+    // "file<i>" with the digest makeHash(i)
+    inline FileDescriptor makeDescriptor(unsigned i, in_addr_t holder = 1, uint32_t size = 100) {
+        return makeDescriptor("file" + std::to_string(i), makeHash(i), holder, size);
+    }
+}
+
+
+#endif //TIN_P2P_TESTFACTORIES_HPP
@@ -0,0 +1,124 @@
+#define BOOST_TEST_NO_LIB
+#include <boost/test/unit_test.hpp>
+
+#include "DescriptorCodec.hpp"
+#include <arpa/inet.h>
+#include <vector>
+#include <string>
+
+namespace {
+	const std::string HASH = "00112233445566778899aabbccddeeff";
+
+	// record of "example.txt", 300 bytes, uploaded at 1000, owned by 10.0.0.1, held by 10.0.0.2
+	std::vector<uint8_t> exampleRecord() {
+		std::vector<uint8_t> body = {DescriptorCodec::VERSION};
+		for (int i = 0; i < 16; ++i) {
+			body.push_back(0x11 * i);
+		}
+		body.push_back(1);                          // valid
+		body.push_back(0xac); body.push_back(0x02); // 300
+		body.push_back(0xd0); body.push_back(0x0f); // zigzag(1000)
+		body.push_back(10); body.push_back(0); body.push_back(0); body.push_back(1);
+		body.push_back(10); body.push_back(0); body.push_back(0); body.push_back(2);
+		std::string name = "example.txt";
+		body.push_back(name.size());
+		body.insert(body.end(), name.begin(), name.end());
+
+		std::vector<uint8_t> record = {(uint8_t) body.size()};
+		record.insert(record.end(), body.begin(), body.end());
+		return record;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(DescriptorCodecTests);
+
+BOOST_AUTO_TEST_CASE(decodesAllFields)
+{
+	auto record = exampleRecord();
+	FileDescriptor descriptor;
+	BOOST_TEST(DescriptorCodec::decode(record.data(), record.size(), descriptor) == record.size());
+
+	BOOST_TEST(descriptor.getName() == "example.txt");
+	BOOST_TEST(descriptor.getMd5().getHash() == HASH);
+	BOOST_TEST(descriptor.getSize() == 300u);
+	BOOST_TEST(descriptor.getUploadTime() == 1000);
+	BOOST_TEST(descriptor.getOwnerIp() == inet_addr("10.0.0.1"));
+	BOOST_TEST(descriptor.getHolderIp() == inet_addr("10.0.0.2"));
+	BOOST_TEST(descriptor.isValid());
+}
+
+BOOST_AUTO_TEST_CASE(encodingRoundTrip)
+{
+	auto record = exampleRecord();
+	FileDescriptor descriptor;
+	DescriptorCodec::decode(record.data(), record.size(), descriptor);
+	descriptor.makeUnvalid();
+	descriptor.setUploadTime(-5);
+
+	auto encoded = DescriptorCodec::encode(descriptor);
+	BOOST_TEST(encoded.size() < sizeof(FileDescriptor) / 4);
+
+	FileDescriptor decoded;
+	BOOST_TEST(DescriptorCodec::decode(encoded.data(), encoded.size(), decoded) == encoded.size());
+	BOOST_TEST(decoded.getName() == descriptor.getName());
+	BOOST_TEST(decoded.getMd5().getHash() == HASH);
+	BOOST_TEST(decoded.getUploadTime() == -5);
+	BOOST_TEST(!decoded.isValid());
+	BOOST_TEST((DescriptorCodec::encode(decoded) == encoded));
+}
+
+BOOST_AUTO_TEST_CASE(incompleteRecordIsRejected)
+{
+	auto record = exampleRecord();
+	FileDescriptor descriptor;
+	for (size_t size = 0; size < record.size(); ++size) {
+		BOOST_TEST(DescriptorCodec::decode(record.data(), size, descriptor) == 0u);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(sizeAboveLimitIsRejected)
+{
+	auto record = exampleRecord();
+	// size 300 (2 bytes) replaced by 2^32 (5 bytes), which does not fit the descriptor
+	const size_t sizeOffset = 1 + 1 + 16 + 1;
+	std::vector<uint8_t> tooBig = {0x80, 0x80, 0x80, 0x80, 0x10};
+	record.erase(record.begin() + sizeOffset, record.begin() + sizeOffset + 2);
+	record.insert(record.begin() + sizeOffset, tooBig.begin(), tooBig.end());
+	record[0] += tooBig.size() - 2;
+
+	FileDescriptor descriptor;
+	BOOST_TEST(DescriptorCodec::decode(record.data(), record.size(), descriptor) == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(unknownTrailingFieldsAreSkipped)
+{
+	auto record = exampleRecord();
+	// newer version appends a field to the record
+	record.push_back(0x42);
+	record.push_back(0x43);
+	record[0] += 2;
+	record[1] = DescriptorCodec::VERSION + 1;
+
+	FileDescriptor descriptor;
+	BOOST_TEST(DescriptorCodec::decode(record.data(), record.size(), descriptor) == record.size());
+	BOOST_TEST(descriptor.getName() == "example.txt");
+}
+
+BOOST_AUTO_TEST_CASE(listIsSplitIntoRecords)
+{
+	auto record = exampleRecord();
+	std::vector<uint8_t> list;
+	for (int i = 0; i < 3; ++i) {
+		list.insert(list.end(), record.begin(), record.end());
+	}
+
+	std::vector<FileDescriptor> descriptors;
+	BOOST_TEST(DescriptorCodec::decode(list.data(), list.size(), descriptors));
+	BOOST_TEST(descriptors.size() == 3u);
+
+	descriptors.clear();
+	BOOST_TEST(!DescriptorCodec::decode(list.data(), list.size() - 1, descriptors));
+	BOOST_TEST(descriptors.size() == 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
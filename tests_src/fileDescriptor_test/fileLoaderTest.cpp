@@ -1,5 +1,7 @@
 #include <boost/test/unit_test.hpp>
+#include <unistd.h>
 #include <FileLoader.hpp>
+#include <FileStorer.hpp>
 
 
 BOOST_AUTO_TEST_SUITE(fileLoader);
@@ -9,7 +11,50 @@ BOOST_AUTO_TEST_CASE(simpleLoad)
     const std::string name = "../tests_src/protocol_test/example.txt";
     const std::string content = "md5 test\n";
     FileLoader loader(name);
-    BOOST_TEST(content == std::string((char*)loader.getContent().data()));
+    auto loaded = loader.getContent();
+    BOOST_TEST(content == std::string(loaded.begin(), loaded.end()));
+}
+
+BOOST_AUTO_TEST_CASE(binaryContentIsExact)
+{
+    const std::string name = "fileLoaderTest.bin";
+    std::vector<uint8_t> content(3 * 1000 + 7);
+    for (size_t i = 0; i < content.size(); ++i) {
+        content[i] = (uint8_t) (i % 3 == 0 ? 0 : i);
+    }
+    BOOST_REQUIRE(FileStorer(name).storeFile(content));
+
+    FileLoader loader(name);
+    BOOST_TEST((loader.getContent() == content));
+
+    auto view = loader.map();
+    BOOST_TEST((std::vector<uint8_t>(view.data(), view.data() + view.size()) == content));
+
+    std::vector<uint8_t> chunked;
+    size_t chunks = 0;
+    BOOST_TEST(loader.readChunks([&chunked, &chunks](const uint8_t *data, size_t size) {
+        chunked.insert(chunked.end(), data, data + size);
+        ++chunks;
+        return true;
+    }, 1000));
+    BOOST_TEST((chunked == content));
+    BOOST_TEST(chunks == 4u);
+    unlink(name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(emptyFileIsMapped)
+{
+    const std::string name = "fileLoaderTest.bin";
+    BOOST_REQUIRE(FileStorer(name).storeFile(std::vector<uint8_t>()));
+    BOOST_TEST(FileLoader(name).map().size() == 0u);
+    BOOST_TEST(FileLoader(name).getContent().empty());
+    unlink(name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(missingFileThrows)
+{
+    BOOST_CHECK_THROW(FileLoader("/x").getContent(), std::runtime_error);
+    BOOST_CHECK_THROW(FileLoader("/x").map(), std::runtime_error);
 }
 
 BOOST_AUTO_TEST_SUITE_END();
\ No newline at end of file
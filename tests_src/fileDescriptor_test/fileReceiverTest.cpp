@@ -0,0 +1,116 @@
+#include <boost/test/unit_test.hpp>
+#include <unistd.h>
+#include <FileReceiver.hpp>
+#include <FileLoader.hpp>
+
+namespace {
+    const std::string CONTENT = "md5 test\n";
+    const std::string HASH = "90ebef7754cd9e4441622f39f10c63d3";
+
+    struct Completed {
+        int calls = 0;
+        bool stored = false;
+    };
+
+    FileReceiver::Completion recordInto(Completed &completed) {
+        return [&completed](FileDescriptor &, bool stored, in_addr_t) {
+            ++completed.calls;
+            completed.stored = stored;
+        };
+    }
+
+    std::vector<uint8_t> uploadMessage() {
+        std::vector<uint8_t> message = DescriptorCodec::encode(FileDescriptor("received.txt", Md5Hash(HASH),
+                                                                             CONTENT.size()));
+        message.insert(message.end(), CONTENT.begin(), CONTENT.end());
+        return message;
+    }
+
+    // FILE_TRANSFER: descriptor, offset and length of the range, the range
+    std::vector<uint8_t> transferMessage(uint64_t offset, uint64_t length) {
+        std::vector<uint8_t> message = DescriptorCodec::encode(FileDescriptor("received.txt", Md5Hash(HASH),
+                                                                             CONTENT.size()));
+        message.insert(message.end(), (const uint8_t *) &offset, (const uint8_t *) &offset + sizeof offset);
+        message.insert(message.end(), (const uint8_t *) &length, (const uint8_t *) &length + sizeof length);
+        message.insert(message.end(), CONTENT.begin() + offset,
+                       length == 0 ? CONTENT.end() : CONTENT.begin() + offset + length);
+        return message;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(fileReceiver);
+
+BOOST_AUTO_TEST_CASE(wholeUploadIsStored)
+{
+    Completed completed;
+    std::vector<uint8_t> message = uploadMessage();
+    FileReceiver receiver(MessageType::UPLOAD_FILE, 1, recordInto(completed));
+    receiver.consume(message.data(), message.size());
+    receiver.finish(true);
+
+    BOOST_TEST(completed.calls == 1);
+    BOOST_TEST(completed.stored);
+    BOOST_TEST(access(HASH.c_str(), F_OK) == 0);
+    unlink(HASH.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(brokenUploadIsReportedNotStored)
+{
+    Completed completed;
+    std::vector<uint8_t> message = uploadMessage();
+    FileReceiver receiver(MessageType::UPLOAD_FILE, 1, recordInto(completed));
+    receiver.consume(message.data(), message.size() - 3);
+    receiver.finish(false);
+
+    BOOST_TEST(completed.calls == 1);
+    BOOST_TEST(!completed.stored);
+    BOOST_TEST(access(HASH.c_str(), F_OK) == -1);
+}
+
+BOOST_AUTO_TEST_CASE(partialReadOfWholeRangeIsStored)
+{
+    Completed completed;
+    std::vector<uint8_t> message = transferMessage(2, 4);
+    std::string rangeName = FileReceiver::getRangeFileName("received.txt", 2, 4);
+    BOOST_TEST(rangeName == "received.txt.2-6");
+    FileReceiver receiver(MessageType::FILE_TRANSFER, 1, recordInto(completed));
+    receiver.consume(message.data(), message.size());
+    receiver.finish(true);
+
+    BOOST_TEST(completed.calls == 1);
+    BOOST_TEST(completed.stored);
+    auto content = FileLoader(rangeName).getContent();
+    BOOST_TEST(std::string(content.begin(), content.end()) == CONTENT.substr(2, 4));
+    unlink(rangeName.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(shortPartialReadIsNotStored)
+{
+    Completed completed;
+    std::vector<uint8_t> message = transferMessage(2, 4);
+    std::string rangeName = FileReceiver::getRangeFileName("received.txt", 2, 4);
+    FileReceiver receiver(MessageType::FILE_TRANSFER, 1, recordInto(completed));
+    receiver.consume(message.data(), message.size() - 1);
+    receiver.finish(true);
+
+    BOOST_TEST(completed.calls == 1);
+    BOOST_TEST(!completed.stored);
+    BOOST_TEST(access(rangeName.c_str(), F_OK) == -1);
+}
+
+BOOST_AUTO_TEST_CASE(wholeFileTransferIsVerified)
+{
+    Completed completed;
+    std::vector<uint8_t> message = transferMessage(0, 0);
+    FileReceiver receiver(MessageType::FILE_TRANSFER, 1, recordInto(completed));
+    receiver.consume(message.data(), message.size());
+    receiver.finish(true);
+
+    BOOST_TEST(completed.calls == 1);
+    BOOST_TEST(completed.stored);
+    auto content = FileLoader("received.txt").getContent();
+    BOOST_TEST(std::string(content.begin(), content.end()) == CONTENT);
+    unlink("received.txt");
+}
+
+BOOST_AUTO_TEST_SUITE_END();
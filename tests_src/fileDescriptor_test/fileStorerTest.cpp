@@ -0,0 +1,76 @@
+#include <boost/test/unit_test.hpp>
+#include <unistd.h>
+#include <FileStorer.hpp>
+#include <FileLoader.hpp>
+
+
+BOOST_AUTO_TEST_SUITE(fileStorer);
+
+BOOST_AUTO_TEST_CASE(streamedFileAppearsAfterCommit)
+{
+    const std::string name = "fileStorerTest.txt";
+    const std::string content = "md5 test\n";
+    unlink(name.c_str());
+
+    FileStorer storer(name);
+    BOOST_REQUIRE(storer.beginStream());
+    BOOST_TEST(storer.append((const uint8_t*) content.data(), 4));
+    BOOST_TEST(storer.append((const uint8_t*) content.data() + 4, content.size() - 4));
+    BOOST_TEST(access(name.c_str(), F_OK) == -1);
+
+    BOOST_TEST(storer.getStreamHash().getHash() == "90ebef7754cd9e4441622f39f10c63d3");
+    BOOST_TEST(storer.commit());
+    FileLoader loader(name);
+    auto loaded = loader.getContent();
+    BOOST_TEST(content == std::string(loaded.begin(), loaded.end()));
+    unlink(name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(abortedStreamLeavesNothing)
+{
+    const std::string name = "fileStorerTest.txt";
+    unlink(name.c_str());
+    std::string tempName;
+    {
+        FileStorer storer(name);
+        BOOST_REQUIRE(storer.beginStream());
+        tempName = storer.getStreamFilename();
+        BOOST_TEST(storer.append((const uint8_t*) "abc", 3));
+        BOOST_TEST(access(tempName.c_str(), F_OK) == 0);
+    }
+    BOOST_TEST(access(tempName.c_str(), F_OK) == -1);
+    BOOST_TEST(access(name.c_str(), F_OK) == -1);
+}
+
+BOOST_AUTO_TEST_CASE(suspendedStreamIsResumed)
+{
+    const std::string name = "fileStorerTest.txt";
+    const std::string content = "md5 test\n";
+    unlink(name.c_str());
+    {
+        FileStorer storer(name);
+        unlink(storer.getPartialFilename().c_str());
+        BOOST_REQUIRE(storer.resumeStream(0));
+        // last byte written before the transfer broke is sent again
+        BOOST_TEST(storer.append((const uint8_t*) content.data(), 5));
+        storer.suspend();
+        BOOST_TEST(storer.getPartialSize() == 5u);
+    }
+
+    FileStorer storer(name);
+    BOOST_TEST(storer.getPartialSize() == 5u);
+    BOOST_TEST(!storer.resumeStream(6));
+    BOOST_REQUIRE(storer.resumeStream(4));
+    BOOST_TEST(storer.append((const uint8_t*) content.data() + 4, content.size() - 4));
+    // digest covers the content kept from the suspended stream
+    BOOST_TEST(storer.getStreamHash().getHash() == "90ebef7754cd9e4441622f39f10c63d3");
+    BOOST_TEST(storer.commit());
+
+    FileLoader loader(name);
+    auto loaded = loader.getContent();
+    BOOST_TEST(content == std::string(loaded.begin(), loaded.end()));
+    BOOST_TEST(storer.getPartialSize() == 0u);
+    unlink(name.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END();
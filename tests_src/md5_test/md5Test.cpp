@@ -2,6 +2,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include "Md5sum.hpp"
+#include <unordered_set>
 
 BOOST_AUTO_TEST_SUITE(Md5Test);
 
@@ -11,7 +12,7 @@ BOOST_AUTO_TEST_CASE(checkExampleFileMD5HashValidity)
 {
     Md5sum md5File(EXAMPLE_FILE);
 
-	std::string content = "md5 test";
+	std::string content = "md5 test\n";
 	std::istringstream stream(content);
 	const std::string EXAMPLE_FILE_MD5 = "90ebef7754cd9e4441622f39f10c63d3";
 	Md5sum md5(stream);
@@ -19,6 +20,57 @@ BOOST_AUTO_TEST_CASE(checkExampleFileMD5HashValidity)
     BOOST_CHECK_EQUAL(md5.getMd5Hash().getHash(), EXAMPLE_FILE_MD5);
 }
 
+BOOST_AUTO_TEST_CASE(checkReferenceDigests)
+{
+	BOOST_CHECK_EQUAL(Md5sum().finish().getHash(), "d41d8cd98f00b204e9800998ecf8427e");
+
+	std::string content = "The quick brown fox jumps over the lazy dog";
+	std::istringstream stream(content);
+	BOOST_CHECK_EQUAL(Md5sum(stream).getMd5Hash().getHash(), "9e107d9d372bb6826bd81d3542a419d6");
+}
+
+BOOST_AUTO_TEST_CASE(checkIncrementalUpdates)
+{
+	std::string content(1000, '\0');
+	for (size_t i = 0; i < content.size(); ++i) {
+		content[i] = (char) (i * 7);
+	}
+	std::istringstream stream(content);
+	Md5Hash whole = Md5sum(stream).getMd5Hash();
+
+	// parts not aligned to the blocks
+	Md5sum md5;
+	for (size_t position = 0, part = 1; position < content.size(); position += part, part += 13) {
+		md5.update(content.data() + position, std::min(part, content.size() - position));
+	}
+	BOOST_CHECK_EQUAL(md5.finish().getHash(), whole.getHash());
+}
+
+BOOST_AUTO_TEST_CASE(checkUpdateAfterFinishThrows)
+{
+	Md5sum md5;
+	md5.update("md5", 3);
+	Md5Hash hash = md5.finish();
+	BOOST_CHECK_THROW(md5.update("test", 4), std::logic_error);
+	BOOST_CHECK(md5.finish() == hash);
+}
+
+BOOST_AUTO_TEST_CASE(checkHashKeepsDigest)
+{
+	const std::string hex = "90ebef7754cd9e4441622f39f10c63d3";
+	Md5Hash hash(hex);
+	BOOST_CHECK_EQUAL(sizeof(Md5Hash), 16u);
+	BOOST_CHECK_EQUAL(hash.getHash(), hex);
+	BOOST_CHECK_EQUAL(hash.getDigest()[0], 0x90);
+	BOOST_CHECK(Md5Hash::fromDigest(hash.getDigest()) == hash);
+	BOOST_CHECK(Md5Hash("90ebef7754cd9e4441622f39f10c63d4") != hash);
+	BOOST_CHECK(Md5Hash("80ebef7754cd9e4441622f39f10c63d4") < hash);
+
+	std::unordered_set<Md5Hash> hashes = {hash, Md5Hash(hex), Md5Hash()};
+	BOOST_CHECK_EQUAL(hashes.size(), 2u);
+	BOOST_CHECK(hashes.count(Md5Hash(hex)) == 1);
+}
+
 BOOST_AUTO_TEST_CASE(checkNotExistingFile)
 {
 	BOOST_CHECK_THROW(Md5sum("/x"), std::invalid_argument);
@@ -0,0 +1,112 @@
+#include <boost/test/unit_test.hpp>
+#include "CatalogLog.hpp"
+#include "TestFactories.hpp"
+
+using testFactories::makeDescriptor;
+
+namespace {
+    const std::string HASH_A = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+    const std::string HASH_B = "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb";
+    const std::string HASH_C = "cccccccccccccccccccccccccccccccc";
+}
+
+BOOST_AUTO_TEST_SUITE(CatalogLogTests);
+
+BOOST_AUTO_TEST_CASE(onlyLastChangesAfterVersionAreReturned)
+{
+    CatalogLog log(16, 7);
+    log.put(makeDescriptor("a.txt", HASH_A));
+    CatalogLog::Version seen = log.getVersion();
+    BOOST_TEST(seen.epoch == 7u);
+    BOOST_TEST(seen.sequence == 1u);
+
+    FileDescriptor discarded = makeDescriptor("b.txt", HASH_B);
+    log.put(discarded);
+    discarded.makeUnvalid();
+    log.put(discarded);
+    log.put(makeDescriptor("c.txt", HASH_C));
+    log.remove(makeDescriptor("c.txt", HASH_C));
+    log.remove(makeDescriptor("a.txt", HASH_A));
+
+    std::vector<FileDescriptor> put, removed;
+    BOOST_TEST(log.getChangesSince(seen, put, removed));
+    BOOST_TEST(put.size() == 1u);
+    BOOST_TEST(!put.front().isValid());
+    BOOST_TEST(removed.size() == 2u);
+
+    put.clear();
+    removed.clear();
+    BOOST_TEST(log.getChangesSince(log.getVersion(), put, removed));
+    BOOST_TEST(put.empty());
+    BOOST_TEST(removed.empty());
+}
+
+BOOST_AUTO_TEST_CASE(unknownVersionsNeedFullCatalog)
+{
+    CatalogLog log(2, 7);
+    std::vector<FileDescriptor> put, removed;
+    BOOST_TEST(log.getChangesSince(CatalogLog::Version{7, 0}, put, removed));
+
+    log.put(makeDescriptor("a.txt", HASH_A));
+    log.put(makeDescriptor("b.txt", HASH_B));
+    log.put(makeDescriptor("c.txt", HASH_C));
+    // other epoch - restarted node
+    BOOST_TEST(!log.getChangesSince(CatalogLog::Version{8, 3}, put, removed));
+    // from the future
+    BOOST_TEST(!log.getChangesSince(CatalogLog::Version{7, 4}, put, removed));
+    // first change is no longer kept
+    BOOST_TEST(!log.getChangesSince(CatalogLog::Version{7, 0}, put, removed));
+    BOOST_TEST(log.getChangesSince(CatalogLog::Version{7, 1}, put, removed));
+    BOOST_TEST(put.size() == 2u);
+}
+
+BOOST_AUTO_TEST_CASE(epochsOfLogsDiffer)
+{
+    BOOST_TEST(CatalogLog().getVersion().epoch != CatalogLog().getVersion().epoch);
+    BOOST_TEST(CatalogLog().getVersion().epoch != 0u);
+}
+
+BOOST_AUTO_TEST_CASE(restoredLogKeepsVersionAndChanges)
+{
+    CatalogLog log(16, 7);
+    log.put(makeDescriptor("a.txt", HASH_A));
+    log.put(makeDescriptor("b.txt", HASH_B));
+    log.remove(makeDescriptor("a.txt", HASH_A));
+    std::vector<uint8_t> encoded;
+    log.encode(encoded);
+
+    CatalogLog restored;
+    const uint8_t *position = encoded.data();
+    BOOST_TEST(restored.decode(position, encoded.data() + encoded.size()));
+    BOOST_TEST(position == encoded.data() + encoded.size());
+    BOOST_TEST(restored.getVersion().epoch == 7u);
+    BOOST_TEST(restored.getVersion().sequence == 3u);
+    std::vector<FileDescriptor> put, removed;
+    BOOST_TEST(restored.getChangesSince(CatalogLog::Version{7, 1}, put, removed));
+    BOOST_TEST(put.size() == 1u);
+    BOOST_TEST(removed.size() == 1u);
+
+    // truncated log leaves the restored one as it was
+    position = encoded.data();
+    BOOST_TEST(!restored.decode(position, encoded.data() + encoded.size() - 1));
+    BOOST_TEST(position == encoded.data());
+    BOOST_TEST(restored.getVersion().sequence == 3u);
+}
+
+BOOST_AUTO_TEST_CASE(digestFollowsStateNotOrder)
+{
+    FileDescriptor a = makeDescriptor("a.txt", HASH_A);
+    FileDescriptor b = makeDescriptor("b.txt", HASH_B);
+    uint64_t digest = CatalogLog::digest({a, b});
+    BOOST_TEST(digest == CatalogLog::digest({b, a}));
+    BOOST_TEST(digest != CatalogLog::digest({a}));
+
+    b.makeUnvalid();
+    BOOST_TEST(digest != CatalogLog::digest({a, b}));
+    b.makeValid();
+    b.setHolderIp(2);
+    BOOST_TEST(digest != CatalogLog::digest({a, b}));
+    BOOST_TEST(CatalogLog::digest(std::vector<FileDescriptor>()) == 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
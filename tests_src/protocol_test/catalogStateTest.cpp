@@ -0,0 +1,52 @@
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include "CatalogState.hpp"
+#include "TestFactories.hpp"
+
+using testFactories::makeDescriptor;
+
+namespace {
+    const std::string STATE_FILE = "catalogStateTest.state";
+}
+
+BOOST_AUTO_TEST_SUITE(CatalogStateTests);
+
+BOOST_AUTO_TEST_CASE(savedStateIsLoadedBack)
+{
+    CatalogState state;
+    state.log = CatalogLog(16, 7);
+    state.log.put(makeDescriptor("a.txt", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", 1));
+    state.peerVersions[2] = CatalogLog::Version{11, 5};
+    state.peerCatalogs[2] = {makeDescriptor("b.txt", "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb", 2),
+                             makeDescriptor("c.txt", "cccccccccccccccccccccccccccccccc", 2)};
+    state.peerVersions[3] = CatalogLog::Version{13, 0};
+    BOOST_TEST(state.save(STATE_FILE));
+
+    CatalogState loaded;
+    BOOST_TEST(loaded.load(STATE_FILE));
+    BOOST_TEST(loaded.log.getVersion().epoch == 7u);
+    BOOST_TEST(loaded.log.getVersion().sequence == 1u);
+    BOOST_TEST(loaded.peerVersions.size() == 2u);
+    BOOST_TEST(loaded.peerVersions[2].epoch == 11u);
+    BOOST_TEST(loaded.peerVersions[2].sequence == 5u);
+    BOOST_TEST(loaded.peerCatalogs[2].size() == 2u);
+    BOOST_TEST(loaded.peerCatalogs[2].front().getHolderIp() == 2u);
+    BOOST_TEST(loaded.peerCatalogs[3].empty());
+    remove(STATE_FILE.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(missingOrMalformedStateChangesNothing)
+{
+    CatalogState state;
+    state.log = CatalogLog(16, 7);
+    BOOST_TEST(!state.load(STATE_FILE));
+
+    FILE *file = fopen(STATE_FILE.c_str(), "w");
+    fputs("garbage", file);
+    fclose(file);
+    BOOST_TEST(!state.load(STATE_FILE));
+    BOOST_TEST(state.log.getVersion().epoch == 7u);
+    remove(STATE_FILE.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END();
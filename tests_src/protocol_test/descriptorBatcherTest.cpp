@@ -0,0 +1,59 @@
+#include <boost/test/unit_test.hpp>
+#include <unistd.h>
+#include <vector>
+
+#include "DescriptorBatcher.hpp"
+//____________________________________________________________________________//
+
+BOOST_AUTO_TEST_SUITE(DescriptorBatcherTests);
+
+struct PublishedBatches {
+    Mutex mutex;
+    std::vector<size_t> sizes;
+
+    DescriptorBatcher::Publisher publisher() {
+        return [this](std::vector<FileDescriptor> &&batch) {
+            Guard guard(mutex);
+            sizes.push_back(batch.size());
+        };
+    }
+};
+
+BOOST_AUTO_TEST_CASE(fullBatchesArePublishedWithoutWaiting)
+{
+    PublishedBatches published;
+    DescriptorBatcher batcher(published.publisher(), 3, 10000);
+
+    for (int i = 0; i < 6; ++i) {
+        batcher.add(FileDescriptor());
+    }
+    usleep(50000);
+
+    Guard guard(published.mutex);
+    BOOST_TEST(published.sizes == std::vector<size_t>({3, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(incompleteBatchIsPublishedAfterLinger)
+{
+    PublishedBatches published;
+    DescriptorBatcher batcher(published.publisher(), 10, 30);
+
+    batcher.add(FileDescriptor());
+    batcher.add(FileDescriptor());
+    usleep(100000);
+
+    Guard guard(published.mutex);
+    BOOST_TEST(published.sizes == std::vector<size_t>({2}));
+}
+
+BOOST_AUTO_TEST_CASE(queuedDescriptorsArePublishedOnDestruction)
+{
+    PublishedBatches published;
+    {
+        DescriptorBatcher batcher(published.publisher(), 10, 10000);
+        batcher.add(FileDescriptor());
+    }
+    BOOST_TEST(published.sizes == std::vector<size_t>({1}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
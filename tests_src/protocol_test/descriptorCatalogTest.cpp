@@ -0,0 +1,68 @@
+#include <boost/test/unit_test.hpp>
+#include <arpa/inet.h>
+#include "DescriptorCatalog.hpp"
+#include "TestFactories.hpp"
+
+using testFactories::makeDescriptor;
+
+namespace {
+    const std::string HASH_A = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+    const std::string HASH_B = "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb";
+    const std::string HASH_C = "cccccccccccccccccccccccccccccccc";
+}
+
+BOOST_AUTO_TEST_SUITE(DescriptorCatalogTests);
+
+BOOST_AUTO_TEST_CASE(descriptorsAreUniqueByDigest)
+{
+    DescriptorCatalog catalog;
+    BOOST_TEST(catalog.insert(makeDescriptor("a.txt", HASH_A, inet_addr("10.0.0.1"))));
+    BOOST_TEST(!catalog.insert(makeDescriptor("other.txt", HASH_A, inet_addr("10.0.0.2"))));
+    BOOST_TEST(catalog.size() == 1u);
+    BOOST_TEST(catalog.find(Md5Hash(HASH_A))->getName() == "a.txt");
+    BOOST_TEST(catalog.find(Md5Hash(HASH_B)) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(indexesFollowChanges)
+{
+    DescriptorCatalog catalog;
+    catalog.insert(makeDescriptor("a.txt", HASH_A, inet_addr("10.0.0.1")));
+    catalog.insert(makeDescriptor("a.txt", HASH_B, inet_addr("10.0.0.1")));
+    catalog.insert(makeDescriptor("c.txt", HASH_C, inet_addr("10.0.0.2")));
+    BOOST_TEST(catalog.countByName("a.txt") == 2u);
+    BOOST_TEST(catalog.findByHolder(inet_addr("10.0.0.1")).size() == 2u);
+
+    // file moved to the other node
+    catalog.upsert(makeDescriptor("a.txt", HASH_A, inet_addr("10.0.0.2")));
+    BOOST_TEST(catalog.size() == 3u);
+    BOOST_TEST(catalog.findByHolder(inet_addr("10.0.0.1")).size() == 1u);
+    BOOST_TEST(catalog.findByHolder(inet_addr("10.0.0.2")).size() == 2u);
+
+    // first descriptor is replaced by the last one
+    BOOST_TEST(catalog.erase(Md5Hash(HASH_A)));
+    BOOST_TEST(!catalog.erase(Md5Hash(HASH_A)));
+    BOOST_TEST(catalog.countByName("a.txt") == 1u);
+    BOOST_TEST(catalog.find(Md5Hash(HASH_C))->getName() == "c.txt");
+    BOOST_TEST(catalog.find(Md5Hash(HASH_B))->getName() == "a.txt");
+}
+
+BOOST_AUTO_TEST_CASE(holderOperations)
+{
+    DescriptorCatalog catalog;
+    catalog.insert(makeDescriptor("a.txt", HASH_A, inet_addr("10.0.0.1")));
+    catalog.insert(makeDescriptor("b.txt", HASH_B, inet_addr("10.0.0.1")));
+    catalog.insert(makeDescriptor("c.txt", HASH_C, inet_addr("10.0.0.2")));
+
+    BOOST_TEST(catalog.invalidateHolder(inet_addr("10.0.0.1")) == 2u);
+    BOOST_TEST(!catalog.find(Md5Hash(HASH_A))->isValid());
+    BOOST_TEST(catalog.find(Md5Hash(HASH_C))->isValid());
+    BOOST_TEST(catalog.setValid(Md5Hash(HASH_A), true));
+    BOOST_TEST(catalog.find(Md5Hash(HASH_A))->isValid());
+
+    BOOST_TEST(catalog.eraseHolder(inet_addr("10.0.0.1")) == 2u);
+    BOOST_TEST(catalog.size() == 1u);
+    BOOST_TEST(catalog.countByName("a.txt") == 0u);
+    BOOST_TEST(catalog.begin()->getName() == "c.txt");
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,138 @@
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <unistd.h>
+
+#include "DrainJob.hpp"
+#include "Thread.hpp"
+#include "Guard.hpp"
+#include "TestFactories.hpp"
+//____________________________________________________________________________//
+
+namespace {
+    std::vector<RebalancePlanner::Move> makeMoves(unsigned count, in_addr_t target) {
+        std::vector<RebalancePlanner::Move> moves;
+        for (unsigned i = 0; i < count; ++i) {
+            moves.push_back({testFactories::makeHash(i), 100, target});
+        }
+        return moves;
+    }
+
+    // confirms the transfers from another thread, as UPDATE_DESCRIPTOR handlers do
+    struct Confirmer {
+        DrainJob &job;
+        Mutex mutex;
+        std::vector<RebalancePlanner::Move> sent;
+        std::atomic<bool> stopping;
+        std::atomic<size_t> maxInFlight;
+        std::atomic<size_t> inFlight;
+
+        explicit Confirmer(DrainJob &drainJob) : job(drainJob), stopping(false), maxInFlight(0), inFlight(0) {
+        }
+
+        void send(const RebalancePlanner::Move &move) {
+            Guard guard(mutex);
+            sent.push_back(move);
+            maxInFlight = std::max<size_t>(maxInFlight, ++inFlight);
+        }
+
+        static void *run(void *confirmer) {
+            Confirmer &self = *(Confirmer *) confirmer;
+            while (!self.stopping) {
+                usleep(1000);
+                Guard guard(self.mutex);
+                for (auto &&move : self.sent) {
+                    // node 2 never answers
+                    if (move.target != 2) {
+                        --self.inFlight;
+                        self.job.confirm(move.hash);
+                    }
+                }
+                self.sent.clear();
+            }
+            return NULL;
+        }
+    };
+}
+
+BOOST_AUTO_TEST_SUITE(DrainJobTests);
+
+BOOST_AUTO_TEST_CASE(transfersRunInParallelUpToLimit)
+{
+    DrainJob job(makeMoves(50, 1), 4, 1000, 1000000);
+    Confirmer confirmer(job);
+    Thread thread(&Confirmer::run, &confirmer, NULL);
+
+    size_t reports = 0;
+    DrainJob::Progress progress = job.run([&confirmer](const RebalancePlanner::Move &move) {
+        confirmer.send(move);
+    }, [](const RebalancePlanner::Move &) {
+        return (in_addr_t) INADDR_NONE;
+    }, [&reports](const DrainJob::Progress &) {
+        ++reports;
+    }, 10000);
+    confirmer.stopping = true;
+    thread.get();
+
+    BOOST_TEST(progress.confirmedFiles == 50u);
+    BOOST_TEST(progress.confirmedBytes == 5000u);
+    BOOST_TEST(progress.failedFiles == 0u);
+    BOOST_TEST(confirmer.maxInFlight <= 4u);
+    BOOST_TEST(confirmer.maxInFlight > 1u);
+    // only the final report
+    BOOST_TEST(reports == 1u);
+}
+
+BOOST_AUTO_TEST_CASE(unconfirmedTransfersGoElsewhere)
+{
+    // node 2 does not answer, node 3 leaves during the drain
+    std::vector<RebalancePlanner::Move> moves = makeMoves(11, 2);
+    moves.back().target = 3;
+    DrainJob job(moves, 20, 50, 1000000);
+    Confirmer confirmer(job);
+    Thread thread(&Confirmer::run, &confirmer, NULL);
+
+    std::map<in_addr_t, int> sentTo;
+    auto start = std::chrono::steady_clock::now();
+    DrainJob::Progress progress = job.run([&](const RebalancePlanner::Move &move) {
+        ++sentTo[move.target];
+        if (move.target == 3) {
+            job.failNode(3);
+        } else {
+            confirmer.send(move);
+        }
+    }, [](const RebalancePlanner::Move &) {
+        return (in_addr_t) 1;
+    }, [](const DrainJob::Progress &) {
+    }, 10000);
+    confirmer.stopping = true;
+    thread.get();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    BOOST_TEST(progress.confirmedFiles == 11u);
+    BOOST_TEST(sentTo[2] == 10);
+    BOOST_TEST(sentTo[3] == 1);
+    BOOST_TEST(sentTo[1] == 11);
+    // one timeout, not one per file
+    BOOST_TEST(elapsed.count() < 1.0);
+}
+
+BOOST_AUTO_TEST_CASE(filesAreGivenUpAfterAttempts)
+{
+    DrainJob job(makeMoves(3, 2), 8, 10, 1000000);
+    int sent = 0;
+    DrainJob::Progress progress = job.run([&sent](const RebalancePlanner::Move &) {
+        ++sent;
+    }, [](const RebalancePlanner::Move &move) {
+        return move.target;
+    }, [](const DrainJob::Progress &) {
+    }, 10000);
+
+    BOOST_TEST(progress.failedFiles == 3u);
+    BOOST_TEST(progress.confirmedFiles == 0u);
+    BOOST_TEST(sent == 3 * (int) DrainJob::MAX_ATTEMPTS);
+    BOOST_TEST(!job.confirm(makeMoves(1, 2).front().hash));
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,88 @@
+#include <boost/test/unit_test.hpp>
+#include "MerkleTree.hpp"
+#include "TestFactories.hpp"
+
+namespace {
+    std::vector<FileDescriptor> makeDescriptors(unsigned count) {
+        std::vector<FileDescriptor> descriptors;
+        for (unsigned i = 0; i < count; ++i) {
+            descriptors.push_back(testFactories::makeDescriptor(i));
+        }
+        return descriptors;
+    }
+
+    // descends the trees as two nodes exchanging SYNC_HASHES do; returns different leaves
+    std::vector<size_t> findDifferentLeaves(const MerkleTree &first, const MerkleTree &second, size_t &sentHashes) {
+        std::vector<size_t> compared{MerkleTree::ROOT}, leaves;
+        sentHashes = 0;
+        while (!compared.empty()) {
+            sentHashes += compared.size();
+            std::vector<size_t> next;
+            for (size_t node : compared) {
+                if (first.getHash(node) == second.getHash(node)) {
+                    continue;
+                }
+                if (MerkleTree::isLeaf(node)) {
+                    leaves.push_back(node);
+                    continue;
+                }
+                auto descendants = MerkleTree::getDescendants(node, 4);
+                next.insert(next.end(), descendants.begin(), descendants.end());
+            }
+            compared.swap(next);
+        }
+        return leaves;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(MerkleTreeTests);
+
+BOOST_AUTO_TEST_CASE(sameDescriptorsGiveSameTree)
+{
+    auto descriptors = makeDescriptors(1000);
+    MerkleTree tree(descriptors);
+    std::reverse(descriptors.begin(), descriptors.end());
+    BOOST_TEST(MerkleTree(descriptors).getHash(MerkleTree::ROOT) == tree.getHash(MerkleTree::ROOT));
+    BOOST_TEST(MerkleTree().getHash(MerkleTree::ROOT) == 0u);
+    BOOST_TEST(tree.getHash(MerkleTree::ROOT) != 0u);
+}
+
+BOOST_AUTO_TEST_CASE(differencesAreFoundInTheirLeaves)
+{
+    auto descriptors = makeDescriptors(10000);
+    MerkleTree full(descriptors);
+
+    auto changed = descriptors;
+    changed[17].makeUnvalid();
+    changed.erase(changed.begin() + 4000);
+    MerkleTree other(changed);
+
+    size_t sentHashes;
+    std::vector<size_t> leaves = findDifferentLeaves(full, other, sentHashes);
+    std::vector<size_t> expected{MerkleTree::getLeaf(descriptors[17].getMd5()),
+                                 MerkleTree::getLeaf(descriptors[4000].getMd5())};
+    std::sort(leaves.begin(), leaves.end());
+    std::sort(expected.begin(), expected.end());
+    BOOST_TEST(leaves == expected);
+    // a root and three levels of 16 hashes per difference, not the whole catalog
+    BOOST_TEST(sentHashes <= 1 + 3 * 16 * 2u);
+
+    findDifferentLeaves(full, MerkleTree(descriptors), sentHashes);
+    BOOST_TEST(sentHashes == 1u);
+}
+
+BOOST_AUTO_TEST_CASE(descendantsStopAtLeaves)
+{
+    BOOST_TEST(MerkleTree::getDescendants(MerkleTree::ROOT, 4).size() == 16u);
+    BOOST_TEST(MerkleTree::getDescendants(MerkleTree::ROOT, 4).front() == 16u);
+    size_t aboveLeaves = MerkleTree::LEAVES / 4;
+    BOOST_TEST(MerkleTree::getDescendants(aboveLeaves, 4).size() == 4u);
+    BOOST_TEST(MerkleTree::isLeaf(MerkleTree::getDescendants(aboveLeaves, 4).front()));
+    BOOST_TEST(MerkleTree::getDescendants(MerkleTree::LEAVES, 4).size() == 1u);
+
+    BOOST_TEST(MerkleTree::isLeaf(MerkleTree::getLeaf(Md5Hash("00000000000000000000000000000000"))));
+    BOOST_TEST(MerkleTree::isLeaf(MerkleTree::getLeaf(Md5Hash("ffffffffffffffffffffffffffffffff"))));
+    BOOST_TEST(!MerkleTree::isNode(2 * MerkleTree::LEAVES));
+}
+
+BOOST_AUTO_TEST_SUITE_END();
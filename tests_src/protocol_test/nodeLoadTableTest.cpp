@@ -0,0 +1,64 @@
+#include <boost/test/unit_test.hpp>
+#include <stdexcept>
+#include "NodeLoadTable.hpp"
+#include "DescriptorCatalog.hpp"
+
+BOOST_AUTO_TEST_SUITE(NodeLoadTableTests);
+
+BOOST_AUTO_TEST_CASE(leastLoadedNodeFollowsFiles)
+{
+    NodeLoadTable loads;
+    BOOST_CHECK_THROW(loads.findLeastLoaded(), std::logic_error);
+
+    loads.addNode(1);
+    loads.addNode(2);
+    loads.addFile(1, 100);
+    loads.addFile(2, 300);
+    BOOST_TEST(loads.findLeastLoaded() == 1u);
+    BOOST_TEST(loads.findLeastLoadedExcept(1) == 2u);
+
+    loads.addFile(1, 250);
+    BOOST_TEST(loads.findLeastLoaded() == 2u);
+    BOOST_TEST(loads.getLoad(1).bytes == 350u);
+    BOOST_TEST(loads.getLoad(1).files == 2u);
+    BOOST_TEST(loads.getTotalBytes() == 650u);
+
+    loads.removeFile(1, 250);
+    BOOST_TEST(loads.findLeastLoaded() == 1u);
+}
+
+BOOST_AUTO_TEST_CASE(nodesStayWhileRegisteredOrHoldingFiles)
+{
+    NodeLoadTable loads;
+    loads.addNode(1);
+    // holder which has not said HELLO yet
+    loads.addFile(2, 10);
+    BOOST_TEST(loads.size() == 2u);
+
+    loads.removeNode(1);
+    BOOST_TEST(!loads.contains(1));
+    loads.removeFile(2, 10);
+    BOOST_TEST(!loads.contains(2));
+    BOOST_TEST(loads.empty());
+    BOOST_CHECK_THROW(loads.findLeastLoadedExcept(3), std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(catalogUpdatesLoads)
+{
+    DescriptorCatalog catalog;
+    FileDescriptor descriptor("a.txt", Md5Hash("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"), 100);
+    descriptor.setHolderIp(1);
+    catalog.insert(descriptor);
+    BOOST_TEST(catalog.getLoads().getLoad(1).bytes == 100u);
+
+    // file moved to the other node
+    descriptor.setHolderIp(2);
+    catalog.upsert(descriptor);
+    BOOST_TEST(!catalog.getLoads().contains(1));
+    BOOST_TEST(catalog.getLoads().getLoad(2).files == 1u);
+
+    catalog.erase(descriptor.getMd5());
+    BOOST_TEST(catalog.getLoads().empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,69 @@
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include "PendingOperations.hpp"
+
+BOOST_AUTO_TEST_SUITE(PendingOperationsTests);
+
+BOOST_AUTO_TEST_CASE(operationCompletesWithItsAnswer)
+{
+    PendingOperations operations(1000, 1000000);
+    Md5Hash file("0123456789abcdef0123456789abcdef");
+    Md5Hash other("fedcba9876543210fedcba9876543210");
+
+    int callbacks = 0;
+    PendingOperations::Future get = operations.add(MessageType::GET_FILE, file, 1, 100,
+                                                   [&callbacks](const PendingOperations::Result &) {
+                                                       ++callbacks;
+                                                   });
+    PendingOperations::Future secondGet = operations.add(MessageType::GET_FILE, file, 1, 100);
+    PendingOperations::Future upload = operations.add(MessageType::UPLOAD_FILE, file, 1, 100);
+    BOOST_TEST(operations.size() == 3u);
+
+    // answers of other requests or files
+    BOOST_TEST(operations.complete(MessageType::DELETE_FILE, file, PendingOperations::Status::COMPLETED) == 0u);
+    BOOST_TEST(operations.complete(MessageType::GET_FILE, other, PendingOperations::Status::COMPLETED) == 0u);
+    BOOST_TEST((get.wait_for(std::chrono::seconds(0)) == std::future_status::timeout));
+
+    BOOST_TEST(operations.complete(MessageType::GET_FILE, file, PendingOperations::Status::COMPLETED) == 2u);
+    BOOST_TEST(get.get().succeeded());
+    BOOST_TEST(secondGet.get().succeeded());
+    BOOST_TEST(callbacks == 1);
+    BOOST_TEST((get.get().elapsed >= PendingOperations::Clock::duration::zero()));
+
+    operations.complete(MessageType::UPLOAD_FILE, file, PendingOperations::Status::REFUSED, "file's hash differ");
+    BOOST_TEST((upload.get().status == PendingOperations::Status::REFUSED));
+    BOOST_TEST(upload.get().message == "file's hash differ");
+    BOOST_TEST(operations.size() == 0u);
+
+    PendingOperations::Future unknown = PendingOperations::finished(PendingOperations::Status::FAILED,
+                                                                    "file does not exist");
+    BOOST_TEST(!unknown.get().succeeded());
+}
+
+BOOST_AUTO_TEST_CASE(unansweredOperationsFail)
+{
+    // 1 byte per second: the size lengthens the deadline
+    PendingOperations operations(1000, 1);
+    Md5Hash file("0123456789abcdef0123456789abcdef");
+    auto now = PendingOperations::Clock::now();
+
+    PendingOperations::Future small = operations.add(MessageType::GET_FILE, file, 1, 0, nullptr, now);
+    PendingOperations::Future large = operations.add(MessageType::UPLOAD_FILE, file, 1, 10, nullptr, now);
+    PendingOperations::Future elsewhere = operations.add(MessageType::DELETE_FILE, file, 2, 0, nullptr, now);
+
+    BOOST_TEST(operations.expire(now + std::chrono::milliseconds(999)) == 0u);
+    BOOST_TEST(operations.expire(now + std::chrono::seconds(2)) == 2u);
+    BOOST_TEST((small.get().status == PendingOperations::Status::TIMED_OUT));
+    BOOST_TEST((elsewhere.get().status == PendingOperations::Status::TIMED_OUT));
+
+    BOOST_TEST(operations.failNode(2) == 0u);
+    BOOST_TEST(operations.failNode(1) == 1u);
+    BOOST_TEST((large.get().status == PendingOperations::Status::NODE_LOST));
+
+    PendingOperations::Future pending = operations.add(MessageType::GET_FILE, file, 1, 0);
+    operations.cancelAll();
+    BOOST_TEST((pending.get().status == PendingOperations::Status::CANCELLED));
+    BOOST_TEST(operations.size() == 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
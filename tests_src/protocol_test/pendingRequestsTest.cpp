@@ -0,0 +1,85 @@
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include "PendingRequests.hpp"
+
+BOOST_AUTO_TEST_SUITE(PendingRequestsTests);
+
+BOOST_AUTO_TEST_CASE(requestCompletesWhenAllNodesAcknowledge)
+{
+    PendingRequests requests(1000);
+    PendingRequests::Future future;
+    uint32_t id = requests.add({1, 2}, future);
+    BOOST_TEST(id != 0u);
+    BOOST_TEST(requests.size() == 1u);
+
+    BOOST_TEST(requests.acknowledge(id, 1));
+    // duplicated ACK and ACK of some other node
+    BOOST_TEST(!requests.acknowledge(id, 1));
+    BOOST_TEST(!requests.acknowledge(id, 3));
+    BOOST_TEST((future.wait_for(std::chrono::seconds(0)) == std::future_status::timeout));
+
+    BOOST_TEST(requests.acknowledge(id, 2));
+    BOOST_TEST(future.get());
+    BOOST_TEST(requests.size() == 0u);
+
+    // nobody to wait for
+    PendingRequests::Future done;
+    uint32_t otherId = requests.add({}, done);
+    BOOST_TEST(otherId != id);
+    BOOST_TEST(PendingRequests::waitAll({future, done}, 0));
+}
+
+BOOST_AUTO_TEST_CASE(lostNodeFailsItsRequests)
+{
+    PendingRequests requests(1000);
+    PendingRequests::Future first, second, third;
+    requests.add({1, 2}, first);
+    uint32_t secondId = requests.add({2}, second);
+    requests.add({3}, third);
+
+    requests.failNode(2);
+    BOOST_TEST(!first.get());
+    BOOST_TEST(!second.get());
+    BOOST_TEST(!requests.acknowledge(secondId, 2));
+    BOOST_TEST(requests.size() == 1u);
+
+    // waiting ends with the time given, not with the request
+    auto start = std::chrono::steady_clock::now();
+    BOOST_TEST(!PendingRequests::waitAll({third}, 50));
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    BOOST_TEST(elapsed.count() < 1.0);
+
+    requests.cancelAll();
+    BOOST_TEST(!third.get());
+    BOOST_TEST(requests.size() == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(continuationRunsOnceRequestCompletes)
+{
+    PendingRequests requests(1000);
+    auto now = PendingRequests::Clock::now();
+    std::vector<bool> completions;
+    auto continuation = [&completions](bool acknowledged) {
+        completions.push_back(acknowledged);
+    };
+
+    PendingRequests::Future acknowledged, expired;
+    uint32_t id = requests.add({1}, acknowledged, continuation, now);
+    requests.add({2}, expired, continuation, now);
+    BOOST_TEST(completions.empty());
+
+    requests.acknowledge(id, 1);
+    BOOST_TEST(completions.size() == 1u);
+    BOOST_TEST(completions.back());
+
+    // unanswered request ends with its timeout
+    requests.expire(now + std::chrono::milliseconds(999));
+    BOOST_TEST(requests.size() == 1u);
+    requests.expire(now + std::chrono::milliseconds(1000));
+    BOOST_TEST(completions.size() == 2u);
+    BOOST_TEST(!completions.back());
+    BOOST_TEST(!expired.get());
+    BOOST_TEST(requests.size() == 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,37 @@
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <chrono>
+#include <unistd.h>
+
+#include "PeriodicTask.hpp"
+//____________________________________________________________________________//
+
+BOOST_AUTO_TEST_SUITE(PeriodicTaskTests);
+
+BOOST_AUTO_TEST_CASE(taskRunsEveryPeriodUntilDestroyed)
+{
+    std::atomic<int> runs(0);
+    {
+        PeriodicTask task([&runs]() { ++runs; }, 20);
+        usleep(10000);
+        BOOST_TEST(runs == 0);
+        usleep(100000);
+    }
+    int runsAfterStop = runs;
+    BOOST_TEST(runsAfterStop >= 3);
+    BOOST_TEST(runsAfterStop <= 6);
+    usleep(50000);
+    BOOST_TEST(runs == runsAfterStop);
+}
+
+BOOST_AUTO_TEST_CASE(destructorDoesNotWaitForNextPeriod)
+{
+    auto start = std::chrono::steady_clock::now();
+    {
+        PeriodicTask task([]() {}, 10000);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    BOOST_TEST(elapsed.count() < 1.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,67 @@
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <map>
+#include "PlacementReservations.hpp"
+#include "TestFactories.hpp"
+
+using testFactories::makeHash;
+
+BOOST_AUTO_TEST_SUITE(PlacementReservationsTests);
+
+BOOST_AUTO_TEST_CASE(reservationsSpreadConcurrentUploads)
+{
+    NodeLoadTable loads;
+    PlacementReservations reservations(loads, 1000);
+    for (in_addr_t node = 1; node <= 4; ++node) {
+        loads.addNode(node);
+    }
+
+    // eight uploads started before any of them is published: two per node
+    std::map<in_addr_t, int> chosen;
+    for (unsigned i = 0; i < 8; ++i) {
+        in_addr_t node = loads.findLeastLoaded();
+        reservations.reserve(makeHash(i), node, 100);
+        ++chosen[node];
+    }
+    for (in_addr_t node = 1; node <= 4; ++node) {
+        BOOST_TEST(chosen[node] == 2);
+        BOOST_TEST(loads.getLoad(node).reserved == 200u);
+    }
+    // reserved bytes are not stored yet
+    BOOST_TEST(loads.getTotalBytes() == 0u);
+
+    // published file counts into the load instead of its reservation
+    BOOST_TEST(reservations.release(makeHash(0)));
+    BOOST_TEST(!reservations.release(makeHash(0)));
+    loads.addFile(1, 100);
+    BOOST_TEST(loads.getLoad(1).reserved == 100u);
+    BOOST_TEST(loads.getLoad(1).bytes == 100u);
+    BOOST_TEST(reservations.size() == 7u);
+}
+
+BOOST_AUTO_TEST_CASE(reservationsEndWithNodeOrTime)
+{
+    typedef PlacementReservations::Clock Clock;
+    NodeLoadTable loads;
+    PlacementReservations reservations(loads, 1000);
+    Clock::time_point start = Clock::now();
+
+    reservations.reserve(makeHash(1), 1, 100, start);
+    reservations.reserve(makeHash(2), 2, 100, start);
+    reservations.reserve(makeHash(3), 2, 100, start + std::chrono::milliseconds(500));
+    // the same upload reserved again replaces the old reservation
+    reservations.reserve(makeHash(1), 2, 50, start + std::chrono::milliseconds(500));
+    BOOST_TEST(!loads.contains(1));
+    BOOST_TEST(loads.getLoad(2).reserved == 250u);
+
+    reservations.expire(start + std::chrono::milliseconds(1200));
+    BOOST_TEST(reservations.size() == 2u);
+    BOOST_TEST(loads.getLoad(2).reserved == 150u);
+
+    // nodes which are not members stay in the table only while something is reserved on them
+    reservations.releaseNode(2);
+    BOOST_TEST(reservations.size() == 0u);
+    BOOST_TEST(loads.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,105 @@
+#include <boost/test/unit_test.hpp>
+#include <map>
+#include <stdexcept>
+#include <vector>
+#include "PlacementStrategy.hpp"
+#include "TestFactories.hpp"
+
+namespace {
+    std::vector<Md5Hash> makeHashes(unsigned count) {
+        std::vector<Md5Hash> hashes;
+        for (unsigned i = 0; i < count; ++i) {
+            hashes.push_back(testFactories::makeHash(i));
+        }
+        return hashes;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(PlacementStrategyTests);
+
+BOOST_AUTO_TEST_CASE(rendezvousChoiceDependsOnlyOnMembers)
+{
+    RendezvousPlacement first, second;
+    BOOST_CHECK_THROW(first.choose(Md5Hash()), std::logic_error);
+
+    // same members added in a different order
+    for (in_addr_t node = 1; node <= 5; ++node) {
+        first.addNode(node, 1);
+        second.addNode(6 - node, 1);
+    }
+    for (auto &&hash : makeHashes(1000)) {
+        in_addr_t chosen = first.choose(hash);
+        BOOST_TEST(chosen == second.choose(hash));
+        BOOST_TEST(first.choose(hash, chosen) != chosen);
+    }
+
+    RendezvousPlacement single;
+    single.addNode(1, 1);
+    BOOST_CHECK_THROW(single.choose(Md5Hash(), 1), std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(joinAndLeaveMoveOnlyTheirShare)
+{
+    const unsigned count = 20000;
+    auto hashes = makeHashes(count);
+    RendezvousPlacement placement;
+    for (in_addr_t node = 1; node <= 4; ++node) {
+        placement.addNode(node, 1);
+    }
+    std::vector<in_addr_t> before;
+    for (auto &&hash : hashes) {
+        before.push_back(placement.choose(hash));
+    }
+
+    placement.addNode(5, 1);
+    unsigned moved = 0;
+    for (unsigned i = 0; i < count; ++i) {
+        in_addr_t after = placement.choose(hashes[i]);
+        if (after != before[i]) {
+            // files move only to the newcomer
+            BOOST_TEST(after == 5u);
+            ++moved;
+        }
+    }
+    BOOST_TEST(moved > count / 5 * 0.9);
+    BOOST_TEST(moved < count / 5 * 1.1);
+
+    placement.removeNode(5);
+    placement.removeNode(2);
+    for (unsigned i = 0; i < count; ++i) {
+        in_addr_t after = placement.choose(hashes[i]);
+        if (before[i] != 2) {
+            BOOST_TEST(after == before[i]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(weightsSkewShares)
+{
+    const unsigned count = 20000;
+    RendezvousPlacement placement;
+    placement.addNode(1, 1);
+    placement.addNode(2, 3);
+    std::map<in_addr_t, unsigned> shares;
+    for (auto &&hash : makeHashes(count)) {
+        ++shares[placement.choose(hash)];
+    }
+    BOOST_TEST(shares[2] > count * 0.7);
+    BOOST_TEST(shares[2] < count * 0.8);
+}
+
+BOOST_AUTO_TEST_CASE(leastLoadedFollowsLoads)
+{
+    NodeLoadTable loads;
+    LeastLoadedPlacement placement(loads);
+    BOOST_TEST(!placement.isDeterministic());
+    BOOST_CHECK_THROW(placement.choose(Md5Hash()), std::logic_error);
+
+    loads.addNode(1);
+    loads.addNode(2);
+    loads.addFile(1, 100);
+    BOOST_TEST(placement.choose(Md5Hash()) == 2u);
+    BOOST_TEST(placement.choose(Md5Hash(), 2) == 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -25,4 +25,36 @@ BOOST_AUTO_TEST_CASE(hello_and_helloreply)
 {
 }
 
+BOOST_AUTO_TEST_CASE(connection_lost_removes_lost_node)
+{
+    using namespace p2p::util;
+    tcpServer = std::make_shared<TcpServer>(&processTcpMsg, &processTcpError);
+    auto rendezvous = std::make_shared<RendezvousPlacement>();
+    placement = rendezvous;
+    initProcessingFunctions();
+
+    in_addr_t reporter = inet_addr("10.0.0.1");
+    in_addr_t lost = inet_addr("10.0.0.2");
+    {
+        Guard guard(mutex);
+        addNodeAddress(reporter);
+        addNodeAddress(lost);
+    }
+
+    msgProcessors.at(MessageType::CONNECTION_LOST)((const uint8_t *) &lost, sizeof lost, reporter);
+
+    auto loads = networkDescriptors.getLoads().getLoads();
+    BOOST_TEST(loads.count(lost) == 0u);
+    BOOST_TEST(loads.count(reporter) == 1u);
+    BOOST_TEST(rendezvous->size() == 1u);
+    BOOST_TEST(rendezvous->choose(Md5Hash("0123456789abcdef0123456789abcdef")) == reporter);
+
+    {
+        Guard guard(mutex);
+        removeNodeAddress(reporter);
+    }
+    placement.reset();
+    tcpServer.reset();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
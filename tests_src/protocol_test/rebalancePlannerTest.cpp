@@ -0,0 +1,114 @@
+#include <boost/test/unit_test.hpp>
+#include <map>
+#include "RebalancePlanner.hpp"
+#include "TestFactories.hpp"
+
+namespace {
+    std::vector<FileDescriptor> makeFiles(const std::vector<uint32_t> &sizes, in_addr_t holder) {
+        std::vector<FileDescriptor> files;
+        for (unsigned i = 0; i < sizes.size(); ++i) {
+            // files of different nodes have different digests
+            Md5Hash hash = testFactories::makeHash(i, holder);
+            files.push_back(testFactories::makeDescriptor("file" + std::to_string(i), hash, holder, sizes[i]));
+        }
+        return files;
+    }
+
+    std::unordered_map<in_addr_t, NodeLoadTable::NodeLoad> makeLoads(
+            const std::map<in_addr_t, std::vector<FileDescriptor>> &filesByNode) {
+        std::unordered_map<in_addr_t, NodeLoadTable::NodeLoad> loads;
+        for (auto &&node : filesByNode) {
+            NodeLoadTable::NodeLoad load{0, 0, 0};
+            for (auto &&file : node.second) {
+                load.bytes += file.getSize();
+                ++load.files;
+            }
+            loads[node.first] = load;
+        }
+        return loads;
+    }
+
+    uint64_t sumSizes(const std::vector<RebalancePlanner::Move> &moves) {
+        uint64_t sum = 0;
+        for (auto &&move : moves) {
+            sum += move.size;
+        }
+        return sum;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(RebalancePlannerTests);
+
+BOOST_AUTO_TEST_CASE(reductionCountsBothNodes)
+{
+    // fits both: imbalance drops by twice the size
+    BOOST_TEST(RebalancePlanner::getReduction(100, 100, 40) == 80);
+    // overshoots the excess
+    BOOST_TEST(RebalancePlanner::getReduction(100, 300, 150) == 200);
+    // makes things worse
+    BOOST_TEST(RebalancePlanner::getReduction(10, 10, 100) < 0);
+}
+
+BOOST_AUTO_TEST_CASE(excessIsPackedCloselyIntoNewcomer)
+{
+    std::map<in_addr_t, std::vector<FileDescriptor>> files;
+    // 1000 bytes on the old node, newcomer is empty: 500 should move
+    files[1] = makeFiles({300, 260, 240, 100, 60, 40}, 1);
+    files[2] = {};
+    auto moves = RebalancePlanner::plan(1, files[1], makeLoads(files));
+
+    BOOST_TEST(sumSizes(moves) == 500u);
+    for (auto &&move : moves) {
+        BOOST_TEST(move.target == 2u);
+    }
+    // larger files first
+    BOOST_TEST(moves.front().size == 300u);
+
+    // nothing to move from an underloaded node or with no other nodes
+    BOOST_TEST(RebalancePlanner::plan(2, files[2], makeLoads(files)).empty());
+    files.erase(2);
+    BOOST_TEST(RebalancePlanner::plan(1, files[1], makeLoads(files)).empty());
+}
+
+BOOST_AUTO_TEST_CASE(overloadedNodesShareDeficitsInsteadOfFloodingNewcomer)
+{
+    std::map<in_addr_t, std::vector<FileDescriptor>> files;
+    files[1] = makeFiles(std::vector<uint32_t>(30, 10), 1);
+    files[2] = makeFiles(std::vector<uint32_t>(30, 10), 2);
+    files[3] = makeFiles(std::vector<uint32_t>(10, 10), 3);
+    files[4] = {};
+    // average 175: nodes 1 and 2 have 125 bytes too many each, node 3 misses 75 and node 4 - 175
+    auto loads = makeLoads(files);
+
+    std::map<in_addr_t, uint64_t> received;
+    for (in_addr_t node = 1; node <= 4; ++node) {
+        for (auto &&move : RebalancePlanner::plan(node, files[node], loads)) {
+            BOOST_TEST(move.target != node);
+            received[move.target] += move.size;
+        }
+    }
+    BOOST_TEST(received[1] == 0u);
+    BOOST_TEST(received[2] == 0u);
+    BOOST_TEST(received[3] >= 60u);
+    BOOST_TEST(received[3] <= 90u);
+    BOOST_TEST(received[4] >= 160u);
+    BOOST_TEST(received[4] <= 190u);
+}
+
+BOOST_AUTO_TEST_CASE(movesCostingMoreThanTheyBalanceAreSkipped)
+{
+    std::map<in_addr_t, std::vector<FileDescriptor>> files;
+    // excess 50: a 60-byte file overshoots a little but still helps
+    files[1] = makeFiles({1000, 60}, 1);
+    files[2] = makeFiles({960}, 2);
+    auto moves = RebalancePlanner::plan(1, files[1], makeLoads(files));
+    BOOST_TEST(moves.size() == 1u);
+    BOOST_TEST(moves.front().size == 60u);
+
+    // 90 bytes moved would reduce the imbalance by 20 only
+    files[1] = makeFiles({1000, 90}, 1);
+    files[2] = makeFiles({990}, 2);
+    BOOST_TEST(RebalancePlanner::plan(1, files[1], makeLoads(files)).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END();
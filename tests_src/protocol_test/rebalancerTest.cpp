@@ -0,0 +1,68 @@
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <chrono>
+#include <unistd.h>
+
+#include "Rebalancer.hpp"
+//____________________________________________________________________________//
+
+BOOST_AUTO_TEST_SUITE(RebalancerTests);
+
+BOOST_AUTO_TEST_CASE(bucketLetsBurstThroughThenKeepsRate)
+{
+    typedef TokenBucket::Clock Clock;
+    Clock::time_point start = Clock::now();
+    TokenBucket bucket(1000, 1000);
+
+    BOOST_TEST(bucket.take(600, start).count() == 0);
+    // 200 bytes of debt take 0.2 s to pay off
+    std::chrono::duration<double> wait = bucket.take(600, start);
+    BOOST_TEST(wait.count() == 0.2, boost::test_tools::tolerance(1e-6));
+
+    // idle time refills no more than the burst
+    BOOST_TEST(bucket.take(1000, start + std::chrono::seconds(10)).count() == 0);
+    wait = bucket.take(500, start + std::chrono::seconds(10));
+    BOOST_TEST(wait.count() == 0.5, boost::test_tools::tolerance(1e-6));
+}
+
+BOOST_AUTO_TEST_CASE(movesAreThrottled)
+{
+    std::atomic<uint64_t> movedBytes(0);
+    Rebalancer rebalancer([&movedBytes](const RebalancePlanner::Move &move) {
+        movedBytes += move.size;
+        return true;
+    }, 100000);
+
+    // burst of 100 kB goes at once, then 100 kB/s
+    rebalancer.schedule(std::vector<RebalancePlanner::Move>(10, RebalancePlanner::Move{Md5Hash(), 50000, 1}));
+    usleep(50000);
+    BOOST_TEST(movedBytes <= 150000u);
+    usleep(500000);
+    BOOST_TEST(movedBytes >= 150000u);
+    BOOST_TEST(movedBytes <= 250000u);
+    BOOST_TEST(rebalancer.getPendingMoves() > 0u);
+
+    // new plan replaces the moves not started yet
+    rebalancer.schedule({});
+    BOOST_TEST(rebalancer.getPendingMoves() == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(skippedMovesCostNoBandwidth)
+{
+    std::atomic<int> attempts(0);
+    auto start = std::chrono::steady_clock::now();
+    {
+        Rebalancer rebalancer([&attempts](const RebalancePlanner::Move &) {
+            ++attempts;
+            return false;
+        }, 1000);
+        rebalancer.schedule(std::vector<RebalancePlanner::Move>(5, RebalancePlanner::Move{Md5Hash(), 100000, 1}));
+        usleep(50000);
+        BOOST_TEST(attempts == 5);
+    }
+    // destructor does not wait for the bucket
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    BOOST_TEST(elapsed.count() < 1.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,119 @@
+#include <boost/test/unit_test.hpp>
+#include "ShardedCatalog.hpp"
+#include "Thread.hpp"
+#include "TestFactories.hpp"
+
+using namespace testFactories;
+
+namespace {
+    struct WriterArgs {
+        ShardedCatalog *catalog;
+        unsigned first;
+        unsigned count;
+    };
+
+    void *insertDescriptors(void *arguments) {
+        WriterArgs *args = (WriterArgs *) arguments;
+        for (unsigned i = args->first; i < args->first + args->count; ++i) {
+            args->catalog->insert(makeDescriptor(i, args->first));
+        }
+        return nullptr;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(ShardedCatalogTests);
+
+BOOST_AUTO_TEST_CASE(operationsReachTheShardOfTheDigest)
+{
+    ShardedCatalog catalog;
+    for (unsigned i = 0; i < 100; ++i) {
+        BOOST_TEST(catalog.insert(makeDescriptor(i, 1)));
+    }
+    BOOST_TEST(!catalog.insert(makeDescriptor(7, 2)));
+    BOOST_TEST(catalog.size() == 100u);
+
+    FileDescriptor found;
+    BOOST_TEST(catalog.find(makeHash(7), found));
+    BOOST_TEST(found.getHolderIp() == 1u);
+    BOOST_TEST(catalog.setValid(makeHash(7), false));
+    BOOST_TEST(catalog.find(makeHash(7), found));
+    BOOST_TEST(!found.isValid());
+
+    BOOST_TEST(catalog.erase(makeHash(7)));
+    BOOST_TEST(!catalog.contains(makeHash(7)));
+    BOOST_TEST(catalog.findByName("file8").size() == 1u);
+    BOOST_TEST(catalog.findByHolder(1).size() == 99u);
+    BOOST_TEST(catalog.eraseHolder(1) == 99u);
+    BOOST_TEST(catalog.empty());
+}
+
+BOOST_AUTO_TEST_CASE(loadsOfAllShardsAreShared)
+{
+    ShardedCatalog catalog;
+    catalog.getLoads().addNode(3);
+    for (unsigned i = 0; i < 50; ++i) {
+        catalog.insert(makeDescriptor(i, 2));
+    }
+    BOOST_TEST(catalog.getLoads().getLoad(2).files == 50u);
+    BOOST_TEST(catalog.getLoads().getLoad(2).bytes == 5000u);
+    BOOST_TEST(catalog.getLoads().findLeastLoaded() == 3u);
+
+    catalog.invalidateHolder(2);
+    BOOST_TEST(catalog.getLoads().getLoad(2).files == 50u);
+    catalog.eraseHolder(2);
+    BOOST_TEST(catalog.getLoads().getAverageLoad() == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(snapshotIsNotAffectedByLaterChanges)
+{
+    ShardedCatalog catalog;
+    for (unsigned i = 0; i < 20; ++i) {
+        catalog.insert(makeDescriptor(i, 1));
+    }
+    ShardedCatalog::Snapshot snapshot = catalog.getSnapshot();
+    catalog.eraseHolder(1);
+    catalog.insert(makeDescriptor(100, 1));
+
+    BOOST_TEST(snapshot.size() == 20u);
+    BOOST_TEST(snapshot.toVector().size() == 20u);
+    BOOST_TEST(catalog.getSnapshot().size() == 1u);
+}
+
+BOOST_AUTO_TEST_CASE(readersDoNotWaitForTheWriter)
+{
+    ShardedCatalog catalog;
+    catalog.insert(makeDescriptor(1, 1));
+    // the shard is locked here; readers get the last published version of it
+    catalog.withShard(makeHash(1), [&catalog](DescriptorCatalog &shard) {
+        shard.erase(makeHash(1));
+        BOOST_TEST(catalog.getSnapshot().size() == 1u);
+    });
+    BOOST_TEST(catalog.getSnapshot().size() == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(concurrentWritersDoNotLoseDescriptors)
+{
+    ShardedCatalog catalog;
+    const unsigned writers = 4, perWriter = 2000;
+    WriterArgs args[writers];
+    void *retval;
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (unsigned i = 0; i < writers; ++i) {
+        args[i] = WriterArgs{&catalog, i * perWriter, perWriter};
+        threads.emplace_back(new Thread(insertDescriptors, &args[i], &retval));
+    }
+    // readers are served meanwhile
+    size_t lastSize = 0;
+    for (int i = 0; i < 100; ++i) {
+        size_t size = catalog.getSnapshot().size();
+        BOOST_TEST(size >= lastSize);
+        lastSize = size;
+    }
+    for (auto &&thread : threads) {
+        thread->get();
+    }
+    BOOST_TEST(catalog.size() == writers * perWriter);
+    BOOST_TEST(catalog.getLoads().getTotalBytes() == writers * perWriter * 100u);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -324,4 +324,15 @@ BOOST_AUTO_TEST_CASE(checkMultipleRecipientsGetExpectedResponses)
     }
 }
 
+BOOST_AUTO_TEST_CASE(localhostIpIsCached)
+{
+    in_addr_t address = Server::getLocalhostIp();
+    BOOST_TEST(address != INADDR_NONE);
+    BOOST_TEST(Server::getLocalhostIp() == address);
+
+    // nothing has changed, so resolving again gives the same address
+    Server::refreshLocalhostIp();
+    BOOST_TEST(Server::getLocalhostIp() == address);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
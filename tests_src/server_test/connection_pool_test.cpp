@@ -0,0 +1,119 @@
+#include <boost/test/unit_test.hpp>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstdio>
+#include <vector>
+
+#include "TcpConnectionPool.hpp"
+//____________________________________________________________________________//
+
+BOOST_AUTO_TEST_SUITE(ConnectionPoolTests)
+
+const int POOL_TEST_PORT = 3334;
+
+struct ListeningSocket
+{
+    int sock;
+
+    ListeningSocket()
+    {
+        sockaddr_in addr;
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(POOL_TEST_PORT);
+        addr.sin_addr.s_addr = INADDR_ANY;
+
+        sock = socket(AF_INET, SOCK_STREAM, 0);
+        int enable = 1;
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof enable);
+        bind(sock, (sockaddr*) &addr, sizeof addr);
+        listen(sock, 10);
+    }
+
+    int acceptConnection()
+    {
+        return accept(sock, NULL, NULL);
+    }
+
+    ~ListeningSocket()
+    {
+        close(sock);
+    }
+};
+
+static std::vector<uint8_t> receiveExactly(int sock, size_t size)
+{
+    std::vector<uint8_t> data(size);
+    recv(sock, data.data(), size, MSG_WAITALL);
+    return data;
+}
+
+BOOST_AUTO_TEST_CASE(checkPoolReusesConnection)
+{
+    ListeningSocket listener;
+    TcpConnectionPool pool(POOL_TEST_PORT);
+
+    std::vector<uint8_t> first = { 1, 2, 3, 4 };
+    std::vector<uint8_t> second = { 5, 6, 7 };
+    BOOST_TEST(pool.send(first.data(), first.size(), inet_addr("127.0.0.1")) == SocketOperation::Status::Success);
+    BOOST_TEST(pool.send(second.data(), second.size(), inet_addr("127.0.0.1")) == SocketOperation::Status::Success);
+
+    int conn = listener.acceptConnection();
+    BOOST_TEST(receiveExactly(conn, first.size()) == first);
+    BOOST_TEST(receiveExactly(conn, second.size()) == second);
+    close(conn);
+}
+
+BOOST_AUTO_TEST_CASE(checkPoolReconnectsAfterPeerClosed)
+{
+    ListeningSocket listener;
+    TcpConnectionPool pool(POOL_TEST_PORT);
+
+    std::vector<uint8_t> data = { 1, 2, 3, 4 };
+    BOOST_TEST(pool.send(data.data(), data.size(), inet_addr("127.0.0.1")) == SocketOperation::Status::Success);
+    int conn = listener.acceptConnection();
+    BOOST_TEST(receiveExactly(conn, data.size()) == data);
+    close(conn);
+    usleep(10000);
+
+    BOOST_TEST(pool.send(data.data(), data.size(), inet_addr("127.0.0.1")) == SocketOperation::Status::Success);
+    conn = listener.acceptConnection();
+    BOOST_TEST(receiveExactly(conn, data.size()) == data);
+    close(conn);
+}
+
+BOOST_AUTO_TEST_CASE(checkPoolSendsHeadFollowedByFile)
+{
+    ListeningSocket listener;
+    TcpConnectionPool pool(POOL_TEST_PORT);
+
+    char filename[] = "poolSendFileXXXXXX";
+    int fileFd = mkstemp(filename);
+    std::vector<uint8_t> fileContent(100000);
+    for (size_t i = 0; i < fileContent.size(); ++i)
+    {
+        fileContent[i] = rand() % 256;
+    }
+    BOOST_REQUIRE(write(fileFd, fileContent.data(), fileContent.size()) == (ssize_t) fileContent.size());
+
+    std::vector<uint8_t> head = { 9, 8, 7 };
+    const off_t offset = 1000;
+    BOOST_TEST(pool.sendFile(head.data(), head.size(), fileFd, offset, fileContent.size() - offset,
+                             inet_addr("127.0.0.1")) == SocketOperation::Status::Success);
+    close(fileFd);
+    unlink(filename);
+
+    int conn = listener.acceptConnection();
+    BOOST_TEST(receiveExactly(conn, head.size()) == head);
+    BOOST_TEST((receiveExactly(conn, fileContent.size() - offset)
+                == std::vector<uint8_t>(fileContent.begin() + offset, fileContent.end())));
+    close(conn);
+}
+
+BOOST_AUTO_TEST_CASE(checkPoolReportsCantConnect)
+{
+    TcpConnectionPool pool(POOL_TEST_PORT);
+    std::vector<uint8_t> data = { 1, 2, 3, 4 };
+    BOOST_TEST(pool.send(data.data(), data.size(), inet_addr("127.0.0.1")) == SocketOperation::Status::CantConnect);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
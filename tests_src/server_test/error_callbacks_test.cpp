@@ -1,4 +1,6 @@
 #include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <string>
 
 #include "P2PMessage.hpp"
 #include "TcpServer.hpp"
@@ -24,9 +26,23 @@ struct Config
         operation = s;
         return;
     }
+
+    static std::atomic<int> missingFiles;
+    static std::string missingFile;
+
+    static void missingFileCallback(MessageType messageType, const std::string& filename, in_addr_t toWhom)
+    {
+        if (messageType == MessageType::FILE_TRANSFER && toWhom == inet_addr("127.0.0.1"))
+        {
+            missingFile = filename;
+            ++missingFiles;
+        }
+    }
 };
 
 SocketOperation Config::operation;
+std::atomic<int> Config::missingFiles(0);
+std::string Config::missingFile;
 
 BOOST_TEST_GLOBAL_FIXTURE( Config );
 
@@ -72,4 +88,21 @@ BOOST_AUTO_TEST_CASE(checkReceiveFailCallback)
     delete[] data;
 }
 
+BOOST_AUTO_TEST_CASE(checkMissingFileCallback)
+{
+    TcpServer server(&Config::tcpResolveCallback, &Config::errorCallback);
+    server.setMissingFileCallback(&Config::missingFileCallback);
+
+    MessageBuilder message(MessageType::FILE_TRANSFER);
+    message.add(uint64_t(0)).attachFile("no_such_file_in_the_store");
+    server.sendMessage(std::move(message), inet_addr("127.0.0.1"));
+    for (int i = 0; i < 100 && Config::missingFiles == 0; ++i)
+    {
+        usleep(10000);
+    }
+
+    BOOST_TEST(Config::missingFiles == 1);
+    BOOST_TEST(Config::missingFile == "no_such_file_in_the_store");
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,135 @@
+#include <boost/test/unit_test.hpp>
+#include <unistd.h>
+#include <vector>
+
+#include "P2PMessage.hpp"
+#include "TcpServer.hpp"
+//____________________________________________________________________________//
+
+BOOST_AUTO_TEST_SUITE(EventLoopServerTests)
+
+struct EventLoopConfig
+{
+    static std::vector<std::vector<uint8_t> > receivedFrames;
+    static int errorCallbackCount;
+    static SocketOperation lastError;
+    static Mutex framesMutex;
+
+    static void tcpCollectCallback(uint8_t* x, uint32_t s, SocketOperation op)
+    {
+        framesMutex.lock();
+        receivedFrames.emplace_back(x, x + s);
+        framesMutex.unlock();
+    }
+
+    static void errorCallback(SocketOperation op)
+    {
+        framesMutex.lock();
+        ++errorCallbackCount;
+        lastError = op;
+        framesMutex.unlock();
+    }
+
+    static void reset()
+    {
+        receivedFrames.clear();
+        errorCallbackCount = 0;
+    }
+};
+
+std::vector<std::vector<uint8_t> > EventLoopConfig::receivedFrames;
+int EventLoopConfig::errorCallbackCount = 0;
+SocketOperation EventLoopConfig::lastError;
+Mutex EventLoopConfig::framesMutex;
+
+static std::vector<uint8_t> buildFrame(uint32_t dataSize)
+{
+    P2PMessage msg;
+    msg.setMessageType(MessageType::UPLOAD_FILE);
+    msg.setAdditionalDataSize(dataSize);
+
+    std::vector<uint8_t> frame(sizeof(msg) + dataSize);
+    memcpy(frame.data(), &msg, sizeof(msg));
+    for (size_t i = sizeof(msg); i < frame.size(); ++i)
+    {
+        frame[i] = rand() % 256;
+    }
+    return frame;
+}
+
+static int connectToLocalServer()
+{
+    sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(3333);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    connect(sock, (sockaddr*) &addr, sizeof(addr));
+    return sock;
+}
+
+BOOST_AUTO_TEST_CASE(checkEventLoopServerWorksAtAll)
+{
+    EventLoopConfig::reset();
+    TcpServer server(&EventLoopConfig::tcpCollectCallback, &EventLoopConfig::errorCallback,
+                     TcpServer::Mode::EventLoop, 2);
+    server.startListening();
+
+    std::vector<uint8_t> frame = buildFrame(100000);
+    server.sendData(frame.data(), frame.size(), inet_addr("127.0.0.1"));
+    usleep(200000);
+    server.stopListening();
+
+    BOOST_TEST(EventLoopConfig::errorCallbackCount == 0);
+    BOOST_REQUIRE(EventLoopConfig::receivedFrames.size() == 1);
+    BOOST_TEST(EventLoopConfig::receivedFrames[0] == frame);
+}
+
+BOOST_AUTO_TEST_CASE(checkEventLoopReadsFramesBackToBack)
+{
+    EventLoopConfig::reset();
+    TcpServer server(&EventLoopConfig::tcpCollectCallback, &EventLoopConfig::errorCallback,
+                     TcpServer::Mode::EventLoop, 1);
+    server.startListening();
+
+    std::vector<std::vector<uint8_t> > frames = { buildFrame(10), buildFrame(0), buildFrame(5000) };
+    std::vector<uint8_t> stream;
+    for (auto &&frame : frames)
+    {
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    // send the stream in small pieces, splitting headers as well
+    int sock = connectToLocalServer();
+    for (size_t sent = 0; sent < stream.size(); sent += 3)
+    {
+        send(sock, stream.data() + sent, std::min<size_t>(3, stream.size() - sent), 0);
+    }
+    usleep(100000);
+    close(sock);
+    usleep(100000);
+    server.stopListening();
+
+    BOOST_TEST(EventLoopConfig::errorCallbackCount == 0);
+    BOOST_TEST(EventLoopConfig::receivedFrames == frames);
+}
+
+BOOST_AUTO_TEST_CASE(checkEventLoopReportsTruncatedFrame)
+{
+    EventLoopConfig::reset();
+    TcpServer server(&EventLoopConfig::tcpCollectCallback, &EventLoopConfig::errorCallback,
+                     TcpServer::Mode::EventLoop, 1);
+    server.startListening();
+
+    std::vector<uint8_t> frame = buildFrame(50000);
+    server.sendData(frame.data(), 50, inet_addr("127.0.0.1"));
+    usleep(200000);
+    server.stopListening();
+
+    BOOST_TEST(EventLoopConfig::receivedFrames.empty());
+    BOOST_TEST(EventLoopConfig::errorCallbackCount == 1);
+    BOOST_TEST(EventLoopConfig::lastError.status == SocketOperation::Status::ReceiveFailed);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,83 @@
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <vector>
+
+#include "MessageBuilder.hpp"
+//____________________________________________________________________________//
+
+BOOST_AUTO_TEST_SUITE(MessageBuilderTests)
+
+static std::vector<uint8_t> joinSegments(const MessageBuilder& message)
+{
+    std::vector<uint8_t> bytes;
+    for (auto &&segment : message.getSegments())
+    {
+        bytes.insert(bytes.end(), (uint8_t*) segment.iov_base, (uint8_t*) segment.iov_base + segment.iov_len);
+    }
+    return bytes;
+}
+
+BOOST_AUTO_TEST_CASE(checkSegmentsMakeTheFrame)
+{
+    uint32_t address = 0x01020304;
+    std::vector<uint8_t> payload = { 1, 2, 3, 4, 5 };
+    const uint8_t* payloadData = payload.data();
+
+    MessageBuilder message(MessageType::CMD_REFUSED);
+    message.add(address).add("ab", 3).addPayload(std::move(payload));
+
+    P2PMessage header;
+    header.setMessageType(MessageType::CMD_REFUSED);
+    header.setAdditionalDataSize(sizeof(address) + 3 + 5);
+    std::vector<uint8_t> expected((uint8_t*) &header, (uint8_t*) &header + sizeof(header));
+    expected.insert(expected.end(), (uint8_t*) &address, (uint8_t*) &address + sizeof(address));
+    expected.insert(expected.end(), { 'a', 'b', 0, 1, 2, 3, 4, 5 });
+
+    BOOST_TEST(message.isCompleteFrame());
+    BOOST_TEST(message.getSize() == expected.size());
+    BOOST_TEST(joinSegments(message) == expected);
+
+    // small parts share one segment, payload is not copied
+    std::vector<iovec> segments = message.getSegments();
+    BOOST_REQUIRE(segments.size() == 2);
+    BOOST_TEST(segments[1].iov_base == (void*) payloadData);
+}
+
+BOOST_AUTO_TEST_CASE(checkMovedMessageKeepsSegments)
+{
+    MessageBuilder message(MessageType::HELLO_REPLY);
+    message.addPayload(std::vector<uint32_t>(100, 7));
+    std::vector<uint8_t> bytes = joinSegments(message);
+
+    MessageBuilder moved(std::move(message));
+    BOOST_TEST(joinSegments(moved) == bytes);
+    BOOST_TEST(moved.getSize() == sizeof(P2PMessage) + 400);
+}
+
+BOOST_AUTO_TEST_CASE(checkRequestIdIsInHeader)
+{
+    MessageBuilder message(MessageType::DISCARD_DESCRIPTORS);
+    message.add(uint32_t(7)).setRequestId(42);
+
+    P2PMessage header;
+    std::vector<uint8_t> bytes = joinSegments(message);
+    memcpy(&header, bytes.data(), sizeof header);
+    BOOST_TEST(header.getRequestId() == 42u);
+    BOOST_TEST(header.getAdditionalDataSize() == sizeof(uint32_t));
+    BOOST_TEST(MessageBuilder(MessageType::ACK).isCompleteFrame());
+}
+
+BOOST_AUTO_TEST_CASE(checkBytesAreSentAsTheyAre)
+{
+    P2PMessage header;
+    header.setMessageType(MessageType::GET_FILE);
+    header.setAdditionalDataSize(10);
+    std::vector<uint8_t> truncated((uint8_t*) &header, (uint8_t*) &header + sizeof(header));
+    truncated.push_back(1);
+
+    MessageBuilder message = MessageBuilder::fromBytes(truncated.data(), truncated.size());
+    BOOST_TEST(!message.isCompleteFrame());
+    BOOST_TEST(joinSegments(message) == truncated);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
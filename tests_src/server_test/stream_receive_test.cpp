@@ -0,0 +1,140 @@
+#include <boost/test/unit_test.hpp>
+#include <unistd.h>
+#include <vector>
+
+#include "P2PMessage.hpp"
+#include "TcpServer.hpp"
+#include "IncomingStream.hpp"
+//____________________________________________________________________________//
+
+BOOST_AUTO_TEST_SUITE(StreamReceiveTests)
+
+struct StreamConfig
+{
+    static std::vector<uint8_t> streamedData;
+    static uint32_t biggestChunk;
+    static int completedStreams;
+    static int brokenStreams;
+    static int framesCount;
+    static int errorCallbackCount;
+    static Mutex streamMutex;
+
+    struct CollectingStream : public IncomingStream
+    {
+        void consume(const uint8_t* data, uint32_t size) override
+        {
+            Guard guard(streamMutex);
+            streamedData.insert(streamedData.end(), data, data + size);
+            biggestChunk = std::max(biggestChunk, size);
+        }
+
+        void finish(bool complete) override
+        {
+            Guard guard(streamMutex);
+            ++(complete ? completedStreams : brokenStreams);
+        }
+    };
+
+    // only UPLOAD_FILE payloads are streamed
+    static IncomingStream* streamFactory(const P2PMessage& header, in_addr_t sender)
+    {
+        if (header.getMessageType() != MessageType::UPLOAD_FILE)
+        {
+            return nullptr;
+        }
+        return new CollectingStream();
+    }
+
+    static void tcpCallback(uint8_t* x, uint32_t s, SocketOperation op)
+    {
+        Guard guard(streamMutex);
+        ++framesCount;
+    }
+
+    static void errorCallback(SocketOperation op)
+    {
+        Guard guard(streamMutex);
+        ++errorCallbackCount;
+    }
+
+    static void reset()
+    {
+        streamedData.clear();
+        biggestChunk = 0;
+        completedStreams = brokenStreams = framesCount = errorCallbackCount = 0;
+    }
+};
+
+std::vector<uint8_t> StreamConfig::streamedData;
+uint32_t StreamConfig::biggestChunk = 0;
+int StreamConfig::completedStreams = 0;
+int StreamConfig::brokenStreams = 0;
+int StreamConfig::framesCount = 0;
+int StreamConfig::errorCallbackCount = 0;
+Mutex StreamConfig::streamMutex;
+
+static std::vector<uint8_t> buildFrame(MessageType type, uint32_t dataSize)
+{
+    P2PMessage msg;
+    msg.setMessageType(type);
+    msg.setAdditionalDataSize(dataSize);
+
+    std::vector<uint8_t> frame(sizeof(msg) + dataSize);
+    memcpy(frame.data(), &msg, sizeof(msg));
+    for (size_t i = sizeof(msg); i < frame.size(); ++i)
+    {
+        frame[i] = rand() % 256;
+    }
+    return frame;
+}
+
+static void checkPayloadIsStreamed(TcpServer::Mode mode)
+{
+    StreamConfig::reset();
+    TcpServer server(&StreamConfig::tcpCallback, &StreamConfig::errorCallback, mode);
+    server.setStreamFactory(&StreamConfig::streamFactory);
+    server.startListening();
+
+    std::vector<uint8_t> file = buildFrame(MessageType::UPLOAD_FILE, 1024 * 1024);
+    std::vector<uint8_t> other = buildFrame(MessageType::GET_FILE, 100);
+    server.sendData(file.data(), file.size(), inet_addr("127.0.0.1"));
+    server.sendData(other.data(), other.size(), inet_addr("127.0.0.1"));
+    usleep(300000);
+    server.stopListening();
+
+    BOOST_TEST(StreamConfig::errorCallbackCount == 0);
+    BOOST_TEST(StreamConfig::completedStreams == 1);
+    BOOST_TEST(StreamConfig::brokenStreams == 0);
+    BOOST_TEST(StreamConfig::framesCount == 1);
+    BOOST_TEST(StreamConfig::biggestChunk <= STREAM_CHUNK_SIZE);
+    BOOST_TEST((StreamConfig::streamedData == std::vector<uint8_t>(file.begin() + sizeof(P2PMessage), file.end())));
+}
+
+BOOST_AUTO_TEST_CASE(checkThreadPerConnectionStreamsPayload)
+{
+    checkPayloadIsStreamed(TcpServer::Mode::ThreadPerConnection);
+}
+
+BOOST_AUTO_TEST_CASE(checkEventLoopStreamsPayload)
+{
+    checkPayloadIsStreamed(TcpServer::Mode::EventLoop);
+}
+
+BOOST_AUTO_TEST_CASE(checkTruncatedStreamIsNotCompleted)
+{
+    StreamConfig::reset();
+    TcpServer server(&StreamConfig::tcpCallback, &StreamConfig::errorCallback, TcpServer::Mode::EventLoop, 1);
+    server.setStreamFactory(&StreamConfig::streamFactory);
+    server.startListening();
+
+    std::vector<uint8_t> file = buildFrame(MessageType::UPLOAD_FILE, 200000);
+    server.sendData(file.data(), 100000, inet_addr("127.0.0.1"));
+    usleep(200000);
+    server.stopListening();
+
+    BOOST_TEST(StreamConfig::completedStreams == 0);
+    BOOST_TEST(StreamConfig::brokenStreams == 1);
+    BOOST_TEST(StreamConfig::errorCallbackCount == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
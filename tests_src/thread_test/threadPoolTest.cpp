@@ -0,0 +1,78 @@
+#define BOOST_TEST_NO_LIB
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <set>
+#include <unistd.h>
+#include "ThreadPool.hpp"
+
+BOOST_AUTO_TEST_SUITE(ThreadPoolTest);
+
+struct PoolCounters {
+	std::atomic<int> executed{0};
+	Mutex threadsMutex;
+	std::set<pthread_t> threads;
+};
+
+void* countingTask(void* arg)
+{
+	PoolCounters* counters = (PoolCounters*) arg;
+	usleep(1000);
+	counters->threadsMutex.lock();
+	counters->threads.insert(pthread_self());
+	counters->threadsMutex.unlock();
+	++counters->executed;
+	return NULL;
+}
+
+BOOST_AUTO_TEST_CASE(checkAllTasksExecutedByFixedWorkers)
+{
+	PoolCounters counters;
+	ThreadPool pool(4, 8);
+
+	for (int i = 0; i < 200; ++i) {
+		BOOST_REQUIRE(pool.submit(countingTask, &counters));
+	}
+	pool.shutdown();
+
+	BOOST_TEST(counters.executed.load() == 200);
+	BOOST_TEST(counters.threads.size() <= 4);
+}
+
+BOOST_AUTO_TEST_CASE(checkSubmitAfterShutdownIsRefused)
+{
+	PoolCounters counters;
+	ThreadPool pool(2, 8);
+	pool.shutdown();
+
+	BOOST_TEST(!pool.submit(countingTask, &counters));
+	BOOST_TEST(counters.executed.load() == 0);
+}
+
+struct NestedArgs {
+	ThreadPool* pool;
+	PoolCounters* counters;
+};
+
+void* submittingTask(void* arg)
+{
+	NestedArgs* args = (NestedArgs*) arg;
+	// the queue is full, so the worker has to run these tasks by itself
+	for (int i = 0; i < 10; ++i) {
+		args->pool->submit(countingTask, args->counters);
+	}
+	return NULL;
+}
+
+BOOST_AUTO_TEST_CASE(checkWorkerSubmittingIntoFullQueueDoesNotBlock)
+{
+	PoolCounters counters;
+	ThreadPool pool(1, 1);
+	NestedArgs args = { &pool, &counters };
+
+	BOOST_REQUIRE(pool.submit(submittingTask, &args));
+	pool.shutdown();
+
+	BOOST_TEST(counters.executed.load() == 10);
+}
+
+BOOST_AUTO_TEST_SUITE_END();